@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Benchmarks {
+	///measures the time elapsed since it was created or restarted
+	class BenchmarkTimer {
+	public:
+		typedef std::chrono::high_resolution_clock Clock;
+
+		BenchmarkTimer() :
+			mStart(Clock::now()) {
+
+		}
+
+		void restart() {
+			mStart = Clock::now();
+		}
+
+		double getMilliseconds() const {
+			return std::chrono::duration<double, std::milli>(Clock::now() - mStart).count();
+		}
+
+		double getMicroseconds() const {
+			return std::chrono::duration<double, std::micro>(Clock::now() - mStart).count();
+		}
+
+	private:
+		Clock::time_point mStart;
+	};
+
+	///returns the sample below which a fraction of the samples fall, eg. 0.99 for the 99th percentile
+	inline double percentile(std::vector<double> samples, double fraction) {
+		if (samples.empty()) {
+			return 0;
+		}
+
+		auto index = std::min(samples.size() - 1, (size_t)(fraction * samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+		return samples[index];
+	}
+}
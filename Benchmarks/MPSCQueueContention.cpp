@@ -0,0 +1,106 @@
+#include "dojo_common_header.h"
+
+#include "MPSCQueue.h"
+#include "SPSCQueue.h"
+#include "SpinLock.h"
+#include "range.h"
+
+#include "BenchmarkTimer.h"
+
+#include <iomanip>
+#include <iostream>
+
+using namespace Dojo;
+using namespace Benchmarks;
+
+//measures how fast 1 to 16 producers can push through an MPSCQueue while one consumer drains it, against the
+//spinlock around an SPSCQueue that it replaced
+//usage: MPSCQueueContention [elements per run]
+
+namespace {
+	const uint32_t PRODUCER_COUNTS[] = { 1, 2, 4, 8, 16 };
+	const int RUNS = 5;
+
+	///the old MPSCQueue: the producers take turns on a spinlock
+	template <typename T>
+	class SpinLockQueue {
+	public:
+		template <class... Args>
+		void enqueue(Args&& ... args) {
+			std::lock_guard<SpinLock> lock(mSpinLock);
+			mQueue.enqueue(std::forward<Args>(args)...);
+		}
+
+		template <typename U>
+		bool try_dequeue(U& result) {
+			return mQueue.try_dequeue(result);
+		}
+
+	private:
+		SpinLock mSpinLock;
+		SPSCQueue<T, 512> mQueue;
+	};
+
+	///returns the nanoseconds per element of the fastest run
+	template <class Queue>
+	double measure(uint32_t producerCount, uint32_t elementCount) {
+		auto perProducer = elementCount / producerCount;
+		auto best = std::numeric_limits<double>::max();
+
+		for (int run = 0; run < RUNS; ++run) {
+			Queue queue;
+			std::atomic<uint32_t> started(0);
+
+			std::vector<std::thread> producers;
+			for (auto p : range(producerCount)) {
+				producers.emplace_back([&queue, &started, p, perProducer] {
+					++started;
+					for (auto i : range(perProducer)) {
+						queue.enqueue(p * perProducer + i);
+					}
+				});
+			}
+
+			while (started < producerCount) {
+				std::this_thread::yield();
+			}
+
+			BenchmarkTimer timer;
+			uint32_t received = 0, value;
+			while (received < perProducer * producerCount) {
+				if (queue.try_dequeue(value)) {
+					++received;
+				}
+			}
+			auto elapsed = timer.getMilliseconds();
+
+			for (auto&& producer : producers) {
+				producer.join();
+			}
+
+			best = std::min(best, elapsed * 1000000.0 / received);
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t elementCount = 1 << 19;
+	if (argc > 1) {
+		elementCount = std::max(std::atoi(argv[1]), 16);
+	}
+
+	std::cout << elementCount << " elements per run, best of " << RUNS << ", "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	std::cout << "producers\tspinlock ns/element\tlock-free ns/element" << std::endl;
+
+	for (auto producerCount : PRODUCER_COUNTS) {
+		auto locked = measure<SpinLockQueue<uint32_t>>(producerCount, elementCount);
+		auto lockFree = measure<MPSCQueue<uint32_t>>(producerCount, elementCount);
+
+		std::cout << std::fixed << std::setprecision(1) << producerCount
+			<< "\t\t" << locked << "\t\t\t" << lockFree << std::endl;
+	}
+
+	return 0;
+}
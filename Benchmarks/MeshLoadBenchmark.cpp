@@ -0,0 +1,193 @@
+#include "dojo_common_header.h"
+
+#include "MeshFile.h"
+#include "range.h"
+#include "enum_cast.h"
+
+#include "BenchmarkTimer.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace Dojo;
+using namespace Benchmarks;
+
+//compares loading the legacy .mesh files like Mesh::onLoad used to, reading the file in a buffer and copying the
+//streams out of it, with mapping their v2 conversion through MeshFile
+//usage: MeshLoadBenchmark [legacy .mesh files...], a synthetic corpus is generated when no file is given
+
+namespace {
+	const uint8_t LEGACY_FIELD_COUNT = enum_cast(VertexField::UVMax) + 1;
+	const size_t LEGACY_HEADER_SIZE = 2 + LEGACY_FIELD_COUNT + 2 * sizeof(Vector) + 2 * sizeof(uint32_t);
+
+	const int SYNTHETIC_MESH_COUNT = 32;
+	const uint32_t SYNTHETIC_VERTEX_COUNT = 65536;
+	const uint32_t SYNTHETIC_STRIDE = 32;
+	const int ROUNDS = 5;
+
+	std::vector<uint8_t> readFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		std::vector<uint8_t> bytes((size_t)std::max<std::streamoff>(file.tellg(), 0));
+		file.seekg(0);
+		file.read((char*)bytes.data(), bytes.size());
+		return bytes;
+	}
+
+	void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)bytes.data(), bytes.size());
+	}
+
+	//what reaches glBufferData, summed so that the reads can't be optimized away
+	uint64_t checksum(const uint8_t* data, size_t size) {
+		uint64_t sum = 0;
+		for (size_t i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(word));
+			sum += word;
+		}
+		return sum;
+	}
+
+	std::string makeSyntheticMesh(int index) {
+		std::vector<uint8_t> bytes;
+		auto append = [&](const void* data, size_t size) {
+			bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+
+		uint8_t indexSize = 4, primitiveMode = (uint8_t)PrimitiveMode::TriangleList;
+		append(&indexSize, 1);
+		append(&primitiveMode, 1);
+
+		for (auto i : range(LEGACY_FIELD_COUNT)) {
+			auto field = (VertexField)i;
+			uint8_t enabled = field == VertexField::Position3D or field == VertexField::Normal or field == VertexField::UV0;
+			append(&enabled, 1);
+		}
+
+		Vector max(1, 1, 1), min(0, 0, 0);
+		uint32_t side = 256;
+		uint32_t vertexCount = SYNTHETIC_VERTEX_COUNT, indexCount = (side - 1) * (side - 1) * 6;
+		append(&max, sizeof(max));
+		append(&min, sizeof(min));
+		append(&vertexCount, sizeof(vertexCount));
+		append(&indexCount, sizeof(indexCount));
+
+		for (auto i : range(vertexCount)) {
+			float vertex[SYNTHETIC_STRIDE / sizeof(float)] = {
+				(float)(i % side) / side, (float)(i / side) / side, 0,
+				0, 0, 1,
+				(float)(i % side) / side, (float)(i / side) / side
+			};
+			append(vertex, sizeof(vertex));
+		}
+
+		for (auto y : range(side - 1)) {
+			for (auto x : range(side - 1)) {
+				uint32_t quad[] = {
+					y * side + x, y * side + x + 1, (y + 1) * side + x,
+					(y + 1) * side + x, y * side + x + 1, (y + 1) * side + x + 1
+				};
+				append(quad, sizeof(quad));
+			}
+		}
+
+		auto path = "MeshLoadBenchmark" + std::to_string(index) + ".mesh";
+		writeFile(path, bytes);
+		return path;
+	}
+
+	uint64_t loadLegacy(const std::string& path) {
+		auto bytes = readFile(path);
+		if (bytes.size() < LEGACY_HEADER_SIZE) {
+			return 0;
+		}
+
+		uint32_t vertexCount, indexCount;
+		memcpy(&vertexCount, bytes.data() + LEGACY_HEADER_SIZE - 2 * sizeof(uint32_t), sizeof(vertexCount));
+		memcpy(&indexCount, bytes.data() + LEGACY_HEADER_SIZE - sizeof(uint32_t), sizeof(indexCount));
+
+		auto indexBytes = (size_t)indexCount * bytes[0];
+		auto vertexBytes = bytes.size() - LEGACY_HEADER_SIZE - indexBytes;
+
+		//the old loader kept its own copies of both streams
+		std::vector<uint8_t> vertices(bytes.begin() + LEGACY_HEADER_SIZE, bytes.begin() + LEGACY_HEADER_SIZE + vertexBytes);
+		std::vector<uint8_t> indices(bytes.end() - indexBytes, bytes.end());
+
+		return checksum(vertices.data(), vertices.size()) + checksum(indices.data(), indices.size());
+	}
+
+	uint64_t loadV2(const std::string& path) {
+		MeshFile file(path);
+		if (not file.open()) {
+			return 0;
+		}
+		return checksum(file.getVertexData(), file.getVertexDataSize()) + checksum(file.getIndexData(), file.getIndexDataSize());
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> legacyPaths, v2Paths, generated;
+
+	for (int i = 1; i < argc; ++i) {
+		legacyPaths.push_back(argv[i]);
+	}
+
+	if (legacyPaths.empty()) {
+		for (auto i : range(SYNTHETIC_MESH_COUNT)) {
+			legacyPaths.push_back(makeSyntheticMesh(i));
+		}
+		generated = legacyPaths;
+	}
+
+	size_t totalBytes = 0;
+	for (auto i : range(legacyPaths.size())) {
+		auto legacy = readFile(legacyPaths[i]);
+		std::vector<uint8_t> converted;
+		if (not MeshFile::convertLegacy(legacy.data(), legacy.size(), converted)) {
+			std::cerr << legacyPaths[i] << " is not a legacy mesh" << std::endl;
+			return 1;
+		}
+
+		v2Paths.push_back("MeshLoadBenchmark" + std::to_string(i) + ".v2.mesh");
+		writeFile(v2Paths.back(), converted);
+		generated.push_back(v2Paths.back());
+		totalBytes += legacy.size();
+	}
+
+	std::cout << legacyPaths.size() << " meshes, " << totalBytes / (1024 * 1024) << " MB, best of " << ROUNDS << " rounds with a warm file cache" << std::endl;
+
+	double legacyBest = 1e30, v2Best = 1e30;
+	uint64_t legacySum = 0, v2Sum = 0;
+	for (int round = 0; round < ROUNDS; ++round) {
+		BenchmarkTimer timer;
+		legacySum = 0;
+		for (auto&& path : legacyPaths) {
+			legacySum += loadLegacy(path);
+		}
+		legacyBest = std::min(legacyBest, timer.getMilliseconds());
+
+		timer.restart();
+		v2Sum = 0;
+		for (auto&& path : v2Paths) {
+			v2Sum += loadV2(path);
+		}
+		v2Best = std::min(v2Best, timer.getMilliseconds());
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< "legacy, read and copied: " << legacyBest << " ms\n"
+		<< "v2, mapped:              " << v2Best << " ms\n"
+		<< "speedup:                 " << legacyBest / v2Best << "x" << std::endl;
+
+	for (auto&& path : generated) {
+		std::remove(path.c_str());
+	}
+
+	if (legacySum != v2Sum) {
+		std::cerr << "The two formats loaded different data" << std::endl;
+		return 1;
+	}
+	return 0;
+}
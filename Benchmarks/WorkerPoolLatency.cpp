@@ -0,0 +1,172 @@
+#include "dojo_common_header.h"
+
+#include "WorkerPool.h"
+#include "range.h"
+
+#include "BenchmarkTimer.h"
+
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace Dojo;
+using namespace Benchmarks;
+
+//measures how long the short tasks wait before starting when a few long ones are mixed in, on the work-stealing
+//WorkerPool and on the round-robin scheme it replaced
+//usage: WorkerPoolLatency [worker count]
+
+namespace {
+	const int FRAMES = 200;
+	const int TASKS_PER_FRAME = 256;
+	const double SHORT_TASK_MICROSECONDS = 20;
+	const double LONG_TASK_MICROSECONDS = 4000;
+	///one task out of this many is long
+	const int LONG_TASK_PERIOD = 100;
+
+	void busyWait(double microseconds) {
+		BenchmarkTimer timer;
+		while (timer.getMicroseconds() < microseconds) {}
+	}
+
+	///the scheduling of the old WorkerPool: each task goes to the next worker in turn and waits behind whatever that
+	///worker already has, even if the other workers are idle
+	class RoundRobinPool {
+	public:
+		explicit RoundRobinPool(uint32_t workerCount) :
+			mWorkers(workerCount) {
+			for (auto&& worker : mWorkers) {
+				worker.thread = std::thread([this, &worker] {
+					_run(worker);
+				});
+			}
+		}
+
+		~RoundRobinPool() {
+			for (auto&& worker : mWorkers) {
+				{
+					std::lock_guard<std::mutex> lock(worker.mutex);
+					worker.running = false;
+				}
+				worker.available.notify_one();
+				worker.thread.join();
+			}
+		}
+
+		void queue(std::function<void()> task) {
+			++mPending;
+
+			auto& worker = mWorkers[mNext];
+			mNext = (mNext + 1) % mWorkers.size();
+			{
+				std::lock_guard<std::mutex> lock(worker.mutex);
+				worker.tasks.push_back(std::move(task));
+			}
+			worker.available.notify_one();
+		}
+
+		void sync() {
+			while (mPending > 0) {
+				std::this_thread::yield();
+			}
+		}
+
+	private:
+		struct Worker {
+			std::mutex mutex;
+			std::condition_variable available;
+			std::deque<std::function<void()>> tasks;
+			bool running = true;
+			std::thread thread;
+		};
+
+		std::vector<Worker> mWorkers;
+		size_t mNext = 0;
+		std::atomic<int> mPending{ 0 };
+
+		void _run(Worker& worker) {
+			while (true) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(worker.mutex);
+					worker.available.wait(lock, [&] {
+						return not worker.tasks.empty() or not worker.running;
+					});
+
+					if (worker.tasks.empty()) {
+						return;
+					}
+					task = std::move(worker.tasks.front());
+					worker.tasks.pop_front();
+				}
+
+				task();
+				--mPending;
+			}
+		}
+	};
+
+	///queues the same frames of tasks on a pool and returns how long each short task waited to start, in microseconds
+	template<class Pool>
+	std::vector<double> measureWaits(Pool& pool) {
+		std::vector<double> waits(FRAMES * TASKS_PER_FRAME, -1);
+		std::mt19937 random(1234);
+
+		BenchmarkTimer clock;
+		for (auto frame : range(FRAMES)) {
+			for (auto i : range(TASKS_PER_FRAME)) {
+				auto index = frame * TASKS_PER_FRAME + i;
+				auto isLong = random() % LONG_TASK_PERIOD == 0;
+				auto queued = clock.getMicroseconds();
+
+				pool.queue([&waits, &clock, index, isLong, queued] {
+					if (isLong) {
+						busyWait(LONG_TASK_MICROSECONDS);
+					}
+					else {
+						waits[index] = clock.getMicroseconds() - queued;
+						busyWait(SHORT_TASK_MICROSECONDS);
+					}
+				});
+			}
+
+			pool.sync();
+		}
+
+		//the long tasks aren't measured
+		waits.erase(std::remove(waits.begin(), waits.end(), -1), waits.end());
+		return waits;
+	}
+
+	void printWaits(const char* name, const std::vector<double>& waits) {
+		std::cout << std::fixed << std::setprecision(1) << name
+			<< "\tp50 " << percentile(waits, 0.5)
+			<< "\tp99 " << percentile(waits, 0.99)
+			<< "\tp99.9 " << percentile(waits, 0.999)
+			<< "\tmax " << percentile(waits, 1) << " us" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	if (argc > 1) {
+		workerCount = std::max(std::atoi(argv[1]), 1);
+	}
+
+	std::cout << workerCount << " workers, " << FRAMES << " frames of " << TASKS_PER_FRAME << " tasks, "
+		<< "1 in " << LONG_TASK_PERIOD << " takes " << LONG_TASK_MICROSECONDS << " us instead of " << SHORT_TASK_MICROSECONDS << " us" << std::endl;
+	std::cout << "time from queue() to the start of the short tasks:" << std::endl;
+
+	{
+		RoundRobinPool pool(workerCount);
+		printWaits("round robin  ", measureWaits(pool));
+	}
+
+	{
+		WorkerPool pool(workerCount);
+		printWaits("work stealing", measureWaits(pool));
+	}
+
+	return 0;
+}
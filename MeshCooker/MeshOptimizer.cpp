@@ -0,0 +1,375 @@
+#include "MeshOptimizer.h"
+
+#include "range.h"
+
+#include <array>
+#include <unordered_map>
+
+using namespace Dojo;
+
+namespace {
+	//the tuning values from Forsyth's article
+	const uint32_t FORSYTH_CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	const uint32_t NO_TRIANGLE = 0xffffffff;
+
+	float vertexScore(int cachePosition, uint32_t remainingTriangles) {
+		//nothing left to draw with this vertex
+		if (remainingTriangles == 0) {
+			return -1.f;
+		}
+
+		float score = 0;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				//the vertices of the last triangle get a fixed score, so that the next triangle doesn't just reuse them
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				auto scale = 1.f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+			}
+		}
+
+		//prefer the vertices with few triangles left, so that they leave the cache for good
+		score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	uint32_t countCacheMisses(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+		//a vertex is in the FIFO if less than cacheSize vertices entered after it
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		uint32_t misses = 0;
+
+		for (auto&& index : indices) {
+			if (time - timestamps[index] > cacheSize) {
+				timestamps[index] = time++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+}
+
+void Cooker::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+	DEBUG_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+
+	auto triangleCount = (uint32_t)(indices.size() / 3);
+	if (triangleCount == 0) {
+		return;
+	}
+
+	//build the list of the triangles that use each vertex
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (auto&& index : indices) {
+		++remaining[index];
+	}
+
+	std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+	for (auto v : range(vertexCount)) {
+		adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		auto fill = adjacencyStart;
+		for (auto t : range(triangleCount)) {
+			for (auto k : range(3)) {
+				adjacency[fill[indices[t * 3 + k]]++] = t;
+			}
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (auto v : range(vertexCount)) {
+		vertexScores[v] = vertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+
+	uint32_t best = 0;
+	for (auto t : range(triangleCount)) {
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+		if (triangleScores[t] > triangleScores[best]) {
+			best = t;
+		}
+	}
+
+	//the cache has room for the vertices of the triangle being added before the oldest ones are evicted
+	std::vector<uint32_t> cache, nextCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t scanStart = 0;
+
+	while (output.size() < indices.size()) {
+		if (best == NO_TRIANGLE) {
+			//nothing in the cache leads anywhere, start again from any triangle left
+			while (emitted[scanStart]) {
+				++scanStart;
+			}
+			best = scanStart;
+		}
+
+		auto triangle = indices.data() + best * 3;
+		emitted[best] = true;
+		output.insert(output.end(), triangle, triangle + 3);
+
+		nextCache.clear();
+		for (auto k : range(3)) {
+			auto v = triangle[k];
+
+			//remove the triangle from the ones left for this vertex
+			auto begin = adjacency.begin() + adjacencyStart[v];
+			auto end = begin + remaining[v];
+			auto found = std::find(begin, end, best);
+			*found = *(end - 1);
+			--remaining[v];
+
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+				nextCache.push_back(v);
+			}
+		}
+
+		//the vertices of the triangle move to the front
+		for (auto&& v : cache) {
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+				nextCache.push_back(v);
+			}
+		}
+
+		for (auto i : range(nextCache.size())) {
+			cachePosition[nextCache[i]] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+		}
+
+		//update the scores of the vertices that moved or left, and of their triangles
+		for (auto&& v : nextCache) {
+			auto score = vertexScore(cachePosition[v], remaining[v]);
+			auto delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (auto i : range(adjacencyStart[v], adjacencyStart[v] + remaining[v])) {
+				triangleScores[adjacency[i]] += delta;
+			}
+		}
+
+		if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+			nextCache.resize(FORSYTH_CACHE_SIZE);
+		}
+		std::swap(cache, nextCache);
+
+		//the next triangle is the best one that uses a cached vertex
+		best = NO_TRIANGLE;
+		float bestScore = -1.f;
+		for (auto&& v : cache) {
+			for (auto i : range(adjacencyStart[v], adjacencyStart[v] + remaining[v])) {
+				auto t = adjacency[i];
+				if (triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+	}
+
+	indices = std::move(output);
+}
+
+void Cooker::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vector>& positions, float threshold) {
+	DEBUG_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+
+	auto triangleCount = indices.size() / 3;
+	auto vertexCount = (uint32_t)positions.size();
+	if (triangleCount == 0) {
+		return;
+	}
+
+	//split the triangles where the cache restarts, ie. where a triangle misses all of its vertices
+	std::vector<size_t> clusterStarts;
+	{
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		uint32_t time = MEASURE_CACHE_SIZE + 1;
+
+		for (auto t : range(triangleCount)) {
+			int misses = 0;
+			for (auto k : range(3)) {
+				auto index = indices[t * 3 + k];
+				if (time - timestamps[index] > MEASURE_CACHE_SIZE) {
+					timestamps[index] = time++;
+					++misses;
+				}
+			}
+
+			if (t == 0 or misses == 3) {
+				clusterStarts.push_back(t);
+			}
+		}
+	}
+
+	if (clusterStarts.size() < 2) {
+		return;
+	}
+
+	glm::vec3 meshCenter(0.f);
+	for (auto&& position : positions) {
+		meshCenter += position;
+	}
+	meshCenter /= (float)std::max(vertexCount, 1u);
+
+	struct Cluster {
+		size_t start, end;
+		float sortKey;
+	};
+
+	std::vector<Cluster> clusters;
+	for (auto i : range(clusterStarts.size())) {
+		Cluster cluster = { clusterStarts[i], i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount, 0 };
+
+		glm::vec3 centroid(0.f), normal(0.f);
+		float area = 0;
+		for (auto t : range(cluster.start, cluster.end)) {
+			const glm::vec3& a = positions[indices[t * 3]];
+			const glm::vec3& b = positions[indices[t * 3 + 1]];
+			const glm::vec3& c = positions[indices[t * 3 + 2]];
+
+			//counter clockwise triangles face outwards, as in OBJ files
+			auto cross = glm::cross(b - a, c - a);
+			auto triangleArea = glm::length(cross);
+
+			centroid += (a + b + c) * (triangleArea / 3.f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		if (area > 0) {
+			centroid /= area;
+			auto length = glm::length(normal);
+			if (length > 0) {
+				//clusters on the outside and facing away from the center are likely to occlude the others
+				cluster.sortKey = glm::dot(centroid - meshCenter, normal / length);
+			}
+		}
+
+		clusters.push_back(cluster);
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(indices.size());
+	for (auto&& cluster : clusters) {
+		sorted.insert(sorted.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+	}
+
+	//don't trade too much vertex cache efficiency for it
+	auto before = countCacheMisses(indices, vertexCount, MEASURE_CACHE_SIZE);
+	auto after = countCacheMisses(sorted, vertexCount, MEASURE_CACHE_SIZE);
+	if (after <= before * threshold) {
+		indices = std::move(sorted);
+	}
+}
+
+void Cooker::optimizeVertexFetch(std::vector<uint8_t>& vertices, uint32_t stride, std::vector<uint32_t>& indices) {
+	auto vertexCount = vertices.size() / stride;
+
+	std::vector<uint32_t> remap(vertexCount, NO_TRIANGLE);
+	std::vector<uint8_t> sorted;
+	sorted.reserve(vertices.size());
+
+	uint32_t next = 0;
+	for (auto&& index : indices) {
+		if (remap[index] == NO_TRIANGLE) {
+			remap[index] = next++;
+
+			auto vertex = vertices.begin() + (size_t)index * stride;
+			sorted.insert(sorted.end(), vertex, vertex + stride);
+		}
+		index = remap[index];
+	}
+
+	//vertices that no triangle uses are dropped
+	vertices = std::move(sorted);
+}
+
+bool Cooker::haveSameTriangles(
+	const std::vector<uint8_t>& verticesA, const std::vector<uint32_t>& indicesA,
+	const std::vector<uint8_t>& verticesB, const std::vector<uint32_t>& indicesB,
+	uint32_t stride) {
+
+	if (indicesA.size() != indicesB.size() or indicesA.size() % 3 != 0) {
+		return false;
+	}
+
+	//find the vertex of A that has the content of each vertex of B
+	std::unordered_map<std::string, uint32_t> verticesOfA;
+	verticesOfA.reserve(verticesA.size() / stride);
+	for (auto i : range(verticesA.size() / stride)) {
+		verticesOfA.emplace(std::string((const char*)verticesA.data() + i * stride, stride), (uint32_t)i);
+	}
+
+	std::vector<uint32_t> remapB(verticesB.size() / stride);
+	for (auto i : range(remapB.size())) {
+		auto found = verticesOfA.find(std::string((const char*)verticesB.data() + i * stride, stride));
+		if (found == verticesOfA.end()) {
+			return false;
+		}
+		remapB[i] = found->second;
+	}
+
+	//rotating the smallest index first keeps the winding, then both lists are sorted to ignore the order
+	typedef std::array<uint32_t, 3> Triangle;
+	auto collect = [](const std::vector<uint32_t>& indices, const std::vector<uint32_t>* remap) {
+		std::vector<Triangle> triangles;
+		triangles.reserve(indices.size() / 3);
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			Triangle triangle;
+			for (auto j : range(3)) {
+				triangle[j] = remap ? (*remap)[indices[i + j]] : indices[i + j];
+			}
+
+			auto first = std::min_element(triangle.begin(), triangle.end());
+			std::rotate(triangle.begin(), first, triangle.end());
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+
+	for (auto&& index : indicesB) {
+		if (index >= remapB.size()) {
+			return false;
+		}
+	}
+
+	return collect(indicesA, nullptr) == collect(indicesB, &remapB);
+}
+
+float Cooker::measureCacheHitRate(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	if (indices.empty()) {
+		return 0;
+	}
+
+	return 1.f - countCacheMisses(indices, vertexCount, cacheSize) / (float)indices.size();
+}
+
+float Cooker::measureACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+	if (indices.empty()) {
+		return 0;
+	}
+
+	return countCacheMisses(indices, vertexCount, cacheSize) / (indices.size() / 3.f);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+
+namespace Cooker {
+	///the FIFO size used when measuring, close to the post-transform cache of most mobile GPUs
+	static const uint32_t MEASURE_CACHE_SIZE = 16;
+
+	///reorders the triangles in indices with Forsyth's linear-speed vertex cache optimization
+	void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+	///reorders clusters of triangles so that the ones facing outwards are drawn first
+	/**
+	Clusters are split where the vertex cache restarts, so their order can change without hurting the cache much; the new
+	order is kept only if the miss ratio doesn't grow more than threshold times.
+	*/
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Dojo::Vector>& positions, float threshold = 1.05f);
+
+	///reorders the vertices in the order they are first used to improve fetch locality, and remaps indices
+	void optimizeVertexFetch(std::vector<uint8_t>& vertices, uint32_t stride, std::vector<uint32_t>& indices);
+
+	///returns true if both meshes draw the same triangles with the same winding, in any order and with any vertex order
+	/**
+	The vertices are compared by their content, so the vertices of each mesh must be unique like weld() makes them. */
+	bool haveSameTriangles(
+		const std::vector<uint8_t>& verticesA, const std::vector<uint32_t>& indicesA,
+		const std::vector<uint8_t>& verticesB, const std::vector<uint32_t>& indicesB,
+		uint32_t stride);
+
+	///returns the fraction of indices that hit a FIFO post-transform cache of the given size
+	float measureCacheHitRate(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = MEASURE_CACHE_SIZE);
+
+	///returns the average amount of vertices transformed per triangle with a FIFO cache of the given size
+	float measureACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = MEASURE_CACHE_SIZE);
+}
@@ -0,0 +1,177 @@
+#include "OBJImporter.h"
+
+#include <fstream>
+
+using namespace Dojo;
+
+namespace {
+	struct Reference {
+		int position = -1, uv = -1, normal = -1;
+	};
+
+	///resolves a 1-based or negative (relative) OBJ index, returns -1 if it's out of range
+	int resolve(long index, size_t count) {
+		if (index > 0 and (size_t)index <= count) {
+			return (int)index - 1;
+		}
+		if (index < 0 and (size_t)-index <= count) {
+			return (int)(count + index);
+		}
+		return -1;
+	}
+
+	const char* skipSpaces(const char* c) {
+		while (*c == ' ' or *c == '\t') {
+			++c;
+		}
+		return c;
+	}
+
+	///reads up to count floats, returns how many were found
+	int readFloats(const char* c, float* out, int count) {
+		int read = 0;
+		for (; read < count; ++read) {
+			char* end;
+			out[read] = std::strtof(c, &end);
+			if (end == c) {
+				break;
+			}
+			c = end;
+		}
+		return read;
+	}
+}
+
+bool Cooker::importOBJ(const std::string& path, SourceMesh& out, std::string& error) {
+	std::ifstream file(path);
+	if (not file) {
+		error = "cannot open the file";
+		return false;
+	}
+
+	std::vector<Vector> positions, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<uint32_t> colors;
+
+	std::vector<Reference> polygon;
+	std::string line;
+	int lineNumber = 0;
+
+	out = {};
+
+	while (std::getline(file, line)) {
+		++lineNumber;
+
+		auto c = skipSpaces(line.c_str());
+		float values[4] = {};
+
+		if (c[0] == 'v' and (c[1] == ' ' or c[1] == '\t')) {
+			if (readFloats(c + 1, values, 3) < 3) {
+				error = "invalid position at line " + std::to_string(lineNumber);
+				return false;
+			}
+			positions.emplace_back(values[0], values[1], values[2]);
+		}
+		else if (c[0] == 'v' and c[1] == 'n') {
+			if (readFloats(c + 2, values, 3) < 3) {
+				error = "invalid normal at line " + std::to_string(lineNumber);
+				return false;
+			}
+			normals.emplace_back(values[0], values[1], values[2]);
+		}
+		else if (c[0] == 'v' and c[1] == 't') {
+			if (readFloats(c + 2, values, 2) < 2) {
+				error = "invalid uv at line " + std::to_string(lineNumber);
+				return false;
+			}
+			//Dojo textures start at the top
+			uvs.emplace_back(values[0], 1.f - values[1]);
+		}
+		else if (c[0] == 'v' and c[1] == 'c') {
+			if (readFloats(c + 2, values, 4) < 4) {
+				error = "invalid color at line " + std::to_string(lineNumber);
+				return false;
+			}
+			uint32_t color = 0;
+			for (auto i : { 0, 1, 2, 3 }) {
+				color |= ((uint32_t)values[i] & 0xff) << (i * 8);
+			}
+			colors.push_back(color);
+		}
+		else if (c[0] == 'f' and (c[1] == ' ' or c[1] == '\t')) {
+			polygon.clear();
+
+			c = skipSpaces(c + 1);
+			while (*c and *c != '\r' and *c != '\n') {
+				Reference ref;
+				char* end;
+
+				ref.position = resolve(std::strtol(c, &end, 10), positions.size());
+				c = end;
+
+				if (*c == '/') {
+					++c;
+					if (*c != '/') {
+						ref.uv = resolve(std::strtol(c, &end, 10), uvs.size());
+						c = end;
+					}
+					if (*c == '/') {
+						ref.normal = resolve(std::strtol(c + 1, &end, 10), normals.size());
+						c = end;
+					}
+				}
+
+				if (ref.position < 0) {
+					error = "invalid face at line " + std::to_string(lineNumber);
+					return false;
+				}
+
+				polygon.push_back(ref);
+				c = skipSpaces(c);
+			}
+
+			if (polygon.size() < 3) {
+				error = "degenerate face at line " + std::to_string(lineNumber);
+				return false;
+			}
+
+			//the first face decides which attributes the mesh has
+			if (out.corners.empty()) {
+				out.hasUVs = polygon[0].uv >= 0;
+				out.hasNormals = polygon[0].normal >= 0;
+				out.hasColors = colors.size() > 0;
+			}
+
+			for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+				for (auto&& ref : { polygon[0], polygon[i], polygon[i + 1] }) {
+					if ((out.hasUVs and ref.uv < 0) or (out.hasNormals and ref.normal < 0)) {
+						error = "all the faces must have the same attributes, line " + std::to_string(lineNumber);
+						return false;
+					}
+
+					SourceMesh::Corner corner;
+					corner.position = positions[ref.position];
+					if (out.hasUVs) {
+						corner.uv = uvs[ref.uv];
+					}
+					if (out.hasNormals) {
+						corner.normal = normals[ref.normal];
+					}
+					//colors are listed per position
+					if (out.hasColors and (size_t)ref.position < colors.size()) {
+						corner.color = colors[ref.position];
+					}
+
+					out.corners.push_back(corner);
+				}
+			}
+		}
+	}
+
+	if (out.corners.empty()) {
+		error = "the file has no faces";
+		return false;
+	}
+
+	return true;
+}
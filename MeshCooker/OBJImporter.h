@@ -0,0 +1,27 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+
+namespace Cooker {
+	///a triangle soup with optional attributes, 3 corners per triangle
+	struct SourceMesh {
+		struct Corner {
+			Dojo::Vector position, normal;
+			glm::vec2 uv = { 0.f, 0.f };
+			uint32_t color = 0xffffffff;
+		};
+
+		bool hasNormals = false, hasUVs = false, hasColors = false;
+		std::vector<Corner> corners;
+	};
+
+	///reads a Wavefront OBJ file, polygons are triangulated as fans
+	/**
+	Like OBJCooker, the texture v coordinate is flipped and the non standard "vc r g b a" lines are read as vertex colors,
+	one for each position.
+	\returns false and an error message if the file can't be read or is malformed
+	*/
+	bool importOBJ(const std::string& path, SourceMesh& out, std::string& error);
+}
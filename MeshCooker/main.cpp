@@ -0,0 +1,445 @@
+#include "dojo_common_header.h"
+
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "range.h"
+#include "enum_cast.h"
+
+#include "OBJImporter.h"
+#include "MeshOptimizer.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace Dojo;
+using namespace Cooker;
+
+namespace {
+	struct Report {
+		std::string path;
+		std::string error;
+
+		///legacy .mesh inputs are only converted to v2, they have no optimization stats
+		bool converted = false, alreadyV2 = false;
+
+		uint32_t sourceVertices = 0, vertices = 0, triangles = 0;
+		uint8_t indexSize = 0;
+		float hitRateBefore = 0, hitRateAfter = 0;
+		float acmrBefore = 0, acmrAfter = 0;
+		size_t bytes = 0;
+		double milliseconds = 0;
+	};
+
+	bool isDirectory(const std::string& path) {
+#ifdef _WIN32
+		auto attributes = GetFileAttributesA(path.c_str());
+		return attributes != INVALID_FILE_ATTRIBUTES and (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 and S_ISDIR(info.st_mode);
+#endif
+	}
+
+	bool hasExtension(const std::string& path, const std::string& extension) {
+		if (path.size() < extension.size()) {
+			return false;
+		}
+
+		return std::equal(extension.rbegin(), extension.rend(), path.rbegin(), [](char a, char b) {
+			return std::tolower(a) == std::tolower(b);
+		});
+	}
+
+	bool isInputFile(const std::string& name) {
+		return hasExtension(name, ".obj") or hasExtension(name, ".mesh");
+	}
+
+	void listInputFiles(const std::string& directory, std::vector<std::string>& out) {
+#ifdef _WIN32
+		WIN32_FIND_DATAA data;
+		auto handle = FindFirstFileA((directory + "/*").c_str(), &data);
+		if (handle == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		do {
+			if (not (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) and isInputFile(data.cFileName)) {
+				out.push_back(directory + "/" + data.cFileName);
+			}
+		} while (FindNextFileA(handle, &data));
+
+		FindClose(handle);
+#else
+		auto dir = opendir(directory.c_str());
+		if (not dir) {
+			return;
+		}
+
+		while (auto entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (isInputFile(name)) {
+				out.push_back(directory + "/" + name);
+			}
+		}
+
+		closedir(dir);
+#endif
+	}
+
+	std::string outputPathFor(const std::string& input, const std::string& outputDirectory) {
+		auto path = input.substr(0, input.find_last_of('.')) + ".mesh";
+
+		if (outputDirectory.size() > 0) {
+			auto slash = path.find_last_of("/\\");
+			path = outputDirectory + "/" + (slash == std::string::npos ? path : path.substr(slash + 1));
+		}
+		return path;
+	}
+
+	///packs the corners in the vertex layout of Mesh, then merges the identical ones
+	void weld(const SourceMesh& source, const std::vector<VertexField>& fields, uint32_t stride, const AABB& bounds, std::vector<uint8_t>& vertices, std::vector<uint32_t>& indices, std::vector<Vector>& positions) {
+		std::unordered_map<std::string, uint32_t> unique;
+		unique.reserve(source.corners.size());
+
+		std::string vertex(stride, 0);
+
+		for (auto&& corner : source.corners) {
+			size_t offset = 0;
+			for (auto&& field : fields) {
+				auto data = &vertex[offset];
+
+				switch (field) {
+				case VertexField::Position3D:
+					memcpy(data, &corner.position.x, sizeof(float) * 3);
+					break;
+				case VertexField::Color:
+					memcpy(data, &corner.color, sizeof(uint32_t));
+					break;
+				case VertexField::PositionQuantized: {
+					auto packed = Mesh::packPositionQuantized(corner.position, bounds);
+					memcpy(data, packed.data(), sizeof(packed));
+					break;
+				}
+				case VertexField::Normal: {
+					auto length = glm::length(corner.normal);
+					auto packed = Mesh::packNormal(length > 0 ? Vector(corner.normal / length) : Vector::Zero);
+					memcpy(data, &packed, sizeof(packed));
+					break;
+				}
+				case VertexField::NormalOctahedral: {
+					//a zero normal can't be folded, it becomes +Z
+					auto length = glm::length(corner.normal);
+					auto packed = Mesh::packNormalOctahedral(length > 0 ? Vector(corner.normal / length) : Vector::UnitZ);
+					memcpy(data, &packed, sizeof(packed));
+					break;
+				}
+				case VertexField::UV0: {
+					auto packed = glm::packHalf2x16(corner.uv);
+					memcpy(data, &packed, sizeof(packed));
+					break;
+				}
+				default:
+					FAIL("Unsupported field");
+				}
+
+				offset += Mesh::getVertexFieldSize(field);
+			}
+
+			auto inserted = unique.emplace(vertex, (uint32_t)positions.size());
+			if (inserted.second) {
+				vertices.insert(vertices.end(), vertex.begin(), vertex.end());
+				positions.push_back(corner.position);
+			}
+
+			indices.push_back(inserted.first->second);
+		}
+	}
+
+	bool writeFile(const std::string& path, const std::vector<uint8_t>& data, Report& report) {
+		std::ofstream file(path, std::ios::binary);
+		if (not file.write((const char*)data.data(), data.size())) {
+			report.error = "cannot write " + path;
+			return false;
+		}
+
+		report.bytes = data.size();
+		return true;
+	}
+
+	///rewrites a legacy .mesh in the v2 layout, so that it's loaded through the mapping without copies
+	bool convert(const std::string& input, const std::string& output, Report& report) {
+		report.converted = true;
+
+		{
+			//the directories can mix legacy and converted files, the output can be the input itself
+			MeshFile existing(input);
+			if (existing.open() and existing.getVersion() != 1) {
+				report.alreadyV2 = true;
+				return true;
+			}
+		}
+
+		std::vector<uint8_t> legacy;
+		{
+			std::ifstream file(input, std::ios::binary);
+			if (not file) {
+				report.error = "cannot read " + input;
+				return false;
+			}
+			legacy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		std::vector<uint8_t> converted;
+		if (not MeshFile::convertLegacy(legacy.data(), legacy.size(), converted)) {
+			report.error = "not a valid legacy mesh";
+			return false;
+		}
+
+		if (not writeFile(output, converted, report)) {
+			return false;
+		}
+
+		//read the result back, to check it and report what was written
+		MeshFile written(output);
+		if (not written.open() or written.getVersion() == 1) {
+			report.error = "the converted file can't be loaded";
+			return false;
+		}
+
+		report.vertices = report.sourceVertices = written.getVertexCount();
+		report.triangles = written.getPrimitiveMode() == PrimitiveMode::TriangleList ? written.getIndexCount() / 3 : 0;
+		report.indexSize = written.getIndexByteSize();
+		return true;
+	}
+
+	bool cook(const std::string& input, const std::string& output, bool quantize, Report& report) {
+		if (hasExtension(input, ".mesh")) {
+			return convert(input, output, report);
+		}
+
+		SourceMesh source;
+		if (not importOBJ(input, source, report.error)) {
+			return false;
+		}
+
+		//quantized positions are relative to the bounds, so they're needed before packing
+		AABB bounds = AABB::Invalid;
+		for (auto&& corner : source.corners) {
+			bounds = bounds.expandToFit(corner.position);
+		}
+
+		//the fields are laid out in the order of VertexField, like Mesh does
+		std::vector<VertexField> fields;
+		if (not quantize) {
+			fields.push_back(VertexField::Position3D);
+		}
+		if (source.hasColors) {
+			fields.push_back(VertexField::Color);
+		}
+		if (source.hasNormals and not quantize) {
+			fields.push_back(VertexField::Normal);
+		}
+		if (source.hasUVs) {
+			fields.push_back(VertexField::UV0);
+		}
+		if (quantize) {
+			fields.push_back(VertexField::PositionQuantized);
+			if (source.hasNormals) {
+				fields.push_back(VertexField::NormalOctahedral);
+			}
+		}
+
+		uint32_t stride = 0;
+		for (auto&& field : fields) {
+			stride += Mesh::getVertexFieldSize(field);
+		}
+
+		std::vector<uint8_t> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Vector> positions;
+		weld(source, fields, stride, bounds, vertices, indices, positions);
+
+		auto vertexCount = (uint32_t)positions.size();
+
+		report.sourceVertices = (uint32_t)source.corners.size();
+		report.triangles = (uint32_t)(indices.size() / 3);
+		report.hitRateBefore = measureCacheHitRate(indices, vertexCount);
+		report.acmrBefore = measureACMR(indices, vertexCount);
+
+		//the optimizations only reorder, they must give back exactly the welded triangles
+		auto weldedVertices = vertices;
+		auto weldedIndices = indices;
+
+		optimizeVertexCache(indices, vertexCount);
+		optimizeOverdraw(indices, positions);
+
+		report.hitRateAfter = measureCacheHitRate(indices, vertexCount);
+		report.acmrAfter = measureACMR(indices, vertexCount);
+
+		optimizeVertexFetch(vertices, stride, indices);
+		report.vertices = (uint32_t)(vertices.size() / stride);
+
+		if (not haveSameTriangles(weldedVertices, weldedIndices, vertices, indices, stride)) {
+			report.error = "the optimized triangles don't match the source";
+			return false;
+		}
+
+		//the smallest index type that can address all the vertices
+		report.indexSize = report.vertices <= 0x100 ? 1 : (report.vertices <= 0x10000 ? 2 : 4);
+
+		std::vector<uint8_t> packedIndices(indices.size() * report.indexSize);
+		for (auto i : range(indices.size())) {
+			memcpy(packedIndices.data() + i * report.indexSize, &indices[i], report.indexSize); //little endian
+		}
+
+		MeshFile::Description desc;
+		desc.indexByteSize = report.indexSize;
+		desc.primitiveMode = PrimitiveMode::TriangleList;
+		desc.fields = fields;
+		desc.vertexStride = stride;
+		desc.vertexCount = report.vertices;
+		desc.indexCount = (uint32_t)indices.size();
+		desc.vertices = vertices.data();
+		desc.indices = packedIndices.data();
+		desc.bounds = bounds;
+
+		return writeFile(output, MeshFile::serialize(desc), report);
+	}
+
+	void printReport(const std::vector<Report>& reports) {
+		std::cout << std::fixed << std::setprecision(3);
+
+		uint64_t triangles = 0;
+		double missesBefore = 0, missesAfter = 0;
+		int failed = 0, converted = 0, skipped = 0;
+
+		for (auto&& report : reports) {
+			if (report.error.size() > 0) {
+				std::cout << "FAILED " << report.path << ": " << report.error << "\n";
+				++failed;
+				continue;
+			}
+
+			if (report.alreadyV2) {
+				std::cout << report.path << "\n\talready in the v2 layout, skipped\n";
+				++skipped;
+				continue;
+			}
+
+			if (report.converted) {
+				++converted;
+				std::cout << report.path << "\n"
+					<< "\tconverted from the legacy layout, vertices " << report.vertices
+					<< ", " << (int)report.indexSize * 8 << " bit indices, " << report.bytes << " bytes, "
+					<< report.milliseconds << " ms\n";
+				continue;
+			}
+
+			std::cout << report.path << "\n"
+				<< "\tvertices " << report.sourceVertices << " -> " << report.vertices
+				<< ", triangles " << report.triangles
+				<< ", " << (int)report.indexSize * 8 << " bit indices, " << report.bytes << " bytes, "
+				<< report.milliseconds << " ms\n"
+				<< "\tcache hit rate (FIFO " << MEASURE_CACHE_SIZE << ") " << report.hitRateBefore << " -> " << report.hitRateAfter
+				<< ", ACMR " << report.acmrBefore << " -> " << report.acmrAfter << "\n";
+
+			triangles += report.triangles;
+			missesBefore += report.acmrBefore * report.triangles;
+			missesAfter += report.acmrAfter * report.triangles;
+		}
+
+		if (triangles > 0) {
+			std::cout << "TOTAL " << triangles << " triangles, ACMR "
+				<< missesBefore / triangles << " -> " << missesAfter / triangles
+				<< ", cache hit rate " << 1. - missesBefore / (triangles * 3) << " -> " << 1. - missesAfter / (triangles * 3) << "\n";
+		}
+
+		std::cout << reports.size() - failed - converted - skipped << " meshes cooked, " << converted << " converted, "
+			<< skipped << " skipped, " << failed << " failed" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> inputs;
+	std::string outputDirectory;
+	uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	bool quantize = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-o" and i + 1 < argc) {
+			outputDirectory = argv[++i];
+		}
+		else if (arg == "-q") {
+			quantize = true;
+		}
+		else if (arg == "-j" and i + 1 < argc) {
+			threadCount = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (isDirectory(arg)) {
+			listInputFiles(arg, inputs);
+		}
+		else {
+			inputs.push_back(arg);
+		}
+	}
+
+	//a .mesh next to the .obj of the same name was cooked from it, the .obj is cooked again instead
+	inputs.erase(std::remove_if(inputs.begin(), inputs.end(), [&](const std::string& input) {
+		return hasExtension(input, ".mesh") and
+			std::find(inputs.begin(), inputs.end(), input.substr(0, input.size() - 5) + ".obj") != inputs.end();
+	}), inputs.end());
+
+	if (inputs.empty()) {
+		std::cout << "usage: MeshCooker [-o outputDirectory] [-j threads] [-q] <file.obj | file.mesh | directory>..." << std::endl;
+		std::cout << "legacy .mesh files are converted to the v2 layout, in place when there is no output directory" << std::endl;
+		return 1;
+	}
+
+	std::vector<Report> reports(inputs.size());
+	std::atomic<size_t> next(0);
+
+	//each mesh is independent, the workers just pick the next one
+	auto work = [&] {
+		for (auto i = next++; i < inputs.size(); i = next++) {
+			auto start = std::chrono::high_resolution_clock::now();
+
+			auto& report = reports[i];
+			report.path = inputs[i];
+			cook(inputs[i], outputPathFor(inputs[i], outputDirectory), quantize, report);
+
+			report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < std::min<size_t>(threadCount, inputs.size()); ++i) {
+		workers.emplace_back(work);
+	}
+
+	work();
+
+	for (auto&& worker : workers) {
+		worker.join();
+	}
+
+	printReport(reports);
+
+	for (auto&& report : reports) {
+		if (report.error.size() > 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
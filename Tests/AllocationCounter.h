@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+//replaces the global operator new of the test program that includes this header, to count its allocations;
+//include it from one file only
+
+//GCC sees the free() of the pointers that come from the replaced operator new and takes them for a mismatch
+#if defined(__GNUC__) and __GNUC__ >= 11
+	#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace Tests {
+	inline std::atomic<uint64_t>& getAllocationCounter() {
+		static std::atomic<uint64_t> allocations(0);
+		return allocations;
+	}
+
+	///the number of times operator new was called since the program started, by any thread
+	inline uint64_t getAllocationCount() {
+		return getAllocationCounter().load();
+	}
+}
+
+void* operator new(size_t size) {
+	++Tests::getAllocationCounter();
+	if (auto ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
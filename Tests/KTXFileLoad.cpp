@@ -0,0 +1,106 @@
+#include "dojo_common_header.h"
+
+#include "KTXFile.h"
+#include "range.h"
+
+#include "TestCheck.h"
+
+#include <fstream>
+
+using namespace Dojo;
+
+namespace {
+	const char* PATH = "KTXFileLoad.ktx";
+
+	const uint8_t KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	//GL enums, as written in the headers
+	const uint32_t GL_UNSIGNED_BYTE_VALUE = 0x1401;
+	const uint32_t GL_R8_VALUE = 0x8229;
+	const uint32_t GL_RGBA8_VALUE = 0x8058;
+
+	template<typename T>
+	void append(std::vector<uint8_t>& bytes, const T& value) {
+		auto data = (const uint8_t*)&value;
+		bytes.insert(bytes.end(), data, data + sizeof(T));
+	}
+
+	///a KTX 1.1 file with a single level of the given size, each byte of the level holds its offset
+	std::vector<uint8_t> makeKTX1(uint32_t glInternalFormat, uint32_t width, uint32_t height, uint32_t imageSize) {
+		std::vector<uint8_t> bytes(KTX1_IDENTIFIER, KTX1_IDENTIFIER + sizeof(KTX1_IDENTIFIER));
+
+		uint32_t header[] = {
+			0x04030201, //endianness
+			GL_UNSIGNED_BYTE_VALUE, 1, 0, glInternalFormat, 0, //type, type size, format, internal and base format
+			width, height, 0, //depth
+			0, 1, 1, //array elements, faces, levels
+			0 //key-value data
+		};
+		for (auto value : header) {
+			append(bytes, value);
+		}
+
+		append(bytes, imageSize);
+		for (auto i : range(imageSize)) {
+			bytes.push_back((uint8_t)i);
+		}
+		return bytes;
+	}
+
+	bool open(const std::vector<uint8_t>& bytes) {
+		{
+			std::ofstream file(PATH, std::ios::binary | std::ios::trunc);
+			file.write((const char*)bytes.data(), bytes.size());
+		}
+		return KTXFile(PATH).open();
+	}
+
+	void testCompleteLevels() {
+		CHECK(open(makeKTX1(GL_RGBA8_VALUE, 4, 4, 4 * 4 * 4)));
+
+		//rows of 3 bytes take 4 in the file
+		CHECK(open(makeKTX1(GL_R8_VALUE, 3, 3, 4 * 3)));
+	}
+
+	void testShortLevels() {
+		//the level fits in the file, but not the pixels it should hold
+		CHECK(not open(makeKTX1(GL_RGBA8_VALUE, 4, 4, 4 * 4 * 4 - 1)));
+		CHECK(not open(makeKTX1(GL_RGBA8_VALUE, 64, 64, 16)));
+
+		//packed rows are too short for a KTX 1.1 file
+		CHECK(not open(makeKTX1(GL_R8_VALUE, 3, 3, 3 * 3)));
+	}
+
+	void testBadDimensions() {
+		CHECK(not open(makeKTX1(GL_RGBA8_VALUE, 0, 4, 0)));
+		CHECK(not open(makeKTX1(GL_RGBA8_VALUE, 0x80000000, 0x80000000, 16)));
+	}
+
+	void testPackedRows() {
+		auto bytes = makeKTX1(GL_R8_VALUE, 3, 2, 4 * 2);
+		{
+			std::ofstream file(PATH, std::ios::binary | std::ios::trunc);
+			file.write((const char*)bytes.data(), bytes.size());
+		}
+
+		KTXFile ktx(PATH);
+		if (not CHECK(ktx.open())) {
+			return;
+		}
+		CHECK(ktx.getRowAlignment() == 4);
+
+		//the padding byte at the end of the first row is skipped
+		std::vector<uint8_t> buffer;
+		auto packed = ktx.getPackedData(ktx.getLevels()[0], buffer);
+		CHECK(packed[0] == 0 and packed[2] == 2 and packed[3] == 4 and packed[5] == 6);
+	}
+}
+
+int main(int argc, char** argv) {
+	testCompleteLevels();
+	testShortLevels();
+	testBadDimensions();
+	testPackedRows();
+
+	return Tests::result();
+}
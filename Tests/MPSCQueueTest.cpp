@@ -0,0 +1,151 @@
+#include "dojo_common_header.h"
+
+#include "MPSCQueue.h"
+#include "SlotPool.h"
+#include "range.h"
+
+#include "AllocationCounter.h"
+#include "TestCheck.h"
+
+using namespace Dojo;
+
+namespace {
+	const uint32_t PRODUCER_COUNT = 8;
+	const uint32_t ELEMENTS_PER_PRODUCER = 100000;
+
+	struct Element {
+		uint32_t producer, sequence;
+	};
+
+	///counts the live instances, to check that the queue destroys what it holds
+	struct Counted {
+		static int gLive;
+
+		Counted() {
+			++gLive;
+		}
+
+		Counted(Counted&&) {
+			++gLive;
+		}
+
+		Counted& operator=(Counted&&) {
+			return *this;
+		}
+
+		~Counted() {
+			--gLive;
+		}
+	};
+
+	int Counted::gLive = 0;
+
+	void testManyProducers() {
+		MPSCQueue<Element> queue;
+		std::atomic<uint32_t> started(0);
+
+		std::vector<std::thread> producers;
+		for (auto p : range(PRODUCER_COUNT)) {
+			producers.emplace_back([&queue, &started, p] {
+				//start together to make them collide on the head
+				++started;
+				while (started < PRODUCER_COUNT) {}
+
+				for (auto i : range(ELEMENTS_PER_PRODUCER)) {
+					queue.enqueue(Element{ p, i });
+				}
+			});
+		}
+
+		//each producer's elements come out in the order it queued them, and none is lost or repeated
+		std::vector<uint32_t> nextSequence(PRODUCER_COUNT, 0);
+		uint64_t received = 0;
+		bool ordered = true;
+
+		while (received < (uint64_t)PRODUCER_COUNT * ELEMENTS_PER_PRODUCER) {
+			Element element;
+			if (queue.try_dequeue(element)) {
+				ordered &= element.producer < PRODUCER_COUNT and element.sequence == nextSequence[element.producer];
+				++nextSequence[element.producer];
+				++received;
+			}
+		}
+
+		for (auto&& producer : producers) {
+			producer.join();
+		}
+
+		Element extra;
+		CHECK(ordered);
+		CHECK(not queue.try_dequeue(extra));
+		for (auto sequence : nextSequence) {
+			CHECK(sequence == ELEMENTS_PER_PRODUCER);
+		}
+	}
+
+	void testNoAllocationsOnceWarm() {
+		MPSCQueue<Element> queue;
+
+		auto fill = [&queue] {
+			for (auto i : range(1000u)) {
+				queue.enqueue(Element{ 0, i });
+			}
+
+			Element element;
+			while (queue.try_dequeue(element)) {}
+		};
+
+		//the first round grows the node pool
+		fill();
+
+		auto before = Tests::getAllocationCount();
+		for (int round = 0; round < 100; ++round) {
+			fill();
+		}
+		CHECK(Tests::getAllocationCount() == before);
+	}
+
+	void testPoolExhaustion() {
+		//one slot per segment, so that the segment table runs out first
+		SlotPool<int, 1> pool;
+		for (auto i : range(SlotPool<int, 1>::MAX_SEGMENTS)) {
+			pool[pool.acquire()] = (int)i;
+		}
+
+		bool thrown = false;
+		try {
+			pool.acquire();
+		}
+		catch (const std::bad_alloc&) {
+			thrown = true;
+		}
+		CHECK(thrown);
+
+		//a released slot can be taken again
+		pool.release(7);
+		CHECK(pool.acquire() == 7);
+	}
+
+	void testDestroysLeftovers() {
+		{
+			MPSCQueue<Counted> queue;
+			for (int i = 0; i < 10; ++i) {
+				queue.enqueue();
+			}
+
+			Counted taken;
+			CHECK(queue.try_dequeue(taken));
+			CHECK(Counted::gLive == 10);
+		}
+		CHECK(Counted::gLive == 0);
+	}
+}
+
+int main(int argc, char** argv) {
+	testManyProducers();
+	testNoAllocationsOnceWarm();
+	testDestroysLeftovers();
+	testPoolExhaustion();
+
+	return Tests::result();
+}
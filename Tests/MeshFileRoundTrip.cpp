@@ -0,0 +1,197 @@
+#include "dojo_common_header.h"
+
+#include "MeshFile.h"
+#include "range.h"
+#include "enum_cast.h"
+
+#include "TestCheck.h"
+
+#include <fstream>
+
+using namespace Dojo;
+
+namespace {
+	//the v2 layout, as written by MeshFile.cpp
+	const size_t HEADER_SIZE = 48;
+	const size_t SECTION_COUNT_OFFSET = 12;
+	const size_t SECTION_ENTRY_SIZE = 24;
+	const size_t SECTION_OFFSET_OFFSET = 8;
+
+	const char* PATH = "MeshFileRoundTrip.mesh";
+
+	struct Vertex {
+		float position[3];
+		float uv[2];
+	};
+
+	void writeFile(const std::vector<uint8_t>& bytes) {
+		std::ofstream file(PATH, std::ios::binary | std::ios::trunc);
+		file.write((const char*)bytes.data(), bytes.size());
+	}
+
+	template<typename T>
+	void append(std::vector<uint8_t>& bytes, const T& value) {
+		auto data = (const uint8_t*)&value;
+		bytes.insert(bytes.end(), data, data + sizeof(T));
+	}
+
+	std::vector<Vertex> makeVertices() {
+		std::vector<Vertex> vertices;
+		for (auto i : range(4)) {
+			vertices.push_back({ { (float)(i & 1), (float)(i >> 1), 0.5f }, { (float)(i & 1), 1.f - (i >> 1) } });
+		}
+		return vertices;
+	}
+
+	const std::vector<uint16_t> INDICES = { 0, 1, 2, 2, 1, 3 };
+
+	MeshFile::Description makeDescription(const std::vector<Vertex>& vertices) {
+		MeshFile::Description desc;
+		desc.indexByteSize = sizeof(uint16_t);
+		desc.primitiveMode = PrimitiveMode::TriangleList;
+		desc.fields = { VertexField::Position3D, VertexField::UV0 };
+		desc.vertexStride = sizeof(Vertex);
+		desc.vertexCount = (uint32_t)vertices.size();
+		desc.indexCount = (uint32_t)INDICES.size();
+		desc.vertices = (const uint8_t*)vertices.data();
+		desc.indices = (const uint8_t*)INDICES.data();
+		desc.bounds = { Vector(0, 0, 0.5f), Vector(1, 1, 0.5f) };
+		desc.lods = { { 0, 6, 10.f, 0 }, { 0, 3, 100.f, 0 } };
+		desc.submeshes = { { 0, 3, 0, 3 }, { 3, 3, 1, 3 } };
+		return desc;
+	}
+
+	void checkContent(const MeshFile& file, const std::vector<Vertex>& vertices) {
+		CHECK(file.getIndexByteSize() == sizeof(uint16_t));
+		CHECK(file.getPrimitiveMode() == PrimitiveMode::TriangleList);
+		CHECK(file.isFieldEnabled(VertexField::Position3D));
+		CHECK(file.isFieldEnabled(VertexField::UV0));
+		CHECK(not file.isFieldEnabled(VertexField::Color));
+		CHECK(file.getVertexStride() == sizeof(Vertex));
+		CHECK(file.getVertexCount() == vertices.size());
+		CHECK(file.getIndexCount() == INDICES.size());
+		CHECK(file.getBounds().min == Vector(0, 0, 0.5f));
+		CHECK(file.getBounds().max == Vector(1, 1, 0.5f));
+
+		CHECK(file.getVertexDataSize() == vertices.size() * sizeof(Vertex));
+		CHECK(memcmp(file.getVertexData(), vertices.data(), file.getVertexDataSize()) == 0);
+		CHECK(file.getIndexDataSize() == INDICES.size() * sizeof(uint16_t));
+		CHECK(memcmp(file.getIndexData(), INDICES.data(), file.getIndexDataSize()) == 0);
+	}
+
+	void testRoundTrip() {
+		auto vertices = makeVertices();
+		auto desc = makeDescription(vertices);
+		auto bytes = MeshFile::serialize(desc);
+
+		CHECK(bytes.size() % MeshFile::ALIGNMENT == 0);
+		writeFile(bytes);
+
+		MeshFile file(PATH);
+		if (not CHECK(file.open())) {
+			return;
+		}
+
+		CHECK(file.getVersion() == MeshFile::VERSION);
+		CHECK((size_t)file.getVertexData() % MeshFile::ALIGNMENT == 0);
+		CHECK((size_t)file.getIndexData() % MeshFile::ALIGNMENT == 0);
+		checkContent(file, vertices);
+
+		CHECK(file.getLODs().size() == 2);
+		CHECK(file.getLODs()[1].indexCount == 3 and file.getLODs()[1].maxDistance == 100.f);
+		CHECK(file.getSubmeshes().size() == 2);
+		CHECK(file.getSubmeshes()[1].indexStart == 3 and file.getSubmeshes()[1].vertexStart == 1);
+	}
+
+	std::vector<uint8_t> makeLegacyFile(const std::vector<Vertex>& vertices) {
+		std::vector<uint8_t> bytes;
+		append(bytes, (uint8_t)sizeof(uint16_t));
+		append(bytes, (uint8_t)PrimitiveMode::TriangleList);
+
+		for (auto i : range(enum_cast(VertexField::UVMax) + 1)) {
+			auto field = (VertexField)i;
+			append(bytes, (uint8_t)(field == VertexField::Position3D or field == VertexField::UV0));
+		}
+
+		append(bytes, Vector(1, 1, 0.5f));
+		append(bytes, Vector(0, 0, 0.5f));
+		append(bytes, (uint32_t)vertices.size());
+		append(bytes, (uint32_t)INDICES.size());
+
+		for (auto&& vertex : vertices) {
+			append(bytes, vertex);
+		}
+		for (auto index : INDICES) {
+			append(bytes, index);
+		}
+		return bytes;
+	}
+
+	void testLegacy() {
+		auto vertices = makeVertices();
+		auto legacy = makeLegacyFile(vertices);
+
+		//the legacy layout is still read as it is
+		writeFile(legacy);
+		{
+			MeshFile file(PATH);
+			if (CHECK(file.open())) {
+				CHECK(file.getVersion() == 1);
+				checkContent(file, vertices);
+			}
+		}
+
+		//and converts to the same mesh in the v2 layout
+		std::vector<uint8_t> converted;
+		if (not CHECK(MeshFile::convertLegacy(legacy.data(), legacy.size(), converted))) {
+			return;
+		}
+
+		writeFile(converted);
+		MeshFile file(PATH);
+		if (CHECK(file.open())) {
+			CHECK(file.getVersion() == MeshFile::VERSION);
+			checkContent(file, vertices);
+		}
+	}
+
+	void testCorruptedFiles() {
+		auto vertices = makeVertices();
+		auto bytes = MeshFile::serialize(makeDescription(vertices));
+
+		//a truncated file loses its last sections
+		writeFile({ bytes.begin(), bytes.begin() + bytes.size() / 2 });
+		{
+			MeshFile file(PATH);
+			CHECK(not file.open());
+		}
+
+		//a section offset close to the end of the address space must not wrap the range check
+		uint32_t sectionCount;
+		memcpy(&sectionCount, bytes.data() + SECTION_COUNT_OFFSET, sizeof(sectionCount));
+
+		for (auto i : range(sectionCount)) {
+			auto entry = bytes.data() + HEADER_SIZE + i * SECTION_ENTRY_SIZE;
+
+			uint32_t type;
+			memcpy(&type, entry, sizeof(type));
+			if (type == (uint32_t)MeshFile::SectionType::VertexStream) {
+				uint64_t offset = ~(uint64_t)(MeshFile::ALIGNMENT - 1);
+				memcpy(entry + SECTION_OFFSET_OFFSET, &offset, sizeof(offset));
+			}
+		}
+
+		writeFile(bytes);
+		MeshFile file(PATH);
+		CHECK(not file.open());
+	}
+}
+
+int main(int argc, char** argv) {
+	testRoundTrip();
+	testLegacy();
+	testCorruptedFiles();
+
+	std::remove(PATH);
+	return Tests::result();
+}
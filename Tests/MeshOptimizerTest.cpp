@@ -0,0 +1,119 @@
+#include "dojo_common_header.h"
+
+#include "MeshOptimizer.h"
+#include "range.h"
+
+#include "TestCheck.h"
+
+#include <array>
+#include <random>
+
+using namespace Dojo;
+using namespace Cooker;
+
+namespace {
+	const uint32_t SIDE = 64;
+	const uint32_t STRIDE = sizeof(Vector);
+
+	struct Grid {
+		std::vector<uint8_t> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Vector> positions;
+	};
+
+	///a grid with its triangles shuffled, the worst case for the vertex cache
+	Grid makeShuffledGrid() {
+		Grid grid;
+		for (auto y : range(SIDE)) {
+			for (auto x : range(SIDE)) {
+				Vector position((float)x, (float)y, (float)((x * y) % 7));
+				grid.positions.push_back(position);
+
+				auto bytes = (const uint8_t*)&position;
+				grid.vertices.insert(grid.vertices.end(), bytes, bytes + STRIDE);
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (auto y : range(SIDE - 1)) {
+			for (auto x : range(SIDE - 1)) {
+				auto i = y * SIDE + x;
+				triangles.push_back({ { i, i + 1, i + SIDE } });
+				triangles.push_back({ { i + SIDE, i + 1, i + SIDE + 1 } });
+			}
+		}
+
+		std::mt19937 random(42);
+		std::shuffle(triangles.begin(), triangles.end(), random);
+
+		for (auto&& triangle : triangles) {
+			grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+		}
+		return grid;
+	}
+
+	void testOptimizationKeepsTriangles() {
+		auto grid = makeShuffledGrid();
+		auto vertexCount = (uint32_t)grid.positions.size();
+		auto acmrBefore = measureACMR(grid.indices, vertexCount);
+		auto hitRateBefore = measureCacheHitRate(grid.indices, vertexCount);
+
+		auto indices = grid.indices;
+		auto vertices = grid.vertices;
+		optimizeVertexCache(indices, vertexCount);
+		optimizeOverdraw(indices, grid.positions);
+
+		auto acmrAfter = measureACMR(indices, vertexCount);
+		auto hitRateAfter = measureCacheHitRate(indices, vertexCount);
+
+		optimizeVertexFetch(vertices, STRIDE, indices);
+
+		CHECK(haveSameTriangles(grid.vertices, grid.indices, vertices, indices, STRIDE));
+
+		//a shuffled grid misses almost every vertex, an optimized one gets close to 1 vertex per triangle
+		CHECK(acmrBefore > 2.f);
+		CHECK(acmrAfter < 1.f);
+		CHECK(hitRateAfter > hitRateBefore);
+
+		//the fetch order follows the first use of each vertex
+		uint32_t highest = 0;
+		for (auto index : indices) {
+			CHECK(index <= highest + 1);
+			highest = std::max(highest, index);
+		}
+	}
+
+	void testChangedTrianglesAreFound() {
+		auto grid = makeShuffledGrid();
+
+		//any order of the triangles and rotation of their corners is the same mesh
+		std::vector<uint32_t> reordered;
+		for (size_t i = grid.indices.size(); i > 0; i -= 3) {
+			reordered.insert(reordered.end(), { grid.indices[i - 2], grid.indices[i - 1], grid.indices[i - 3] });
+		}
+		CHECK(haveSameTriangles(grid.vertices, grid.indices, grid.vertices, reordered, STRIDE));
+
+		auto flipped = grid.indices;
+		std::swap(flipped[0], flipped[1]);
+		CHECK(not haveSameTriangles(grid.vertices, grid.indices, grid.vertices, flipped, STRIDE));
+
+		auto dropped = grid.indices;
+		dropped.resize(dropped.size() - 3);
+		CHECK(not haveSameTriangles(grid.vertices, grid.indices, grid.vertices, dropped, STRIDE));
+
+		auto duplicated = grid.indices;
+		std::copy(duplicated.begin(), duplicated.begin() + 3, duplicated.end() - 3);
+		CHECK(not haveSameTriangles(grid.vertices, grid.indices, grid.vertices, duplicated, STRIDE));
+
+		auto moved = grid.vertices;
+		moved[0] ^= 1;
+		CHECK(not haveSameTriangles(grid.vertices, grid.indices, moved, grid.indices, STRIDE));
+	}
+}
+
+int main(int argc, char** argv) {
+	testOptimizationKeepsTriangles();
+	testChangedTrianglesAreFound();
+
+	return Tests::result();
+}
@@ -0,0 +1,99 @@
+#include "dojo_common_header.h"
+
+#include "range.h"
+
+#include "TestCheck.h"
+#include "TestGameState.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace Dojo;
+using namespace Tests;
+
+namespace {
+	const uint32_t DISPOSED_CHILDREN = 50000;
+	const int ROUNDS = 3;
+
+	class HeldObject : public Object {
+	public:
+		bool held = true;
+
+		HeldObject(Object& parent) :
+			Object(parent, Vector::Zero) {
+
+		}
+
+		virtual bool canDestroy() const override {
+			return not held;
+		}
+	};
+
+	///adds twice disposedCount children, disposes every other one in the same frame and returns the milliseconds
+	///taken by the collection
+	double measureCollect(uint32_t disposedCount) {
+		TestGameState state;
+
+		std::vector<Object*> children;
+		for (auto i : range(disposedCount * 2)) {
+			children.push_back(&state.emplaceChild<Object>(Vector((float)i, 0, 0)));
+		}
+
+		for (auto i : range(disposedCount)) {
+			children[i * 2]->dispose();
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		state.collectChilds();
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		CHECK(state.getChildCount() == disposedCount);
+		return elapsed;
+	}
+
+	double bestOf(uint32_t disposedCount) {
+		double best = 1e30;
+		for (int i = 0; i < ROUNDS; ++i) {
+			best = std::min(best, measureCollect(disposedCount));
+		}
+		return best;
+	}
+
+	void testCollectIsLinear() {
+		auto quarter = bestOf(DISPOSED_CHILDREN / 4);
+		auto full = bestOf(DISPOSED_CHILDREN);
+
+		std::cout << DISPOSED_CHILDREN / 4 << " disposed: " << quarter << " ms, "
+			<< DISPOSED_CHILDREN << " disposed: " << full << " ms" << std::endl;
+
+		//4 times the children take about 4 times as long when linear, 16 times when quadratic; the margin is for the
+		//cache misses of the bigger tree
+		CHECK(full < quarter * 10 + 1);
+	}
+
+	void testHeldChildrenWait() {
+		TestGameState state;
+
+		auto& held = state.addChild(make_unique<HeldObject>(state));
+		state.addChild(make_unique<Object>(state, Vector::Zero));
+		auto& disposed = state.addChild(make_unique<Object>(state, Vector::Zero));
+
+		held.dispose();
+		disposed.dispose();
+		state.collectChilds();
+
+		//the held child is only checked again on the next collection
+		CHECK(state.getChildCount() == 2);
+
+		held.held = false;
+		state.collectChilds();
+		CHECK(state.getChildCount() == 1);
+	}
+}
+
+int main(int argc, char** argv) {
+	testHeldChildrenWait();
+	testCollectIsLinear();
+
+	return Tests::result();
+}
@@ -0,0 +1,161 @@
+#include "dojo_common_header.h"
+
+#include "WorkerPool.h"
+#include "range.h"
+
+#include "TestCheck.h"
+#include "TestGameState.h"
+
+using namespace Dojo;
+using namespace Tests;
+
+namespace {
+	const uint32_t WALKER_COUNT = 256;
+	const uint32_t WORKER_COUNT = 4;
+	const int FRAMES = 12;
+	const int RUNS = 3;
+
+	///the counted additions that didn't link the child right away, because they were recorded for the replay
+	std::atomic<int> gDeferredAdds(0);
+
+	///an Object that moves, spawns children and disposes them and itself, all decided by its seed and the frame
+	class Walker : public Object {
+	public:
+		struct Entry {
+			uint32_t seed;
+			size_t childCount;
+			Matrix worldTransform;
+
+			bool operator==(const Entry& other) const {
+				return seed == other.seed and childCount == other.childCount and worldTransform == other.worldTransform;
+			}
+		};
+
+		const uint32_t seed;
+
+		Walker(Object& parent, const Vector& pos, uint32_t seed, int depth) :
+			Object(parent, pos),
+			seed(seed),
+			mDepth(depth) {
+
+		}
+
+		virtual void onAction(float dt) override {
+			++mFrame;
+
+			if (mDepth > 0) {
+				setPosition(getPosition() + Vector((float)(seed % 7), (float)(seed % 3), 0) * dt);
+				rotate(Degrees((float)(seed % 5 + 1)));
+			}
+
+			Object::onAction(dt);
+
+			//the children added and disposed after the update behave the same with and without the replay
+			if (mDepth == 1) {
+				if ((mFrame + seed) % 3 == 0) {
+					_spawn();
+				}
+
+				if (mFrame % 4 == 0) {
+					_disposeFirstChild();
+				}
+
+				if (seed % 7 == 0 and mFrame == 5) {
+					mDisposing = true;
+					dispose();
+				}
+			}
+		}
+
+		///lists the live subtree depth first, in the order of the children
+		/**
+		the disposed children are left out: the replay collects them in the frame they were disposed, the serial update
+		in the next one */
+		void snapshot(std::vector<Entry>& entries) {
+			auto index = entries.size();
+			entries.push_back({ seed, 0, getWorldTransform() });
+
+			for (auto&& child : children) {
+				auto& walker = static_cast<Walker&>(*child);
+				if (not walker.mDisposing) {
+					++entries[index].childCount;
+					walker.snapshot(entries);
+				}
+			}
+		}
+
+	private:
+		int mDepth;
+		uint32_t mFrame = 0;
+		bool mDisposing = false;
+
+		void _spawn() {
+			auto child = make_unique<Walker>(self, Vector((float)mFrame, (float)(seed % 11), 0), seed * 31 + mFrame, mDepth + 1);
+
+			//during the parallel update this is a pending transform
+			child->setPosition(child->getPosition() + Vector::UnitY);
+
+			auto before = getChildCount();
+			addChild(std::move(child));
+			if (getChildCount() == before) {
+				++gDeferredAdds;
+			}
+		}
+
+		void _disposeFirstChild() {
+			for (auto&& child : children) {
+				auto& walker = static_cast<Walker&>(*child);
+				if (not walker.mDisposing) {
+					walker.mDisposing = true;
+					walker.dispose();
+					return;
+				}
+			}
+		}
+	};
+
+	///runs the frames on a fresh scene and returns the final tree, in parallel when a pool is given
+	std::vector<Walker::Entry> run(optional_ref<WorkerPool> pool) {
+		TestGameState state;
+
+		auto& root = state.addChild(make_unique<Walker>(state, Vector::Zero, 0xffffffff, 0));
+		root.setParallelChildUpdate(pool.is_some(), pool);
+
+		for (auto i : range(WALKER_COUNT)) {
+			root.addChild(make_unique<Walker>(root, Vector((float)i, 0, 0), i, 1));
+		}
+
+		for (int frame = 0; frame < FRAMES; ++frame) {
+			root.onAction(0.1f);
+			state.getTransformHierarchy().update();
+		}
+
+		std::vector<Walker::Entry> entries;
+		root.snapshot(entries);
+		return entries;
+	}
+
+	void testParallelMatchesSerial() {
+		auto serial = run({});
+		CHECK(gDeferredAdds == 0);
+
+		//some walkers disposed themselves, and the rest kept some of the children they spawned
+		CHECK(serial[0].childCount < WALKER_COUNT and serial[0].childCount > WALKER_COUNT / 2);
+		CHECK(serial.size() > serial[0].childCount * 3 / 2);
+
+		WorkerPool pool(WORKER_COUNT);
+		for (int i = 0; i < RUNS; ++i) {
+			auto parallel = run(pool);
+			CHECK(parallel == serial);
+		}
+
+		//the additions went through the replay, so the parallel path ran
+		CHECK(gDeferredAdds > 0);
+	}
+}
+
+int main(int argc, char** argv) {
+	testParallelMatchesSerial();
+
+	return Tests::result();
+}
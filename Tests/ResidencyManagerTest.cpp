@@ -0,0 +1,94 @@
+#include "dojo_common_header.h"
+
+#include "ResidencyManager.h"
+#include "Resource.h"
+
+#include "TestCheck.h"
+
+using namespace Dojo;
+
+namespace {
+	///a Resource with a fixed size and no GPU data, that registers like a Texture or a Mesh does
+	class TestResource : public Resource {
+	public:
+		TestResource(ResidencyManager& manager, int bytes) :
+			Resource({}, "test"),
+			mManager(manager),
+			mBytes(bytes) {
+
+		}
+
+		virtual ~TestResource() {
+			if (loaded) {
+				onUnload();
+			}
+		}
+
+		virtual bool onLoad() override {
+			size = mBytes;
+			mManager._notifyLoaded(self);
+			return loaded = true;
+		}
+
+		//finds the manager through the resource, like the Textures and Meshes destroyed after the Platform
+		virtual void onUnload(bool soft = false) override {
+			ResidencyManager::_notifyUnloaded(self);
+			size = 0;
+			loaded = false;
+		}
+
+	private:
+		ResidencyManager& mManager;
+		int mBytes;
+	};
+
+	void testUnloadWithoutPlatform() {
+		ResidencyManager manager;
+		{
+			TestResource a(manager, 100), b(manager, 50);
+			a.onLoad();
+			b.onLoad();
+			CHECK(manager.getResidentBytes() == 150);
+
+			a.onUnload();
+			CHECK(manager.getResidentBytes() == 50);
+			CHECK(manager.getTrackedResourceCount() == 1);
+		}
+		CHECK(manager.getTrackedResourceCount() == 0);
+	}
+
+	void testEviction() {
+		ResidencyManager manager;
+		TestResource old(manager, 100), recent(manager, 100);
+		old.onLoad();
+		manager.endFrame();
+
+		recent.onLoad();
+		manager.touch(recent);
+		manager.setBudget(150);
+		manager.endFrame();
+
+		CHECK(not old.isLoaded() and old.isEvicted());
+		CHECK(recent.isLoaded());
+		CHECK(manager.getResidentBytes() == 100);
+	}
+
+	void testResourceOutlivesManager() {
+		auto manager = make_unique<ResidencyManager>();
+		TestResource resource(*manager, 100);
+		resource.onLoad();
+
+		//the unload in the destructor of the resource must not reach the destroyed manager
+		manager = {};
+		resource.onUnload();
+		CHECK(not resource.isLoaded());
+	}
+}
+
+int main(int argc, char** argv) {
+	testUnloadWithoutPlatform();
+	testEviction();
+	testResourceOutlivesManager();
+
+	return Tests::result();
+}
@@ -0,0 +1,114 @@
+#include "dojo_common_header.h"
+
+#include "SceneSnapshot.h"
+
+#include "TestCheck.h"
+#include "TestGameState.h"
+
+using namespace Dojo;
+using namespace Tests;
+
+namespace {
+	//the layout written by SceneSnapshot.cpp
+	const size_t NAME_COUNT_OFFSET = 16;
+	const size_t HEADER_SIZE = 32;
+	const size_t OBJECT_RECORD_SIZE = 60;
+	const size_t OBJECT_SIZE_OFFSET = 32;
+
+	///a root with two children, the second one has a child of its own
+	std::vector<uint8_t> makeSnapshot() {
+		TestGameState state;
+
+		auto& root = state.emplaceChild<Object>(Vector(1, 2, 3));
+		root.emplaceChild<Object>(Vector(4, 5, 6));
+		auto& second = root.emplaceChild<Object>(Vector(7, 8, 9));
+		second.emplaceChild<Object>(Vector(10, 11, 12));
+
+		return SceneSnapshot::save(root);
+	}
+
+	bool load(const std::vector<uint8_t>& snapshot) {
+		TestGameState state;
+		auto loaded = SceneSnapshot::load(state, snapshot.data(), snapshot.size());
+		return loaded.is_some();
+	}
+
+	void setParent(std::vector<uint8_t>& snapshot, size_t objectIndex, int32_t parent) {
+		memcpy(snapshot.data() + HEADER_SIZE + objectIndex * OBJECT_RECORD_SIZE, &parent, sizeof(parent));
+	}
+
+	void setSize(std::vector<uint8_t>& snapshot, size_t objectIndex, size_t axis, float value) {
+		memcpy(snapshot.data() + HEADER_SIZE + objectIndex * OBJECT_RECORD_SIZE + OBJECT_SIZE_OFFSET + axis * sizeof(float), &value, sizeof(value));
+	}
+
+	void testRoundTrip() {
+		auto snapshot = makeSnapshot();
+
+		TestGameState state;
+		auto loaded = SceneSnapshot::load(state, snapshot.data(), snapshot.size()).to_ref();
+		if (not CHECK(loaded)) {
+			return;
+		}
+
+		auto& root = loaded.get();
+		CHECK(state.getChildCount() == 1);
+		CHECK(root.getChildCount() == 2);
+		CHECK(root.getPosition() == Vector(1, 2, 3));
+	}
+
+	void testBadParents() {
+		auto snapshot = makeSnapshot();
+
+		//any negative parent other than the root's
+		setParent(snapshot, 2, -2);
+		CHECK(not load(snapshot));
+
+		//a parent that comes after its child or is the child itself
+		setParent(snapshot, 2, 3);
+		CHECK(not load(snapshot));
+		setParent(snapshot, 2, 2);
+		CHECK(not load(snapshot));
+
+		//the root can't have a parent
+		snapshot = makeSnapshot();
+		setParent(snapshot, 0, 0);
+		CHECK(not load(snapshot));
+	}
+
+	void testBadSizes() {
+		auto snapshot = makeSnapshot();
+
+		//rejected before the names are allocated
+		auto nameCount = 0xffffffffu;
+		memcpy(snapshot.data() + NAME_COUNT_OFFSET, &nameCount, sizeof(nameCount));
+		CHECK(not load(snapshot));
+
+		snapshot = makeSnapshot();
+		snapshot.resize(HEADER_SIZE + OBJECT_RECORD_SIZE);
+		CHECK(not load(snapshot));
+	}
+
+	void testBadObjectSizes() {
+		//the Objects would assert on these, the whole snapshot is rejected before any is created
+		auto snapshot = makeSnapshot();
+		setSize(snapshot, 3, 1, -1.f);
+		CHECK(not load(snapshot));
+
+		snapshot = makeSnapshot();
+		setSize(snapshot, 0, 2, std::numeric_limits<float>::quiet_NaN());
+		CHECK(not load(snapshot));
+
+		snapshot = makeSnapshot();
+		setSize(snapshot, 1, 0, 0.f);
+		CHECK(load(snapshot));
+	}
+}
+
+int main(int argc, char** argv) {
+	testRoundTrip();
+	testBadParents();
+	testBadSizes();
+	testBadObjectSizes();
+
+	return Tests::result();
+}
@@ -0,0 +1,130 @@
+#include "dojo_common_header.h"
+
+#include "TaskGraph.h"
+#include "WorkerPool.h"
+
+#include "TestCheck.h"
+
+using namespace Dojo;
+
+namespace {
+	const uint32_t WORKER_COUNT = 4;
+
+	void testDependencies() {
+		WorkerPool pool(WORKER_COUNT);
+
+		//a diamond: b and c wait for a, d waits for both
+		std::atomic<int> clock(0);
+		int a = -1, b = -1, c = -1, d = -1;
+		bool done = false;
+
+		TaskGraph graph(pool);
+		auto taskA = graph.add([&] { a = clock++; });
+		auto taskB = graph.add([&] { b = clock++; }, { taskA });
+		auto taskC = graph.add([&] { c = clock++; }, { taskA });
+		graph.add([&] { d = clock++; }, { taskB, taskC });
+
+		graph.start([&] {
+			done = true;
+		});
+		graph.wait();
+		CHECK(graph.isDone());
+
+		CHECK(a == 0);
+		CHECK(b > a and c > a);
+		CHECK(d == 3);
+
+		//the callback runs with the others of the pool
+		pool.sync();
+		CHECK(done);
+	}
+
+	void testContinuation() {
+		WorkerPool pool(WORKER_COUNT);
+
+		std::atomic<int> tasks(0);
+		int seen = -1;
+
+		TaskGraph graph(pool);
+		for (int i = 0; i < 100; ++i) {
+			graph.add([&tasks] {
+				++tasks;
+			});
+		}
+		graph.addContinuation([&] {
+			seen = tasks;
+		});
+
+		graph.start();
+		graph.wait();
+		CHECK(seen == 100);
+	}
+
+	void testWaitHelps() {
+		//the only worker is busy, so the tasks of the graph only run if the waiting thread takes them
+		WorkerPool pool(1);
+
+		std::atomic<bool> started(false), release(false);
+		pool.queue([&] {
+			started = true;
+			while (not release) {
+				std::this_thread::yield();
+			}
+		});
+
+		while (not started) {
+			std::this_thread::yield();
+		}
+
+		auto caller = std::this_thread::get_id();
+		std::atomic<int> ranOnCaller(0);
+
+		TaskGraph graph(pool);
+		auto first = graph.add([&] {
+			ranOnCaller += std::this_thread::get_id() == caller;
+		});
+		graph.add([&] {
+			ranOnCaller += std::this_thread::get_id() == caller;
+		}, { first });
+
+		graph.start();
+		graph.wait();
+		CHECK(ranOnCaller == 2);
+
+		release = true;
+		pool.sync();
+	}
+
+	void testGraphKeptByItsCallback() {
+		WorkerPool pool(WORKER_COUNT);
+
+		bool uploaded = false;
+		std::weak_ptr<TaskGraph> weak;
+		{
+			auto graph = make_shared<TaskGraph>(pool);
+			auto value = make_shared<int>(0);
+
+			graph->add([value] {
+				*value = 42;
+			});
+			graph->start([&uploaded, value, graph] {
+				uploaded = *value == 42;
+			});
+
+			weak = graph;
+		}
+
+		pool.sync();
+		CHECK(uploaded);
+		CHECK(weak.expired());
+	}
+}
+
+int main(int argc, char** argv) {
+	testDependencies();
+	testContinuation();
+	testWaitHelps();
+	testGraphKeptByItsCallback();
+
+	return Tests::result();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <iostream>
+
+namespace Tests {
+	inline int& getFailureCount() {
+		static int failures = 0;
+		return failures;
+	}
+
+	///prints the failed condition and keeps going, so one run reports every broken check
+	inline bool check(bool condition, const char* expression, const char* file, int line) {
+		if (not condition) {
+			std::cerr << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+			++getFailureCount();
+		}
+		return condition;
+	}
+
+	///the exit code of the test program
+	inline int result() {
+		if (getFailureCount() > 0) {
+			std::cerr << getFailureCount() << " checks failed" << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+#define CHECK(condition) Tests::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Game.h"
+#include "GameState.h"
+
+namespace Tests {
+	///a GameState that can be created without a Platform
+	/**
+	A GameState only keeps a reference to its Game, and making a Game needs a Platform; the tests don't touch the Game,
+	so the reference points to storage that is never constructed.
+	*/
+	class TestGameState : public Dojo::GameState {
+	public:
+		TestGameState() :
+			GameState(_getUnusedGame()) {
+
+		}
+
+	private:
+		static Dojo::Game& _getUnusedGame() {
+			static std::aligned_storage<sizeof(Dojo::Game), alignof(Dojo::Game)>::type storage;
+			return reinterpret_cast<Dojo::Game&>(storage);
+		}
+	};
+}
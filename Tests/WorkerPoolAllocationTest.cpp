@@ -0,0 +1,67 @@
+#include "dojo_common_header.h"
+
+#include "WorkerPool.h"
+
+#include "AllocationCounter.h"
+#include "TestCheck.h"
+
+using namespace Dojo;
+
+namespace {
+	const uint32_t WORKER_COUNT = 4;
+	const int JOBS_PER_ROUND = 2000;
+
+	void testQueueDoesntAllocate() {
+		WorkerPool pool(WORKER_COUNT);
+
+		std::atomic<int> tasks(0);
+		int callbacks = 0;
+
+		auto round = [&] {
+			for (int i = 0; i < JOBS_PER_ROUND; ++i) {
+				//a few captures, like most of the jobs of the engine
+				double weight = 1.5;
+				pool.queue([&tasks, i, weight] {
+					tasks += i >= 0 and weight > 0;
+				}, [&callbacks] {
+					++callbacks;
+				});
+			}
+			pool.sync();
+		};
+
+		//the first rounds grow the pools of jobs, statuses and queue nodes
+		round();
+		round();
+
+		auto before = Tests::getAllocationCount();
+		for (int i = 0; i < 10; ++i) {
+			round();
+		}
+		CHECK(Tests::getAllocationCount() == before);
+
+		CHECK(tasks == 12 * JOBS_PER_ROUND);
+		CHECK(callbacks == 12 * JOBS_PER_ROUND);
+	}
+
+	void testStdFunctionIsAllowed() {
+		WorkerPool pool(WORKER_COUNT);
+
+		//a callable too big for a job goes through a std::function, which allocates where the caller can see it
+		std::string payload(100, 'x');
+		size_t seen = 0;
+		pool.queue(std::function<void()>([payload, &seen] {
+			seen = payload.size();
+		}));
+		pool.sync();
+
+		CHECK(seen == payload.size());
+	}
+}
+
+int main(int argc, char** argv) {
+	testQueueDoesntAllocate();
+	testStdFunctionIsAllowed();
+
+	return Tests::result();
+}
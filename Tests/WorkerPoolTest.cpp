@@ -0,0 +1,165 @@
+#include "dojo_common_header.h"
+
+#include "WorkerPool.h"
+#include "range.h"
+
+#include "TestCheck.h"
+
+using namespace Dojo;
+
+namespace {
+	const uint32_t WORKER_COUNT = 4;
+
+	void testTasksAndCallbacks() {
+		WorkerPool pool(WORKER_COUNT);
+
+		std::atomic<int> tasks(0);
+		int callbacks = 0;
+
+		for (int round = 0; round < 20; ++round) {
+			for (int i = 0; i < 200; ++i) {
+				pool.queue([&pool, &tasks, i] {
+					//a few slow tasks, so that the others get stolen
+					if (i % 10 == 0) {
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+					}
+
+					//the tasks queued by a task go to its own worker
+					for (int k = 0; k < 5; ++k) {
+						pool.queue([&tasks] {
+							++tasks;
+						});
+					}
+					++tasks;
+				}, [&callbacks] {
+					++callbacks;
+				});
+			}
+			pool.sync();
+		}
+
+		CHECK(tasks == 20 * 200 * 6);
+		CHECK(callbacks == 20 * 200);
+	}
+
+	void testStatus() {
+		WorkerPool pool(1);
+
+		std::atomic<bool> release(false);
+		auto status = pool.queue([&release] {
+			while (not release) {
+				std::this_thread::yield();
+			}
+		}, [] {});
+
+		CHECK(status != AsyncJob::Status::NotRunning);
+		release = true;
+		pool.sync();
+
+		//the slot of the job is reused, the old status must not read as the next job's
+		CHECK(status == AsyncJob::Status::NotRunning);
+	}
+
+	void testParallelFor() {
+		WorkerPool pool(WORKER_COUNT);
+
+		std::vector<std::atomic<int>> visits(100000);
+		for (auto&& v : visits) {
+			v = 0;
+		}
+
+		for (auto chunkSize : { 0u, 1u, 7u, 1000u, 200000u }) {
+			pool.parallelFor((uint32_t)visits.size(), chunkSize, [&](uint32_t begin, uint32_t end) {
+				for (auto i : range(begin, end)) {
+					++visits[i];
+				}
+			});
+		}
+
+		bool exactlyOnceEach = true;
+		for (auto&& v : visits) {
+			exactlyOnceEach &= v == 5;
+		}
+		CHECK(exactlyOnceEach);
+	}
+
+	void testNestedParallelFor() {
+		WorkerPool pool(WORKER_COUNT);
+
+		std::atomic<uint32_t> inner(0);
+		pool.parallelFor(64, 1, [&](uint32_t begin, uint32_t end) {
+			pool.parallelFor(1000, 10, [&](uint32_t begin, uint32_t end) {
+				inner += end - begin;
+			});
+		});
+
+		CHECK(inner == 64 * 1000);
+	}
+
+	void testParallelForOnlyWaitsForItsChunks() {
+		WorkerPool pool(WORKER_COUNT);
+
+		//a worker holding a chunk queues unrelated jobs on its deque, where the waiting caller could steal them
+		auto caller = std::this_thread::get_id();
+		std::atomic<int> ranOnCaller(0), workerChunks(0);
+
+		auto unrelated = [&ranOnCaller, caller] {
+			if (std::this_thread::get_id() == caller) {
+				++ranOnCaller;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		};
+
+		for (int round = 0; round < 50; ++round) {
+			std::atomic<bool> queued(false);
+
+			pool.parallelFor(WORKER_COUNT * 8, 1, [&](uint32_t, uint32_t) {
+				if (std::this_thread::get_id() != caller and not queued.exchange(true)) {
+					++workerChunks;
+					for (int i = 0; i < 16; ++i) {
+						pool.queue(unrelated);
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(20));
+			});
+		}
+
+		pool.sync();
+		CHECK(workerChunks > 0);
+		CHECK(ranOnCaller == 0);
+	}
+
+	void testSyncPool() {
+		WorkerPool pool(1, false);
+
+		int order = 0, task = -1, callback = -1;
+		pool.queue([&] {
+			task = order++;
+		}, [&] {
+			callback = order++;
+		});
+
+		//a pool that isn't async only runs its tasks from the calling thread
+		CHECK(task == -1);
+		pool.sync();
+		CHECK(task == 0 and callback == 1);
+
+		uint32_t sum = 0;
+		pool.parallelFor(100, 0, [&](uint32_t begin, uint32_t end) {
+			sum += end - begin;
+		});
+		CHECK(sum == 100);
+	}
+}
+
+int main(int argc, char** argv) {
+	testTasksAndCallbacks();
+	testStatus();
+	testParallelFor();
+	testNestedParallelFor();
+	testParallelForOnlyWaitsForItsChunks();
+	testSyncPool();
+
+	return Tests::result();
+}
@@ -3,10 +3,11 @@
 #include <dojo/AnimatedQuad.h>
 #include <dojo/ApplicationListener.h>
 #include <dojo/AStar.h>
+#include <dojo/AsyncReadback.h>
 #include <dojo/SPSCQueue.h>
-#include <dojo/BackgroundWorker.h>
 #include <dojo/Base64.h>
 #include <dojo/Component.h>
+#include <dojo/ComponentPool.h>
 #include <dojo/Resource.h>
 #include <dojo/Color.h>
 #include <dojo/DebugUtils.h>
@@ -15,6 +16,7 @@
 #include <dojo/FrameSet.h>
 #include <dojo/Game.h>
 #include <dojo/GameState.h>
+#include <dojo/IndexedSet.h>
 #include <dojo/InputSystem.h>
 #include <dojo/InputSystemListener.h>
 #include <dojo/InputDevice.h>
@@ -24,9 +26,11 @@
 #include <dojo/KeyCode.h>
 #include <dojo/Log.h>
 #include <dojo/Mesh.h>
+#include <dojo/MeshArena.h>
 #include <dojo/MPSCQueue.h>
 #include <dojo/Noise.h>
 #include <dojo/Object.h>
+#include <dojo/ObjectArena.h>
 #include <dojo/Oscillator.h>
 #include <dojo/optional_ref.h>
 #include <dojo/Plane.h>
@@ -40,6 +44,9 @@
 #include <dojo/RenderState.h>
 #include <dojo/Renderable.h>
 #include <dojo/ResourceGroup.h>
+#include <dojo/SceneSnapshot.h>
+#include <dojo/SlotPool.h>
+#include <dojo/SmallFunction.h>
 #include <dojo/SoundBuffer.h>
 #include <dojo/SoundListener.h>
 #include <dojo/SoundManager.h>
@@ -49,6 +56,7 @@
 #include <dojo/StateInterface.h>
 #include <dojo/StringReader.h>
 #include <dojo/Table.h>
+#include <dojo/TaskGraph.h>
 #include <dojo/Tessellation.h>
 #include <dojo/TextArea.h>
 #include <dojo/Texture.h>
@@ -58,6 +66,7 @@
 #include <dojo/vec_view.h>
 #include <dojo/Vector.h>
 #include <dojo/Viewport.h>
+#include <dojo/WorkStealingDeque.h>
 #include <dojo/WorkerPool.h>
 #include <dojo/dojo_common_header.h>
 #include <dojo/dojo_config.h>
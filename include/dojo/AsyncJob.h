@@ -2,9 +2,19 @@
 
 #include "dojo_common_header.h"
 
+#include "SmallFunction.h"
+
 namespace Dojo {
+	///An AsyncJob is a task to run on a WorkerPool and the callback to run once it's done
+	/**
+	The status of each job lives in a slot of a global pool that is reused when the job is destroyed; each reuse bumps
+	the generation of the slot, so a StatusPtr that outlives its job reads NotRunning instead of the status of the
+	next job.
+	*/
 	class AsyncJob {
 	public:
+		typedef SmallFunction Function;
+
 		enum class Status {
 			Scheduled,
 			Running,
@@ -16,38 +26,48 @@ namespace Dojo {
 		public:
 			StatusPtr() {}
 
-			StatusPtr(std::shared_ptr<Status>& status)
-				: mStatusPtr(status) {}
-
-			operator Status() const {
-				if (auto ptr = mStatusPtr.lock()) {
-					return *ptr;
-				}
-				return Status::NotRunning;
-			}
+			operator Status() const;
 
 		private:
-			//TODO implement faster
-			std::weak_ptr<Status> mStatusPtr;
+			friend class AsyncJob;
+
+			uint32_t mSlot = NO_STATUS;
+			uint32_t mGeneration = 0;
+
+			StatusPtr(uint32_t slot, uint32_t generation) :
+				mSlot(slot),
+				mGeneration(generation) {
+
+			}
 		};
 
-		AsyncTask task;
-		AsyncCallback callback;
+		Function task;
+		Function callback;
 
 		AsyncJob() {}
-		AsyncJob(AsyncTask&& task, AsyncCallback&& callback)
-			: mStatus(make_shared<Status>(Status::Scheduled))
-			, task(std::move(task))
-			, callback(std::move(callback)) { //TODO pool the memory because it's a waste to reallocate every time
+		AsyncJob(Function&& task, Function&& callback);
 
-		}
+		AsyncJob(AsyncJob&& other);
+		AsyncJob& operator=(AsyncJob&& other);
+
+		~AsyncJob();
 
 		operator bool() const {
 			return task or callback;
 		}
 
-		std::shared_ptr<Status> mStatus;
+		void setStatus(Status status);
+
+		StatusPtr getStatus() const {
+			return{ mStatusSlot, mGeneration };
+		}
+
 	private:
+		static const uint32_t NO_STATUS = 0xffffffff;
+
+		uint32_t mStatusSlot = NO_STATUS;
+		uint32_t mGeneration = 0;
+
+		void _releaseStatus();
 	};
 }
-
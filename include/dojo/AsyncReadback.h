@@ -0,0 +1,84 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Framebuffer;
+	class Texture;
+
+	///AsyncReadback reads pixels back from the GPU without stalling the pipeline
+	/**
+	Each read issues glReadPixels into a pooled pixel pack buffer followed by a fence. A few frames later, when the fence
+	is signaled, the buffer is mapped and the pixels are handed to a task on the background pool; the buffer returns
+	to the pool once the task is done.
+	Reads are dispatched in the order they were issued. The Renderer owns an instance that is updated every frame.
+	*/
+	class AsyncReadback {
+	public:
+		struct Region {
+			uint32_t x = 0, y = 0;
+
+			///a zero size reads until the end of the surface
+			uint32_t width = 0, height = 0;
+		};
+
+		///receives RGBA8 rows, tightly packed and bottom-up, on a worker thread; the pointer is valid only during the call
+		typedef std::function<void(const uint8_t* pixels, uint32_t width, uint32_t height)> PixelTask;
+
+		static const uint32_t DEFAULT_MAX_REQUESTS_IN_FLIGHT = 4;
+
+		AsyncReadback();
+		AsyncReadback(const AsyncReadback&) = delete;
+		AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+		~AsyncReadback();
+
+		///sets how many reads can be waiting for the GPU or for their task at the same time
+		void setMaxRequestsInFlight(uint32_t count);
+
+		uint32_t getMaxRequestsInFlight() const {
+			return mMaxRequestsInFlight;
+		}
+
+		///returns the amount of reads that haven't completed their callback yet
+		uint32_t getRequestsInFlight() const {
+			return mRequestsInFlight;
+		}
+
+		///returns true if a read issued now would be accepted
+		bool canRead() const {
+			return mRequestsInFlight < mMaxRequestsInFlight;
+		}
+
+		///reads a region of the first color attachment of framebuffer
+		/**
+		task runs on the background pool, callback on the main thread when the task is done; if the GPU fails to complete
+		the read, only callback is run.
+		\returns false if too many reads are in flight */
+		bool read(Framebuffer& framebuffer, const Region& region, PixelTask task, AsyncCallback callback = {});
+
+		///reads a region of the base level of texture
+		bool read(Texture& texture, const Region& region, PixelTask task, AsyncCallback callback = {});
+
+		///dispatches the reads that the GPU completed
+		void update();
+
+		///waits for all the issued reads and dispatches them
+		void flush();
+
+	private:
+		struct Request;
+
+		std::vector<Shared<Request>> mRequests;
+		std::deque<Shared<Request>> mIssued;
+
+		uint32_t mMaxRequestsInFlight = DEFAULT_MAX_REQUESTS_IN_FLIGHT;
+		uint32_t mRequestsInFlight = 0;
+
+		uint32_t mReadFBO = 0;
+
+		Shared<Request> _acquire(size_t bytes);
+		bool _issue(uint32_t surfaceWidth, uint32_t surfaceHeight, const Region& region, PixelTask&& task, AsyncCallback&& callback);
+		bool _tryDispatch(const Shared<Request>& owner, bool wait);
+	};
+}
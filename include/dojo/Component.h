@@ -2,6 +2,8 @@
 
 #include "dojo_common_header.h"
 
+#include "ObjectArena.h"
+
 namespace Dojo {
 	class Object;
 
@@ -25,6 +27,23 @@ namespace Dojo {
 
 		virtual ~Component() {}
 
+		///Components can live on the heap or in the ObjectArena of their GameState, see Object::emplaceComponent
+		static void* operator new(size_t size) {
+			return ObjectArena::allocateFromHeap(size);
+		}
+
+		static void* operator new(size_t size, ObjectArena& arena) {
+			return arena.allocate(size);
+		}
+
+		static void operator delete(void* ptr) {
+			ObjectArena::free(ptr);
+		}
+
+		static void operator delete(void* ptr, ObjectArena& arena) {
+			ObjectArena::free(ptr);
+		}
+
 		Object& getObject() {
 			return object;
 		}
@@ -42,6 +61,12 @@ namespace Dojo {
 		virtual bool canDestroy() const {
 			return true;
 		}
+
+	private:
+		friend class ComponentPool;
+
+		///the index of this Component in the ComponentPool of its GameState
+		uint32_t mPoolIndex = 0;
 	};
 }
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Component.h"
+#include "SpinLock.h"
+
+namespace Dojo {
+	///ComponentPool owns all the Components of one type in a GameState and keeps them in a dense array
+	/**
+	Components are polymorphic and created by their users, so the pool keeps pointers to them; the ones made with
+	Object::emplaceComponent are close in memory anyway, as they come from the ObjectArena.
+	Each Component knows its index in the array of the pool and a removal moves the last element in the hole, so both
+	adding and removing are O(1), and a system like the update of the Renderer can iterate all the Components of its
+	type without walking the Objects.
+	Adding and removing are thread safe, so that Objects can be created during a parallel update.
+	*/
+	class ComponentPool {
+	public:
+		typedef std::vector<Unique<Component>> ComponentList;
+
+		ComponentPool();
+		ComponentPool(const ComponentPool&) = delete;
+		ComponentPool& operator=(const ComponentPool&) = delete;
+
+		///takes ownership of a Component and returns it
+		Component& add(Unique<Component> component);
+
+		///gives a Component back to the caller
+		Unique<Component> remove(Component& component);
+
+		size_t size() const {
+			return mComponents.size();
+		}
+
+		///calls func with each Component of the pool as a T, no Component can be added or removed meanwhile
+		template<class T, class F>
+		void forEach(F&& func) const {
+			for (auto&& component : mComponents) {
+				func(static_cast<T&>(*component));
+			}
+		}
+
+	private:
+		ComponentList mComponents;
+		SpinLock mLock;
+	};
+}
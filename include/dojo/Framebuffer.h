@@ -11,6 +11,8 @@ namespace Dojo {
 		struct TextureAttachment {
 			Texture* texture;
 			uint8_t miplevel;
+			///the handle generation of the texture when it was attached
+			uint32_t handleGeneration;
 		};
 
 		~Framebuffer();
@@ -59,7 +61,8 @@ namespace Dojo {
 		
 		uint32_t mFBO = 0;
 
-	private:
+		///attaches again the textures that got a new GL handle since they were attached
+		void _refreshAttachments();
 	};
 }
 
@@ -12,6 +12,7 @@
 #include "dojo_common_header.h"
 
 #include "Object.h"
+#include "ComponentPool.h"
 #include "ResourceGroup.h"
 #include "StateInterface.h"
 
@@ -57,6 +58,22 @@ namespace Dojo {
 			return game;
 		}
 
+		///returns the storage of the transforms of all the Objects in this GameState
+		TransformHierarchy& getTransformHierarchy() {
+			return *mTransformHierarchy;
+		}
+
+		///returns the arena used by Object::emplaceChild and Object::emplaceComponent
+		ObjectArena& getObjectArena() {
+			return *mObjectArena;
+		}
+
+		///returns the pool that owns the Components with the given ComponentID
+		ComponentPool& getComponentPool(int ID) {
+			DEBUG_ASSERT(ID >= 0 and ID < ComponentID::_count, "Invalid ComponentID");
+			return mComponentPools[ID];
+		}
+
 		///returns the Viewport that is primary on this GameState
 		optional_ref<Viewport> getViewport() const {
 			return camera;
@@ -84,12 +101,24 @@ namespace Dojo {
 
 	private:
 
-		typedef std::vector<TouchArea*> TouchAreaList;
+		struct TouchAreaSlot {
+			template <class T>
+			static uint32_t& get(T& touchArea) {
+				return touchArea._getGameStateSlot();
+			}
+		};
+
+		typedef IndexedSet<TouchArea*, TouchAreaSlot> TouchAreaList;
 
 		TouchAreaList mTouchAreas;
 
 		Game& game;
 
 		optional_ref<Viewport> camera;
+
+		//the arena is declared first so that it outlives the pools and the transforms
+		Unique<ObjectArena> mObjectArena;
+		Unique<TransformHierarchy> mTransformHierarchy;
+		std::array<ComponentPool, ComponentID::_count> mComponentPools;
 	};
 }
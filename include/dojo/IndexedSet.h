@@ -0,0 +1,134 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///IndexedSet is an unordered set of pointers to objects that remember their own position in it
+	/**
+	SlotOf::get(element) returns a reference to the uint32_t where the element keeps its slot, so contains() and
+	remove() need no search: a removal moves the last element in the hole and fixes its slot, in O(1).
+	An object can be in one IndexedSet for each slot it stores.
+	*/
+	template <class T, class SlotOf>
+	class IndexedSet {
+	public:
+		typedef std::vector<T> Container;
+		typedef typename Container::iterator iterator;
+		typedef typename Container::const_iterator const_iterator;
+		typedef typename std::remove_reference<decltype(*std::declval<T&>())>::type Element;
+
+		static const uint32_t NO_SLOT = 0xffffffff;
+
+		IndexedSet() {}
+
+		IndexedSet(const IndexedSet&) = delete;
+		IndexedSet& operator=(const IndexedSet&) = delete;
+
+		//the slots stay valid when the container is moved
+		IndexedSet(IndexedSet&&) = default;
+		IndexedSet& operator=(IndexedSet&&) = default;
+
+		bool contains(Element& elem) const {
+			auto slot = SlotOf::get(elem);
+			return slot < c.size() and &*c[slot] == &elem;
+		}
+
+		template <class... Args>
+		T& emplace(Args&& ... args) {
+			c.emplace_back(std::forward<Args>(args)...);
+			SlotOf::get(*c.back()) = (uint32_t)(c.size() - 1);
+			return c.back();
+		}
+
+		///removes an element and gives it back to the caller
+		T remove(Element& elem) {
+			DEBUG_ASSERT(contains(elem), "The element is not in this set");
+
+			auto& slot = SlotOf::get(elem);
+			T removed = std::move(c[slot]);
+
+			if (slot + 1 < c.size()) {
+				c[slot] = std::move(c.back());
+				SlotOf::get(*c[slot]) = slot;
+			}
+			c.pop_back();
+
+			slot = NO_SLOT;
+			return removed;
+		}
+
+		///removes an element if it is in the set
+		void erase(Element& elem) {
+			if (contains(elem)) {
+				remove(elem);
+			}
+		}
+
+		///removes the elements for which pred returns true in a single pass, keeping the order of the others
+		/**
+		pred can take the ownership of the elements it removes */
+		template <class Pred>
+		void eraseIf(Pred pred) {
+			uint32_t kept = 0;
+			for (auto&& elem : c) {
+				auto& e = *elem;
+				if (pred(elem)) {
+					SlotOf::get(e) = NO_SLOT;
+				}
+				else {
+					if (&c[kept] != &elem) {
+						c[kept] = std::move(elem);
+					}
+					SlotOf::get(e) = kept++;
+				}
+			}
+
+			c.erase(c.begin() + kept, c.end());
+		}
+
+		T& operator[](size_t idx) {
+			return c[idx];
+		}
+
+		const T& operator[](size_t idx) const {
+			return c[idx];
+		}
+
+		iterator begin() {
+			return c.begin();
+		}
+
+		const_iterator begin() const {
+			return c.begin();
+		}
+
+		iterator end() {
+			return c.end();
+		}
+
+		const_iterator end() const {
+			return c.end();
+		}
+
+		size_t size() const {
+			return c.size();
+		}
+
+		bool empty() const {
+			return c.empty();
+		}
+
+		void clear() {
+			for (auto&& elem : c) {
+				SlotOf::get(*elem) = NO_SLOT;
+			}
+			c.clear();
+		}
+
+	private:
+		Container c;
+	};
+
+	template <class T, class SlotOf>
+	const uint32_t IndexedSet<T, SlotOf>::NO_SLOT;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "MappedFile.h"
+#include "PixelFormat.h"
+
+namespace Dojo {
+	///KTXFile reads the mip levels of a 2D texture stored in a KTX 1.1 or KTX 2.0 container
+	/**
+	The file is memory mapped and the levels point straight into the mapping, so they can be handed to GL without copies.
+	Only single-face, single-layer textures without supercompression are supported.
+	The rows of uncompressed levels are padded to 4 bytes in KTX 1.1 files and packed in KTX 2.0 ones.
+	*/
+	class KTXFile {
+	public:
+		struct Level {
+			uint32_t width, height;
+			const uint8_t* data;
+			size_t byteSize;
+		};
+
+		static bool isKTXPath(utf::string_view path);
+
+		explicit KTXFile(utf::string_view path);
+
+		///maps and parses the file, returns false if it can't be read or describes an unsupported layout
+		bool open();
+
+		PixelFormat getFormat() const {
+			return mFormat;
+		}
+
+		uint32_t getWidth() const {
+			return mLevels.empty() ? 0 : mLevels[0].width;
+		}
+
+		uint32_t getHeight() const {
+			return mLevels.empty() ? 0 : mLevels[0].height;
+		}
+
+		///the levels are only valid as long as this KTXFile is alive
+		const std::vector<Level>& getLevels() const {
+			return mLevels;
+		}
+
+		///the GL_UNPACK_ALIGNMENT that matches the rows of the uncompressed levels
+		uint32_t getRowAlignment() const {
+			return mRowAlignment;
+		}
+
+		///returns the data of a level with packed rows, copying them in buffer if the file pads them
+		const uint8_t* getPackedData(const Level& level, std::vector<uint8_t>& buffer) const;
+
+	private:
+		MappedFile mFile;
+
+		PixelFormat mFormat = PixelFormat::Unknown;
+		std::vector<Level> mLevels;
+		uint32_t mRowAlignment = 1;
+
+		///false if the level is too small for its dimensions, the uploads would read past it
+		bool _isComplete(const Level& level) const;
+
+		bool _parseKTX1();
+		bool _parseKTX2();
+	};
+}
@@ -2,32 +2,98 @@
 
 #include "dojo_common_header.h"
 
-#include "SPSCQueue.h"
-#include "SpinLock.h"
+#include "SlotPool.h"
 
 namespace Dojo {
-	///A multi-producer single-consumer queue which is actually just a shim+spinlock over SPSCQueue.
-	//TODO actually implement without the spinlock?
-	template <typename T, size_t MAX_BLOCK_SIZE = 512>
+	///A lock-free multi-producer single-consumer queue
+	/**
+	It's Vyukov's intrusive linked list: a producer swaps its node in as the new head with one exchange, then links
+	the previous head to it; the consumer follows the links from the tail and gives back the nodes it leaves behind.
+	The nodes come from a SlotPool and are linked by index, so enqueue() only allocates when more elements are queued
+	at once than ever before; it never waits on the other producers.
+	It holds up to SEGMENT_SIZE * SlotPool::MAX_SEGMENTS elements at once, enqueue() throws std::bad_alloc past that.
+	A producer that is preempted between the exchange and the link hides the elements queued after it until it runs
+	again, try_dequeue() then returns false as if the queue was empty.
+	*/
+	template <typename T, uint32_t SEGMENT_SIZE = 1024>
 	class MPSCQueue {
 	public:
-		MPSCQueue() {}
+		MPSCQueue() {
+			//the stub node, the tail is always a node whose value was already taken
+			mTail = mNodes.acquire();
+			mNodes[mTail].next.store(NONE, std::memory_order_relaxed);
+			mHead.store(mTail, std::memory_order_relaxed);
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		~MPSCQueue() {
+			auto index = mNodes[mTail].next.load(std::memory_order_acquire);
+			while (index != NONE) {
+				auto& node = mNodes[index];
+				node.value().~T();
+				index = node.next.load(std::memory_order_relaxed);
+			}
+		}
 
+		///adds an element, any thread can call it
 		template <class... Args>
 		void enqueue(Args&& ... args) {
-			std::lock_guard<SpinLock> lock(mSpinLock);
-			mQueue.enqueue(std::forward<Args>(args)...);
+			auto index = mNodes.acquire();
+			auto& node = mNodes[index];
+			node.next.store(NONE, std::memory_order_relaxed);
+			new (&node.storage) T(std::forward<Args>(args)...);
+
+			auto previous = mHead.exchange(index, std::memory_order_acq_rel);
+			mNodes[previous].next.store(index, std::memory_order_release);
 		}
 
+		///takes the oldest element, only one thread can call it
 		template <typename U>
 		bool try_dequeue(U& result) {
-			return mQueue.try_dequeue(result);
+			auto tail = mTail;
+			auto next = mNodes[tail].next.load(std::memory_order_acquire);
+			if (next == NONE) {
+				return false;
+			}
+
+			//next becomes the empty node at the tail, its value is moved out and destroyed now
+			auto& node = mNodes[next];
+			result = std::move(node.value());
+			node.value().~T();
+
+			//the producer that linked next is done with the old tail
+			mTail = next;
+			mNodes.release(tail);
+			return true;
 		}
 
 	private:
+		static const uint32_t NONE = 0xffffffff;
 
-		SpinLock mSpinLock;
-		SPSCQueue<T, MAX_BLOCK_SIZE> mQueue;
+		struct Node {
+			std::atomic<uint32_t> next;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+			Node() :
+				next(NONE) {
+
+			}
+
+			///the value is built and destroyed by the queue, the node at the tail has none
+			T& value() {
+				return *reinterpret_cast<T*>(&storage);
+			}
+		};
+
+		SlotPool<Node, SEGMENT_SIZE> mNodes;
+
+		///the producers only touch the head, the consumer only the tail
+		std::atomic<uint32_t> mHead;
+		uint32_t mTail;
 	};
-}
 
+	template <typename T, uint32_t SEGMENT_SIZE>
+	const uint32_t MPSCQueue<T, SEGMENT_SIZE>::NONE;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///A read-only view of a whole file mapped in memory
+	/**
+	if the file can't be mapped (eg. it lives in a zip) its content is read in a private buffer instead, so the
+	caller always sees a contiguous range of bytes.
+	*/
+	class MappedFile {
+	public:
+		explicit MappedFile(utf::string_view path);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile();
+
+		///maps the file, returns false if it could not be opened
+		bool open();
+
+		void close();
+
+		bool isOpen() const {
+			return mData != nullptr;
+		}
+
+		///true if the data points straight into the OS file cache instead of a copy
+		bool isMapped() const {
+			return mMapped;
+		}
+
+		const uint8_t* data() const {
+			return mData;
+		}
+
+		size_t size() const {
+			return mSize;
+		}
+
+	private:
+		utf::string mPath;
+
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		bool mMapped = false;
+
+		std::vector<uint8_t> mFallbackBuffer;
+
+#ifdef WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#endif
+	};
+}
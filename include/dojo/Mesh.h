@@ -16,6 +16,7 @@
 #include "VertexField.h"
 #include "PrimitiveMode.h"
 #include "AABB.h"
+#include "MeshArena.h"
 
 namespace Dojo {
 	class Color;
@@ -32,16 +33,132 @@ namespace Dojo {
 	After a Vertex Format has been defined, a Mesh can be procedurally generated by calling the vertex() method which adds a new vertex,
 	and specifying vertex features using color(), normal() and uv() methods.
 
+	When the size of a block is known up front, append() reserves its vertices and indices at once and returns a Writer
+	to fill them, which is much faster than adding one vertex at a time.
+
+	Small static meshes are placed in the MeshArena of the Renderer instead of owning their buffers.
+
 	Calling end() is required before the mesh can be used, so that its data is loaded to the GPU.
 	*/
 	class Mesh : public Resource {
 	public:
 		static bool gBufferBindingsDirty;
 		typedef unsigned int IndexType;
+		///the xyz components of a VertexField::PositionQuantized vertex, w is padding
+		typedef std::array<uint16_t, 4> QuantizedPosition;
 
 		static const int VERTEX_PAGE_SIZE = 256;
 		static const int INDEX_PAGE_SIZE = 256;
 
+		///returns the size in bytes of a field in the vertex layout
+		static uint8_t getVertexFieldSize(VertexField field);
+
+		///packs a normal in the signed 10-10-10-2 format used by VertexField::Normal
+		static uint32_t packNormal(const Vector& n);
+
+		///packs a normal in the two signed 16 bit octahedral coordinates used by VertexField::NormalOctahedral
+		/**
+			A shader decodes it with:
+			vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+			float t = max(-n.z, 0.0);
+			n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+			n = normalize(n);
+		*/
+		static uint32_t packNormalOctahedral(const Vector& n);
+
+		///quantizes a position to the 16 bit normalized values used by VertexField::PositionQuantized
+		static QuantizedPosition packPositionQuantized(const Vector& v, const AABB& extent);
+
+		///a mesh is split only if its submeshes have at least this many indices on average, to be worth the extra draws
+		static const uint32_t MIN_SUBMESH_INDICES = 1 << 14;
+
+		///a range of 16 bit indices drawn with its own base vertex
+		struct Submesh {
+			uint32_t indexStart, indexCount;
+			IndexType baseVertex;
+		};
+
+		///a strided view over one VertexField in a block of vertices
+		template<class T>
+		class FieldView {
+		public:
+			FieldView(uint8_t* first, uint8_t stride) :
+				mFirst(first),
+				mStride(stride) {
+
+			}
+
+			T& operator[](size_t i) const {
+				return *(T*)(mFirst + i * mStride);
+			}
+
+		private:
+			uint8_t* mFirst;
+			uint8_t mStride;
+		};
+
+		///Writer fills a block of vertices and indices reserved with append()
+		/**
+		Vertex and index positions are relative to the block. Bounds are not tracked per vertex: the mesh computes them
+		in a single pass in end().
+		The Writer is invalidated by anything else that adds vertices or indices to the Mesh.
+		*/
+		class Writer {
+		public:
+			///the index in the Mesh of the first vertex of the block
+			const IndexType firstVertex;
+			const IndexType vertexCount;
+			const uint32_t indexCount;
+
+			///returns a typed view over the given field of all the vertices in the block
+			template<class T>
+			FieldView<T> field(VertexField f, uint8_t set = 0) const {
+				DEBUG_ASSERT(mMesh.isVertexFieldEnabled((VertexField)(enum_cast(f) + set)), "This field is not enabled");
+				return{ mVertices + mMesh.vertexFieldOffset[enum_cast(f) + set], mMesh.vertexSize };
+			}
+
+			void position(IndexType i, const Vector& v) {
+				DEBUG_ASSERT(i < vertexCount, "Vertex out of the block");
+				if (mQuantized) {
+					//encoded in end(), when the bounds are known
+					mMesh.mSourcePositions[firstVertex + i] = v;
+				}
+				else if (mIs3D) {
+					field<glm::vec3>(VertexField::Position3D)[i] = v;
+				}
+				else {
+					field<glm::vec2>(VertexField::Position2D)[i] = { v.x, v.y };
+				}
+			}
+
+			void uv(IndexType i, float u, float v, uint8_t set = 0) {
+				DEBUG_ASSERT(i < vertexCount, "Vertex out of the block");
+				field<uint32_t>(VertexField::UV0, set)[i] = glm::packHalf2x16({ u, v });
+			}
+
+			void color(IndexType i, const Color& c);
+
+			void normal(IndexType i, const Vector& n);
+
+			///writes indices starting from the slot start, adding firstVertex to each of them
+			void indices(uint32_t start, std::initializer_list<IndexType> local);
+
+			///writes 2 clockwise triangles (6 indices) starting from the slot start, like Mesh::quad
+			void quad(uint32_t start, IndexType i11, IndexType i12, IndexType i21, IndexType i22) {
+				indices(start, { i11, i21, i12, i21, i22, i12 });
+			}
+
+		private:
+			friend class Mesh;
+
+			Mesh& mMesh;
+			uint8_t* mVertices;
+			uint8_t* mIndices;
+			bool mIs3D, mQuantized;
+
+			Writer(Mesh& mesh, IndexType firstVertex, IndexType vertexCount, uint32_t firstIndex, uint32_t indexCount);
+		};
+
 		///Creates a new empty Mesh
 		explicit Mesh(optional_ref<ResourceGroup> creator = {});
 
@@ -59,6 +176,18 @@ namespace Dojo {
 		*/
 		void setIndexByteSize(uint8_t bytenumber);
 
+		///lets end() pick the narrowest index type that fits the indices written
+		/**
+			Indices are kept in 32 bits on the CPU and repacked when they are uploaded; list meshes that need more than
+			16 bits are split in 16 bit addressable submeshes when that is cheaper.
+			MUST be called before begin.
+		*/
+		void setAutoIndexSize(bool enabled);
+
+		bool isAutoIndexSize() const {
+			return mAutoIndexSize;
+		}
+
 		///enables a new VertexField
 		void setVertexFieldEnabled(VertexField f);
 
@@ -85,6 +214,16 @@ namespace Dojo {
 			return bounds;
 		}
 
+		///the scale to apply to a VertexField::PositionQuantized to decode it
+		Vector getPositionDecodeScale() const {
+			return mQuantizationBounds.getSize();
+		}
+
+		///the offset to add to a scaled VertexField::PositionQuantized to decode it
+		const Vector& getPositionDecodeOffset() const {
+			return mQuantizationBounds.min;
+		}
+
 		const Vector& getDimensions() const {
 			return dimensions;
 		}
@@ -106,7 +245,7 @@ namespace Dojo {
 		/**
 		\param extimatedVertes number of vertices that have to be reserved
 		*/
-		void begin(IndexType extimatedVerts = 1);
+		void begin(IndexType extimatedVerts = 1, uint32_t extimatedIndices = 0);
 
 		///starts editing a dynamic mesh that was already begin'd and end'ed
 		/**
@@ -117,6 +256,9 @@ namespace Dojo {
 		///adds a vertex at the given position
 		IndexType vertex(const Vector& v);
 
+		///adds a block of vertices and indices at once and returns a Writer to fill it
+		Writer append(IndexType vertexCount, uint32_t indexCount = 0);
+
 		///sets the uv of the given UV set
 		void uv(float u, float v, uint8_t set = 0);
 
@@ -167,15 +309,37 @@ namespace Dojo {
 		virtual void bind();
 
 		///binds the attribute arrays and the Buffer Objects required to render the mesh
-		void bindVertexFormat(const Shader& shader);
+		/**
+			baseVertex offsets the attributes, to draw a Submesh
+		*/
+		void bindVertexFormat(const Shader& shader, IndexType baseVertex = 0);
 
 
 		bool isIndexed() const {
-			return not indices.empty() or indexHandle;
+			return not indices.empty() or indexHandle or mArenaAllocation.indexCount > 0;
+		}
+
+		///the type of the indices on the GPU
+		uint32_t getIndexGLType() const;
+
+		///the first vertex to draw in the vertex buffer, not 0 when the mesh is in the MeshArena
+		uint32_t getFirstVertex() const {
+			return mArenaAllocation.firstVertex;
 		}
 
-		uint32_t getIndexGLType() const {
-			return indexGLType;
+		///the byte offset of the first index to draw in the index buffer
+		uintptr_t getIndexBufferOffset() const {
+			return mArenaAllocation.firstIndex * sizeof(uint16_t);
+		}
+
+		///true if drawing other after this mesh needs no buffer binding nor vertex format changes
+		bool sharesBuffersWith(const Mesh& other) const {
+			return this == &other or mArenaAllocation.sharesPageWith(other.mArenaAllocation);
+		}
+
+		///returns the submeshes to draw one by one, empty if the mesh is drawn in a single call
+		const std::vector<Submesh>& getSubmeshes() const {
+			return mSubmeshes;
 		}
 
 		bool isVertexFieldEnabled(VertexField f) const {
@@ -223,6 +387,9 @@ namespace Dojo {
 		std::vector<uint8_t> indices;//indices have varying size
 
 		uint32_t vertexHandle = 0, indexHandle = 0;
+		MeshArena::Allocation mArenaAllocation;
+		///the arena of mArenaAllocation, kept to free it when the Platform is already gone
+		MeshArena* mArena = nullptr;
 
 		int vertexCount = 0, indexCount = 0;
 
@@ -234,7 +401,30 @@ namespace Dojo {
 		bool editing = false;
 		bool vertexTransparency = false;
 
-		void _prepareVertex(const Vector& v);
+		///the first vertex that isn't accounted for in bounds yet
+		int mBoundsStart = 0;
+
+		bool mAutoIndexSize = false;
+		IndexType mMaxIndex = 0;
+		std::vector<uint8_t> mPackedIndices;
+		std::vector<Submesh> mSubmeshes;
+
+		///quantized meshes keep full positions while they're edited
+		std::vector<Vector> mSourcePositions;
+		AABB mQuantizationBounds;
+
+		bool _isQuantized() const {
+			return isVertexFieldEnabled(VertexField::PositionQuantized);
+		}
+
+		void _quantizePositions();
+		void _packIndices();
+		bool _splitSubmeshes(const uint32_t* source);
+
+		void _prepareVertex();
+		void _updateBounds();
+
+		bool _uploadToGPU(const uint8_t* vertexData, size_t vertexBytes, const uint8_t* indexData, size_t indexBytes);
 
 		template<class T>
 		T& _field(VertexField field, uint8_t set = 0) {
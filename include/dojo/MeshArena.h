@@ -0,0 +1,118 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "VertexField.h"
+#include "enum_cast.h"
+
+namespace Dojo {
+	///The MeshArena suballocates small static Meshes from a few large GL buffers shared by the Meshes with the same layout
+	/**
+	Each page is a vertex buffer of PAGE_VERTICES vertices and a 16 bit index buffer. GLES 3 has no base vertex draws,
+	so the indices are rebased on the first vertex of the mesh in the page when they are uploaded; consecutive draws
+	of meshes in the same page then need no buffer binding and no attribute specification.
+	The Renderer owns an instance, Meshes place themselves in it when they are uploaded.
+	*/
+	class MeshArena {
+	private:
+		struct Page;
+
+	public:
+		///the largest mesh that is placed in the arena, bigger ones are better off with their own buffers
+		static const uint32_t MAX_MESH_VERTICES = 4096;
+		///vertices in a page, small enough that any rebased index fits in 16 bits
+		static const uint32_t PAGE_VERTICES = 0x4000;
+		static const uint32_t PAGE_INDICES = PAGE_VERTICES * 3;
+
+		typedef std::array<uintptr_t, enum_cast(VertexField::_Count)> FieldOffsets;
+
+		///the vertex layout of a page
+		struct Layout {
+			uint32_t vertexSize;
+			FieldOffsets fieldOffsets;
+
+			bool operator==(const Layout& other) const {
+				return vertexSize == other.vertexSize and fieldOffsets == other.fieldOffsets;
+			}
+		};
+
+		///the place of a mesh in the arena
+		struct Allocation {
+			uint32_t firstVertex = 0, vertexCount = 0;
+			uint32_t firstIndex = 0, indexCount = 0;
+
+			bool isValid() const {
+				return page != nullptr;
+			}
+
+			///true if both allocations are in the same buffers
+			bool sharesPageWith(const Allocation& other) const {
+				return page and page == other.page;
+			}
+
+		private:
+			friend class MeshArena;
+			Page* page = nullptr;
+		};
+
+		struct Stats {
+			uint32_t pages = 0;
+			uint32_t allocations = 0;
+			size_t capacityBytes = 0, usedBytes = 0;
+
+			///free ranges across all the pages, vertices and indices
+			uint32_t freeBlocks = 0;
+			size_t largestFreeBlockBytes = 0;
+
+			///the fraction of the free bytes outside the largest free range of their buffer, 0 when nothing is fragmented
+			float fragmentation = 0;
+		};
+
+		MeshArena();
+		MeshArena(const MeshArena&) = delete;
+		MeshArena& operator=(const MeshArena&) = delete;
+
+		~MeshArena();
+
+		///uploads the vertices and the rebased indices of a mesh
+		/**
+		indexByteSize is the size of each index in indexData, 1, 2 or 4.
+		\returns an invalid Allocation if the mesh is too big for the arena */
+		Allocation allocate(const Layout& layout, const uint8_t* vertexData, uint32_t vertexCount, const uint8_t* indexData, uint32_t indexCount, uint8_t indexByteSize);
+
+		///releases the ranges of the allocation, and the page once it's empty
+		void free(Allocation& allocation);
+
+		///binds the vertex and index buffers of the page that contains allocation
+		void bind(const Allocation& allocation) const;
+
+		///returns the occupancy and the fragmentation of the pages
+		Stats getStats() const;
+
+	private:
+		///a first fit list of the free ranges in a buffer, sorted by start
+		struct FreeList {
+			struct Range {
+				uint32_t start, count;
+			};
+
+			std::vector<Range> ranges;
+
+			explicit FreeList(uint32_t capacity);
+
+			bool allocate(uint32_t count, uint32_t& start);
+			void release(uint32_t start, uint32_t count);
+		};
+
+		struct Page {
+			Layout layout;
+			uint32_t vertexHandle = 0, indexHandle = 0;
+			FreeList vertices, indices;
+			uint32_t allocations = 0;
+
+			explicit Page(const Layout& layout);
+		};
+
+		std::vector<Unique<Page>> mPages;
+	};
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "MappedFile.h"
+#include "AABB.h"
+#include "PrimitiveMode.h"
+#include "VertexField.h"
+
+namespace Dojo {
+	///MeshFile reads the binary .mesh container, both in the versioned v2 layout and in the legacy unversioned one
+	/**
+	A v2 file starts with a fixed header followed by a table of sections; every section begins on a 16 bytes boundary,
+	so the file can be memory mapped and its vertex and index streams handed straight to glBufferData.
+	All values are little endian.
+	*/
+	class MeshFile {
+	public:
+		static const uint32_t VERSION = 2;
+		static const size_t ALIGNMENT = 16;
+
+		enum class SectionType : uint32_t {
+			VertexStream = 1,
+			Indices,
+			Bounds,
+			LODs,
+			Submeshes
+		};
+
+		///a range of indices to use at a given distance
+		struct LOD {
+			uint32_t indexStart, indexCount;
+			float maxDistance;
+			uint32_t reserved;
+		};
+
+		///a range of the mesh that can be drawn on its own
+		struct Submesh {
+			uint32_t indexStart, indexCount;
+			uint32_t vertexStart, vertexCount;
+		};
+
+		///everything needed to write a v2 file
+		struct Description {
+			uint8_t indexByteSize = 2;
+			PrimitiveMode primitiveMode = PrimitiveMode::TriangleList;
+			std::vector<VertexField> fields;
+			uint32_t vertexStride = 0;
+			uint32_t vertexCount = 0, indexCount = 0;
+
+			const uint8_t* vertices = nullptr;
+			const uint8_t* indices = nullptr;
+
+			AABB bounds;
+
+			std::vector<LOD> lods;
+			std::vector<Submesh> submeshes;
+		};
+
+		///serializes a mesh in the v2 layout
+		static std::vector<uint8_t> serialize(const Description& desc);
+
+		///converts the content of a legacy .mesh file to the v2 layout, returns false if the data is not a valid legacy mesh
+		static bool convertLegacy(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+		explicit MeshFile(utf::string_view path);
+
+		///maps and parses the file, returns false if it can't be read or is malformed
+		bool open();
+
+		///returns 1 for legacy files
+		uint32_t getVersion() const {
+			return mVersion;
+		}
+
+		uint8_t getIndexByteSize() const {
+			return mIndexByteSize;
+		}
+
+		PrimitiveMode getPrimitiveMode() const {
+			return mPrimitiveMode;
+		}
+
+		bool isFieldEnabled(VertexField field) const {
+			return (mFieldMask & (1 << (uint32_t)field)) != 0;
+		}
+
+		uint32_t getVertexStride() const {
+			return mVertexStride;
+		}
+
+		uint32_t getVertexCount() const {
+			return mVertexCount;
+		}
+
+		uint32_t getIndexCount() const {
+			return mIndexCount;
+		}
+
+		const AABB& getBounds() const {
+			return mBounds;
+		}
+
+		///the streams are only valid as long as this MeshFile is alive
+		const uint8_t* getVertexData() const {
+			return mVertexData;
+		}
+
+		size_t getVertexDataSize() const {
+			return (size_t)mVertexCount * mVertexStride;
+		}
+
+		const uint8_t* getIndexData() const {
+			return mIndexData;
+		}
+
+		size_t getIndexDataSize() const {
+			return (size_t)mIndexCount * mIndexByteSize;
+		}
+
+		const std::vector<LOD>& getLODs() const {
+			return mLODs;
+		}
+
+		const std::vector<Submesh>& getSubmeshes() const {
+			return mSubmeshes;
+		}
+
+	private:
+		Unique<MappedFile> mFile;
+
+		uint32_t mVersion = 0;
+		uint8_t mIndexByteSize = 2;
+		PrimitiveMode mPrimitiveMode = PrimitiveMode::TriangleList;
+		uint32_t mFieldMask = 0;
+		uint32_t mVertexStride = 0, mVertexCount = 0, mIndexCount = 0;
+
+		AABB mBounds;
+
+		const uint8_t* mVertexData = nullptr;
+		const uint8_t* mIndexData = nullptr;
+
+		std::vector<LOD> mLODs;
+		std::vector<Submesh> mSubmeshes;
+
+		///parses data in memory without a backing file
+		MeshFile() {}
+
+		bool _parse(const uint8_t* data, size_t size);
+		bool _parseV2(const uint8_t* data, size_t size);
+		bool _parseLegacy(const uint8_t* data, size_t size);
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "PixelFormat.h"
+
+namespace Dojo {
+	///A MipChain holds the CPU-side mip levels of a texture, ready to be uploaded
+	/**
+	Levels are stored as raw blobs in the source layout of their PixelFormat, so a chain can also carry data that was
+	already mipped offline and doesn't need to be generated.
+	*/
+	class MipChain {
+	public:
+		struct Level {
+			uint32_t width, height;
+			std::vector<uint8_t> data;
+		};
+
+		///returns the amount of levels in a full chain for an image of the given size, down to 1x1
+		static uint32_t getLevelCountFor(uint32_t width, uint32_t height);
+
+		///returns true if the CPU filters know how to downsample this format
+		static bool canGenerate(PixelFormat format);
+
+		///builds all the levels below the base image using a 2x2 box filter
+		/**
+		The base level is not copied in the chain, so the returned chain starts at level 1.
+		SRGB formats are filtered in linear space, and their alpha is always linear.
+		*/
+		static MipChain generate(const uint8_t* base, uint32_t width, uint32_t height, PixelFormat format);
+
+		PixelFormat format = PixelFormat::Unknown;
+
+		///the mip level of the first element in levels
+		uint32_t firstLevel = 0;
+
+		std::vector<Level> levels;
+
+		MipChain() {}
+
+		MipChain(PixelFormat format, uint32_t firstLevel) :
+			format(format),
+			firstLevel(firstLevel) {
+
+		}
+
+		///returns the total amount of levels in the texture this chain belongs to
+		uint32_t getTotalLevelCount() const {
+			return firstLevel + (uint32_t)levels.size();
+		}
+	};
+}
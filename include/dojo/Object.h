@@ -12,15 +12,19 @@
 #include "dojo_common_header.h"
 
 #include "Vector.h"
-#include "SmallSet.h"
+#include "IndexedSet.h"
 #include "AABB.h"
 #include "RenderLayer.h"
+#include "TransformHierarchy.h"
+#include "Component.h"
+#include "ObjectArena.h"
 
 namespace Dojo {
 
 	class GameState;
 	class Renderable;
-	class Component;
+	class SceneSnapshot;
+	class WorkerPool;
 
 	///Object is the base class of any object that can be placed and moved in a GameState
 	/**
@@ -28,16 +32,35 @@ namespace Dojo {
 	When other Objects are attached to a single root Object as children, they share their parent's
 	world transform and move in its local space
 
+	The position, the rotation and the world transform are stored in the TransformHierarchy of the GameState, which
+	updates all the world transforms at once after the Objects' actions.
+
 	Objects automatically listen to the "action" event, that is called each frame.
 
 	Objects are automatically collected when the dispose flag is set to true on them, or on one of its parents.
+
+	An Object with setParallelChildUpdate(true) runs the actions of its children on the background WorkerPool.
+	During the parallel phase addChild, dispose and the collection of the children are recorded by each job and
+	replayed in job order once all the jobs are done, so the result doesn't depend on the threads; removeChild can't
+	be used. The children that touch shared state can be kept on the main thread with setMainThreadOnly(true), they
+	run after the parallel phase.
 	*/
 	class Object {
+		friend class SceneSnapshot;
+	private:
+		struct ChildSlot {
+			static uint32_t& get(Object& o) {
+				return o.mChildSlot;
+			}
+		};
+
 	public:
+		///the fewest children worth a job in the parallel update
+		static const size_t MIN_CHILDREN_PER_JOB = 32;
 
-		typedef SmallSet<Unique<Object>> ChildList;
+		typedef IndexedSet<Unique<Object>, ChildSlot> ChildList;
 
-		Vector position, speed;
+		Vector speed;
 
 		///Creates a new Object as a child of the given object at the given relative position, with bbSize size
 		/**
@@ -47,11 +70,36 @@ namespace Dojo {
 
 		virtual ~Object();
 
+		///Objects can live on the heap or in the ObjectArena of their GameState, see emplaceChild
+		static void* operator new(size_t size) {
+			return ObjectArena::allocateFromHeap(size);
+		}
+
+		static void* operator new(size_t size, ObjectArena& arena) {
+			return arena.allocate(size);
+		}
+
+		static void operator delete(void* ptr) {
+			ObjectArena::free(ptr);
+		}
+
+		static void operator delete(void* ptr, ObjectArena& arena) {
+			ObjectArena::free(ptr);
+		}
+
 		virtual void reset();
 
 		//forces an update of the world transform
 		void updateWorldTransform();
 
+		const Vector& getPosition() const {
+			return mTransforms.unwrap().getPosition(mTransformID);
+		}
+
+		void setPosition(const Vector& position) {
+			mTransforms.unwrap().setPosition(mTransformID, position);
+		}
+
 		///sets a AABB size
 		void setSize(const Vector& bbSize);
 
@@ -62,7 +110,7 @@ namespace Dojo {
 
 		///set the orientation quaternion for this object
 		void setRotation(const Quaternion& quat) {
-			rotation = quat;
+			mTransforms.unwrap().setRotation(mTransformID, quat);
 		}
 
 		///sets the full orientation using a vector made of radians around x,y,z
@@ -77,11 +125,29 @@ namespace Dojo {
 
 		///rotates the object starting from the current orientation around the given axis
 		void rotate(Degrees r, const Vector& axis = Vector::UnitZ) {
-			rotation = glm::rotate(rotation, (float)r, axis);
+			setRotation(glm::rotate(getRotation(), (float)r, axis));
 		}
 
 		void setActive(bool a) {
 			active = a;
+			_updateActive();
+		}
+
+		///runs the actions of the children on the background WorkerPool, the children must not share state
+		/**
+		\param pool the pool to run on instead of the background pool of the Platform */
+		void setParallelChildUpdate(bool enabled, optional_ref<WorkerPool> pool = {}) {
+			mParallelChildUpdate = enabled;
+			mChildUpdatePool = pool;
+		}
+
+		///keeps this Object out of the parallel update of its parent, use it when its action touches shared state
+		void setMainThreadOnly(bool mainThreadOnly) {
+			mMainThreadOnly = mainThreadOnly;
+		}
+
+		bool isMainThreadOnly() const {
+			return mMainThreadOnly;
 		}
 
 		const Vector& getSize() const {
@@ -113,13 +179,17 @@ namespace Dojo {
 		Vector getLocalDirection(const Vector& worldDir);
 
 		const Quaternion& getRotation() const {
-			return rotation;
+			return mTransforms.unwrap().getRotation(mTransformID);
 		}
 
 		///returns the euclidean "roll" angle, or rotation around Z
 		Radians getRoll() const;
 
-		bool isActive() const;
+		///true if this Object and all of its parents are active and not disposed
+		bool isActive() const {
+			DEBUG_ASSERT(mEffectivelyActive == _computeActive(), "The cached active flag is out of date");
+			return mEffectivelyActive;
+		}
 
 		virtual bool isRoot() const {
 			return false;
@@ -133,7 +203,12 @@ namespace Dojo {
 		}
 
 		const Matrix& getWorldTransform() const {
-			return mWorldTransform;
+			return mTransforms.unwrap().getWorldTransform(mTransformID);
+		}
+
+		///returns a number that changes each time the world transform is recomputed
+		uint32_t getTransformVersion() const {
+			return mTransforms.unwrap().getVersion(mTransformID);
 		}
 
 		Matrix getParentWorldTransform() const;
@@ -154,12 +229,18 @@ namespace Dojo {
 			return (T&)_addChild(std::move(o));
 		}
 
+		///creates a T(self, args...) in the ObjectArena of the GameState and adds it as a child
+		template <class T, class... Args>
+		T& emplaceChild(Args&&... args) {
+			return addChild(Unique<T>(new (_getArena()) T(self, std::forward<Args>(args)...)));
+		}
+
 		///removes a child if existing and gives it back to the caller
 		Unique<Object> removeChild(Object& o);
 
 		template<class T>
 		bool has() const {
-			return T::ID < components.size() and components[T::ID];
+			return components[T::ID] != nullptr;
 		}
 
 		template<class T>
@@ -186,6 +267,12 @@ namespace Dojo {
 			return (T&)_addComponent(std::move(c), T::ID);
 		}
 
+		///creates a T(self, args...) in the ObjectArena of the GameState and adds it as a component
+		template<class T, class... Args>
+		T& emplaceComponent(Args&&... args) {
+			return addComponent(Unique<T>(new (_getArena()) T(self, std::forward<Args>(args)...)));
+		}
+
 		virtual void onAction(float dt);
 
 		///sets all children visible or invisible. //HACK this needs to be removed in favor of an actual scene graph traversal
@@ -203,15 +290,18 @@ namespace Dojo {
 
 		optional_ref<GameState> gameState;
 
-		std::vector<Unique<Component>> components; //TODO not a vector pls
+		///the Components are owned by the ComponentPools of the GameState, indexed by ComponentID
+		std::array<Component*, ComponentID::_count> components = {};
 
 		Vector size, halfSize;
 
-		Quaternion rotation;
-
-		Matrix mWorldTransform;
+		optional_ref<TransformHierarchy> mTransforms;
+		TransformHierarchy::ID mTransformID = TransformHierarchy::NONE;
 
 		bool active;
+		bool mParallelChildUpdate = false;
+		optional_ref<WorkerPool> mChildUpdatePool;
+		bool mMainThreadOnly = false;
 		
 		optional_ref<Object> parent;
 		ChildList children;
@@ -219,9 +309,45 @@ namespace Dojo {
 		void _addChildEvent(Object& child);
 		Object& _addChild(Unique<Object> o);
 
+		///links a child without the attach events, for when the whole subtree is attached at once later
+		void _linkChild(Unique<Object> o);
+
 		void _unregisterChild(Object& child);
 
+		///creates the transform of this Object in the TransformHierarchy of its GameState
+		void _addTransform(const Vector& position);
+		void _removeTransform();
+
+		///gives each Component back to itself, eg. for threaded destruction
+		void _destroyComponents();
+
+		ObjectArena& _getArena();
+
 	private:
+		///a structural change recorded during the parallel update
+		struct DeferredCommand;
+		typedef std::vector<DeferredCommand> DeferredCommandList;
+
+		///the list of the job running on this thread, null outside of the parallel update
+		static thread_local DeferredCommandList* gDeferredCommands;
+
 		bool disposed;
+		///the position of this Object in the children of its parent
+		uint32_t mChildSlot = ChildList::NO_SLOT;
+		///active and not disposed, and so are all the parents; kept up to date by _updateActive
+		bool mEffectivelyActive = true;
+		///set when a child is disposed, so that collectChilds only scans the children when there's something to collect
+		bool mHasDisposedChildren = false;
+
+		///splits the children in jobs on the background pool, returns false if they are too few to be worth it
+		bool _updateChildsParallel(float dt);
+
+		bool _computeActive() const {
+			return active and not disposed and (parent.is_none() or parent.unwrap().mEffectivelyActive);
+		}
+
+		///refreshes the cached active flag, and the ones of the children if it changed
+		void _updateActive();
+		void _dispose();
 	};
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "SpinLock.h"
+
+namespace Dojo {
+	///ObjectArena allocates Objects and Components from large chunks owned by a GameState
+	/**
+	Blocks are carved out of CHUNK_SIZE chunks and rounded to GRANULARITY bytes; a freed block goes in the free list
+	of its size and is recycled by the next allocation of the same size, so spawning and destroying the same kind of
+	Object again and again doesn't touch the heap. Once nothing allocated from it is alive, release() drops all the
+	chunks at once.
+	Every block starts with a small header that tells where it came from: Object and Component route their operator
+	new and delete through here, so a Unique deletes arena and heap instances alike, and only the callers that opt in
+	with Object::emplaceChild and Object::emplaceComponent use an arena.
+	\remark a Component that keeps itself alive in onDestroy must not be created in an arena, as it could outlive it
+	*/
+	class ObjectArena {
+	public:
+		static const size_t CHUNK_SIZE = 64 * 1024;
+		static const size_t GRANULARITY = 16;
+		///bigger blocks are allocated on the heap
+		static const size_t MAX_BLOCK_SIZE = 2048;
+
+		struct FrameStats {
+			uint32_t allocations = 0;
+			///the allocations served by a free list
+			uint32_t recycled = 0;
+			uint32_t frees = 0;
+			///the allocations too big for the arena, which went to the heap
+			uint32_t heapAllocations = 0;
+			uint32_t liveAllocations = 0;
+			size_t chunkBytes = 0;
+		};
+
+		///allocates a block on the heap with a header that tells it doesn't belong to an arena
+		static void* allocateFromHeap(size_t size);
+
+		///frees a block allocated by any arena or by allocateFromHeap
+		static void free(void* ptr);
+
+		ObjectArena();
+		ObjectArena(const ObjectArena&) = delete;
+		ObjectArena& operator=(const ObjectArena&) = delete;
+
+		~ObjectArena();
+
+		void* allocate(size_t size);
+
+		///drops all the chunks, nothing allocated from the arena can be alive
+		void release();
+
+		uint32_t getLiveAllocationCount() const {
+			return mLiveAllocations;
+		}
+
+		///returns the allocations that happened during the last frame
+		const FrameStats& getLastFrameStats() const {
+			return mLastFrameStats;
+		}
+
+		///closes the stats of the current frame
+		void endFrame();
+
+	private:
+		struct Header {
+			ObjectArena* arena;
+			uint32_t sizeClass;
+		};
+
+		///keeps the blocks aligned like the heap would
+		static const size_t HEADER_SIZE = (sizeof(Header) + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+
+		///a free block stores the next one of its size
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		std::vector<Unique<uint8_t[]>> mChunks;
+		size_t mChunkOffset = CHUNK_SIZE;
+		std::array<FreeBlock*, MAX_BLOCK_SIZE / GRANULARITY + 1> mFreeLists;
+		uint32_t mLiveAllocations = 0;
+
+		FrameStats mCurrentFrameStats, mLastFrameStats;
+
+		SpinLock mLock;
+
+		void _deallocate(Header* header);
+	};
+}
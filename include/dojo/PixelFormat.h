@@ -12,6 +12,30 @@ namespace Dojo {
 		R_8,
 		RG_8,
 		A_8, //same as R_8, but counts as transparent
+
+		//block compressed formats, only loaded from KTX containers
+		ETC2_RGB_8,
+		ETC2_RGB_8_SRGB,
+		ETC2_RGBA_8,
+		ETC2_RGBA_8_SRGB,
+		EAC_R_11,
+		EAC_RG_11,
+		BC1_RGB,
+		BC1_RGBA,
+		BC2_RGBA,
+		BC3_RGBA,
+		BC3_RGBA_SRGB,
+		BC4_R,
+		BC5_RG,
+		BC7_RGBA,
+		BC7_RGBA_SRGB,
+		ASTC_4x4_RGBA,
+		ASTC_4x4_RGBA_SRGB,
+		ASTC_6x6_RGBA,
+		ASTC_6x6_RGBA_SRGB,
+		ASTC_8x8_RGBA,
+		ASTC_8x8_RGBA_SRGB,
+
 		Unknown
 	};
 }
@@ -16,6 +16,7 @@ namespace Dojo {
 	class ApplicationListener;
 	class FileStream;
 	class WorkerPool;
+	class ResidencyManager;
 
 	///Platform is the base of the engine; it runs the main loop, creates the windows and updates the Game
 	/** the Platform is the first object to be initialized in a Dojo game, using the static method Platform::create() */
@@ -74,6 +75,11 @@ namespace Dojo {
 			return *mLog;
 		}
 
+		///returns the ResidencyManager that tracks the VRAM used by Textures and Meshes
+		ResidencyManager& getResidencyManager() {
+			return *mResidency;
+		}
+
 		///returns the default BackgroundQueue
 		WorkerPool& getBackgroundPool() {
 			return *mPools[1]; //HACK
@@ -258,6 +264,9 @@ namespace Dojo {
 
 		bool running, mFullscreen, mFrameSteppingEnabled;
 
+		//declared before the game and the renderer so that it outlives the resources they own
+		Unique<ResidencyManager> mResidency;
+
 		Unique<Game> game;
 
 		Unique<SoundManager> sound;
@@ -2,7 +2,7 @@
 
 #include "dojo_common_header.h"
 
-#include "SmallSet.h"
+#include "IndexedSet.h"
 
 #include "PseudoEnum.h"
 
@@ -30,9 +30,16 @@ namespace Dojo {
 		}
 
 		float zOffset = 0.f;
-		
-		SmallSet<Renderable*> elements;
-		bool elementsChangedThisFrame = false;
+
+		///finds the position of a Renderable in the elements of its layer
+		struct ElementSlot {
+			template <class R>
+			static uint32_t& get(R& renderable) {
+				return renderable._getLayerSlot();
+			}
+		};
+
+		IndexedSet<Renderable*, ElementSlot> elements;
 
 		bool usesDepth() const {
 			return depthWrite or depthTest;
@@ -85,6 +85,21 @@ namespace Dojo {
 
 		virtual void onAttach() override;
 		virtual void onDetach() override;
+
+		///internal - the position of this Renderable in the elements of its RenderLayer
+		uint32_t& _getLayerSlot() {
+			return mLayerSlot;
+		}
+
+		///internal - the position of this Renderable in the ones the Renderer updates apart from the ComponentPools
+		uint32_t& _getLayerOnlySlot() {
+			return mLayerOnlySlot;
+		}
+
+		///internal - true if this Renderable is in the elements of a RenderLayer
+		bool _isInLayer() const {
+			return mLayerSlot != 0xffffffff;
+		}
 	protected:
 
 		bool visible = true;
@@ -98,5 +113,9 @@ namespace Dojo {
 		Color fadeEndColor;
 
 		AABB mWorldBB, mLastMeshBB;
+		Vector mLastScale;
+		uint32_t mLastTransformVersion = 0;
+		uint32_t mLayerSlot = 0xffffffff;
+		uint32_t mLayerOnlySlot = 0xffffffff;
 	};
 }
@@ -24,9 +24,17 @@ namespace Dojo {
 	class Mesh;
 	class Game;
 	class FrameSubmitter;
+	class TextureStreamer;
+	class AsyncReadback;
+	class MeshArena;
+	class ResidencyManager;
+	class ComponentPool;
 
 	class Renderer {
 	public:
+		///layers with at least twice as many elements are culled on the background WorkerPool, in chunks this big
+		static const uint32_t MIN_ELEMENTS_PER_CULL_JOB = 256;
+
 		///a struct that exposes current uniform values
 		GlobalUniformData globalUniforms;
 
@@ -77,6 +85,20 @@ namespace Dojo {
 			return mBackBuffer;
 		}
 
+		TextureStreamer& getTextureStreamer() {
+			return *mTextureStreamer;
+		}
+
+		///returns the service used to read pixels back from the GPU without stalling
+		AsyncReadback& getAsyncReadback() {
+			return *mAsyncReadback;
+		}
+
+		///returns the arena that holds the buffers of the small static meshes
+		MeshArena& getMeshArena() {
+			return *mMeshArena;
+		}
+
 		int getLastFrameVertexCount() {
 			return frameVertexCount;
 		}
@@ -119,9 +141,36 @@ namespace Dojo {
 
 		Matrix mRenderRotation;
 
-		void _updateRenderables(LayerList& layers, float dt);
+		Unique<TextureStreamer> mTextureStreamer;
+		Unique<AsyncReadback> mAsyncReadback;
+		Unique<MeshArena> mMeshArena;
+
+		///the result of the culling of the layer being rendered, by element
+		std::vector<uint8_t> mElementVisible;
+
+		///the pool of Renderables of a GameState, with how many of them are in the layers
+		struct RenderablePool {
+			ComponentPool* pool;
+			uint32_t registeredCount;
+		};
+
+		struct LayerOnlySlot {
+			template <class R>
+			static uint32_t& get(R& renderable) {
+				return renderable._getLayerOnlySlot();
+			}
+		};
+
+		///the pools iterated by the update, as long as they have Renderables in the layers
+		std::vector<RenderablePool> mRenderablePools;
+		///the Renderables in the layers that aren't the Component of their Object, eg. the pages of a TextArea
+		IndexedSet<Renderable*, LayerOnlySlot> mLayerOnlyRenderables;
+
+		void _updateRenderables(float dt);
+		void _unregisterUpdate(Renderable& s);
 
 		///renders a single element using the given viewport
+		void _makeResident(ResidencyManager& residency, const RenderState& renderState);
 		void _renderElement(const RenderLayer& layer, const RenderState& renderState);
 		void _renderLayer(Viewport& viewport, const RenderLayer& layer);
 		void _renderViewport(Viewport& viewport);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Resource;
+
+	///The ResidencyManager keeps track of the VRAM used by the loaded GPU Resources and evicts the least recently used
+	/**
+	Textures and Meshes register themselves when their GPU data is created, and the Renderer marks them as used
+	each time they are drawn.
+	When a budget is set and the resident bytes exceed it, reloadable resources that weren't used for the longest
+	time are soft-unloaded at the end of the frame; they are loaded again the next time they are drawn.
+	*/
+	class ResidencyManager {
+	public:
+		struct FrameStats {
+			size_t residentBytes = 0;
+			size_t evictedBytes = 0;
+			uint32_t evictions = 0;
+			uint32_t reloads = 0;
+		};
+
+		ResidencyManager();
+		ResidencyManager(const ResidencyManager&) = delete;
+		ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+		~ResidencyManager();
+
+		///sets the VRAM budget in bytes, 0 means unlimited
+		void setBudget(size_t bytes) {
+			mBudget = bytes;
+		}
+
+		size_t getBudget() const {
+			return mBudget;
+		}
+
+		///returns the bytes currently used by all the tracked resources
+		size_t getResidentBytes() const {
+			return mResidentBytes;
+		}
+
+		size_t getTrackedResourceCount() const {
+			return mEntries.size();
+		}
+
+		uint32_t getCurrentFrame() const {
+			return mCurrentFrame;
+		}
+
+		///returns the evictions and reloads that happened during the last frame
+		const FrameStats& getLastFrameStats() const {
+			return mLastFrameStats;
+		}
+
+		///marks the resource as used in the current frame, and loads it back if it was evicted
+		/**
+		returns true if the resource had to be reloaded */
+		bool touch(Resource& r);
+
+		///evicts resources until the budget is met and starts a new frame
+		void endFrame();
+
+		///internal - a resource created or resized its GPU data
+		void _notifyLoaded(Resource& r);
+
+		///internal - a resource released its GPU data
+		/**
+		it reaches the manager through the resource, so it works during the shutdown when the Platform is gone */
+		static void _notifyUnloaded(Resource& r);
+
+	private:
+		struct Entry {
+			Resource* resource;
+			size_t bytes;
+		};
+
+		std::vector<Entry> mEntries;
+
+		size_t mBudget = 0, mResidentBytes = 0;
+		uint32_t mCurrentFrame = 1;
+
+		FrameStats mCurrentFrameStats, mLastFrameStats;
+
+		void _evict(size_t bytesToFree);
+		void _untrack(Resource& r);
+	};
+}
@@ -13,8 +13,10 @@
 
 namespace Dojo {
 	class ResourceGroup;
+	class ResidencyManager;
 
 	class Resource {
+		friend class ResidencyManager;
 	public:
 
 		Resource(optional_ref<ResourceGroup> group = {}) :
@@ -60,6 +62,16 @@ namespace Dojo {
 			return filePath.not_empty();
 		}
 
+		///returns the last frame in which the resource was drawn, as counted by the ResidencyManager
+		uint32_t getLastUsedFrame() const {
+			return mLastUsedFrame;
+		}
+
+		///true if the ResidencyManager unloaded this resource to make room, it will be loaded again on its next use
+		bool isEvicted() const {
+			return mEvicted;
+		}
+
 	protected:
 		bool loaded;
 
@@ -68,5 +80,14 @@ namespace Dojo {
 		int size;
 
 		utf::string filePath;
+
+	private:
+		static const size_t UNTRACKED = SIZE_MAX;
+
+		uint32_t mLastUsedFrame = 0;
+		bool mEvicted = false;
+		size_t mResidencyIndex = UNTRACKED;
+		///the manager that tracks this resource, the unload doesn't have to find it through the Platform
+		ResidencyManager* mResidency = nullptr;
 	};
 }
@@ -49,6 +49,9 @@ namespace Dojo {
 		//various resource properties TODO: refactor
 		bool disableBilinear, disableMipmaps, disableTiling, logchanges = true;
 
+		///if set, the Textures of this group are decoded on the background pool and show a placeholder until resident
+		bool streamTextures = false;
+
 		typedef std::map<utf::string, Unique<FrameSet>, utf::str_less> FrameSetMap;
 		typedef std::map<utf::string, Unique<Font>, utf::str_less> FontMap;
 		typedef std::map<utf::string, Unique<Mesh>, utf::str_less> MeshMap;
@@ -101,6 +104,25 @@ namespace Dojo {
 			return{};
 		}
 
+		///finds the name of a resource of type R, or returns an empty string if neither this group nor the subgroups have it
+		template <class R>
+		utf::string_view findName(const R& resource, ResourceType r) const {
+			for (auto&& pair : getResourceMap<R>(r)) {
+				if (pair.second == &resource) {
+					return pair.first;
+				}
+			}
+
+			for (auto&& sub : subs) {
+				auto name = sub->findName<R>(resource, r);
+				if (name.not_empty()) {
+					return name;
+				}
+			}
+
+			return{};
+		}
+
 		FrameSet& addFrameSet(Unique<FrameSet> resource, utf::string_view name);
 		Texture& addTexture(Unique<Texture> texture, utf::string_view name);
 
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Object;
+
+	///SceneSnapshot saves an Object subtree in a binary blob and builds it back in a single pass
+	/**
+	The snapshot stores, for each Object, its parent, position, rotation, size, speed and active flag, followed by the
+	state of its components; resources are referenced by their name in the ResourceGroups of the GameState.
+	Objects of derived classes are saved as plain Objects, and only plain Renderables are saved: Sprites, TextAreas and
+	the other components carry state that only their own code knows how to build.
+	Loading allocates the Objects in the ObjectArena of the GameState, links the whole subtree without attach events and
+	then attaches it with a single addChild, instead of paying the attach recursion once per node.
+	All values are little endian.
+	*/
+	class SceneSnapshot {
+	public:
+		static const uint32_t VERSION = 1;
+
+		///serializes root and its children
+		static std::vector<uint8_t> save(const Object& root);
+
+		///builds the subtree stored in data as a child of parent
+		/**
+		\returns the root of the new subtree, or nothing if the data is malformed */
+		static optional_ref<Object> load(Object& parent, const uint8_t* data, size_t size);
+
+		///maps a snapshot file and loads it, see load
+		static optional_ref<Object> loadFile(Object& parent, utf::string_view path);
+	};
+}
@@ -48,7 +48,10 @@ namespace Dojo {
 
 			BU_TIME, ///<Time in seconds since the start of the program (float)
 			BU_TARGET_DIMENSION, ///<The dimensions in pixels of the currently bound target (vec2)
-			BU_TARGET_DIMENSION_INV ///<The dimension in the UV space of one pixel
+			BU_TARGET_DIMENSION_INV, ///<The dimension in the UV space of one pixel
+
+			BU_POSITION_DECODE_SCALE, ///<The size of the bounds of a quantized Mesh, multiplies POSITION_QUANTIZED (vec3)
+			BU_POSITION_DECODE_OFFSET ///<The minimum of the bounds of a quantized Mesh, added after the scale (vec3)
 		};
 
 		///A VertexAttribute represents a "attribute" binding in a vertex shader
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "SpinLock.h"
+
+namespace Dojo {
+	///A SlotPool hands out reusable slots of T by index, from any thread and without locking
+	/**
+	The slots are allocated in segments of SEGMENT_SIZE that live as long as the pool and never move, so acquire()
+	only allocates when all the slots are in use.
+	The free slots form a lock-free stack; its head carries a tag that changes with each update, so a thread can't
+	be fooled by a slot that was taken and given back while it was reading it.
+	The T are default constructed with their segment and are not reset when released.
+	At most MAX_SEGMENTS segments can be allocated, acquire() throws std::bad_alloc when they are all in use.
+	*/
+	template <typename T, uint32_t SEGMENT_SIZE = 1024>
+	class SlotPool {
+	public:
+		static const uint32_t NONE = 0xffffffff;
+		static const uint32_t MAX_SEGMENTS = 1024;
+
+		SlotPool() :
+			mFreeHead(NONE),
+			mSegmentCount(0) {
+
+		}
+
+		SlotPool(const SlotPool&) = delete;
+		SlotPool& operator=(const SlotPool&) = delete;
+
+		~SlotPool() {
+			for (uint32_t i = 0; i < mSegmentCount; ++i) {
+				delete[] mSegments[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		///takes a free slot, growing the pool if there are none; throws std::bad_alloc when it can't grow anymore
+		uint32_t acquire() {
+			auto head = mFreeHead.load(std::memory_order_acquire);
+			while (true) {
+				auto index = (uint32_t)head;
+				if (index == NONE) {
+					_grow();
+					head = mFreeHead.load(std::memory_order_acquire);
+					continue;
+				}
+
+				auto next = _getSlot(index).nextFree.load(std::memory_order_relaxed);
+				if (mFreeHead.compare_exchange_weak(head, _makeHead(head, next), std::memory_order_acq_rel, std::memory_order_acquire)) {
+					return index;
+				}
+			}
+		}
+
+		///gives a slot back, any thread can release any slot
+		void release(uint32_t index) {
+			auto& slot = _getSlot(index);
+			auto head = mFreeHead.load(std::memory_order_relaxed);
+			do {
+				slot.nextFree.store((uint32_t)head, std::memory_order_relaxed);
+			} while (not mFreeHead.compare_exchange_weak(head, _makeHead(head, index), std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		T& operator[](uint32_t index) {
+			return _getSlot(index).value;
+		}
+
+	private:
+		struct Slot {
+			T value;
+			std::atomic<uint32_t> nextFree;
+		};
+
+		///the index of the first free slot in the low bits, the tag in the high ones
+		std::atomic<uint64_t> mFreeHead;
+
+		std::atomic<Slot*> mSegments[MAX_SEGMENTS] = {};
+		std::atomic<uint32_t> mSegmentCount;
+		SpinLock mGrowLock;
+
+		static uint64_t _makeHead(uint64_t previous, uint32_t index) {
+			return (((previous >> 32) + 1) << 32) | index;
+		}
+
+		Slot& _getSlot(uint32_t index) {
+			return mSegments[index / SEGMENT_SIZE].load(std::memory_order_acquire)[index % SEGMENT_SIZE];
+		}
+
+		void _grow() {
+			std::lock_guard<SpinLock> lock(mGrowLock);
+
+			//another thread could have grown the pool meanwhile
+			if ((uint32_t)mFreeHead.load(std::memory_order_acquire) != NONE) {
+				return;
+			}
+
+			//the segment table can't grow while other threads read it, past the end there's no memory to hand out
+			auto segmentIndex = mSegmentCount.load(std::memory_order_relaxed);
+			if (segmentIndex == MAX_SEGMENTS) {
+				throw std::bad_alloc();
+			}
+
+			auto segment = new Slot[SEGMENT_SIZE];
+			auto first = segmentIndex * SEGMENT_SIZE;
+			for (uint32_t i = 0; i + 1 < SEGMENT_SIZE; ++i) {
+				segment[i].nextFree.store(first + i + 1, std::memory_order_relaxed);
+			}
+
+			mSegments[segmentIndex].store(segment, std::memory_order_release);
+			mSegmentCount.store(segmentIndex + 1, std::memory_order_release);
+
+			//push the whole segment at once, the slots released meanwhile go after it
+			auto& last = segment[SEGMENT_SIZE - 1];
+			auto head = mFreeHead.load(std::memory_order_relaxed);
+			do {
+				last.nextFree.store((uint32_t)head, std::memory_order_relaxed);
+			} while (not mFreeHead.compare_exchange_weak(head, _makeHead(head, first), std::memory_order_release, std::memory_order_relaxed));
+		}
+	};
+}
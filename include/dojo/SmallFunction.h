@@ -0,0 +1,126 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///A move-only void() callable that keeps small callables inside itself
+	/**
+	The callable is always stored inline, so wrapping a lambda with a few captures doesn't allocate; one that doesn't
+	fit in CAPACITY bytes is a compile error, it has to be wrapped in a std::function to be allocated on purpose.
+	An empty std::function makes an empty SmallFunction.
+	*/
+	class SmallFunction {
+	public:
+		static const size_t CAPACITY = 64;
+
+		SmallFunction() {}
+
+		SmallFunction(const std::function<void()>& function) {
+			if (function) {
+				_store(function);
+			}
+		}
+
+		SmallFunction(std::function<void()>&& function) {
+			if (function) {
+				_store(std::move(function));
+			}
+		}
+
+		template <typename F, typename = typename std::enable_if<
+			not std::is_same<typename std::decay<F>::type, SmallFunction>::value and
+			not std::is_same<typename std::decay<F>::type, std::function<void()>>::value>::type>
+		SmallFunction(F&& function) {
+			_store(std::forward<F>(function));
+		}
+
+		SmallFunction(SmallFunction&& other) {
+			_moveFrom(other);
+		}
+
+		SmallFunction& operator=(SmallFunction&& other) {
+			if (this != &other) {
+				reset();
+				_moveFrom(other);
+			}
+			return self;
+		}
+
+		SmallFunction(const SmallFunction&) = delete;
+		SmallFunction& operator=(const SmallFunction&) = delete;
+
+		~SmallFunction() {
+			reset();
+		}
+
+		///destroys the callable and its captures
+		void reset() {
+			if (mOps) {
+				mOps->destroy(&mStorage);
+				mOps = nullptr;
+			}
+		}
+
+		void operator()() {
+			DEBUG_ASSERT(mOps, "Calling an empty function");
+			mOps->invoke(&mStorage);
+		}
+
+		explicit operator bool() const {
+			return mOps != nullptr;
+		}
+
+	private:
+		struct Ops {
+			void(*invoke)(void* storage);
+			void(*move)(void* from, void* to);
+			void(*destroy)(void* storage);
+		};
+
+		template <typename F>
+		struct InlineOps {
+			static void invoke(void* storage) {
+				(*static_cast<F*>(storage))();
+			}
+
+			static void move(void* from, void* to) {
+				new (to) F(std::move(*static_cast<F*>(from)));
+				static_cast<F*>(from)->~F();
+			}
+
+			static void destroy(void* storage) {
+				static_cast<F*>(storage)->~F();
+			}
+
+			static const Ops ops;
+		};
+
+		std::aligned_storage<CAPACITY, alignof(std::max_align_t)>::type mStorage;
+		const Ops* mOps = nullptr;
+
+		template <typename F>
+		void _store(F&& function) {
+			typedef typename std::decay<F>::type Callable;
+
+			static_assert(sizeof(Callable) <= CAPACITY and alignof(Callable) <= alignof(std::max_align_t),
+				"The callable doesn't fit in a SmallFunction, wrap it in a std::function to allocate it");
+			//the moves of the callable happen when the function is moved, they must not throw
+			static_assert(std::is_nothrow_move_constructible<Callable>::value,
+				"The callable can throw when moved, wrap it in a std::function");
+
+			new (&mStorage) Callable(std::forward<F>(function));
+			mOps = &InlineOps<Callable>::ops;
+		}
+
+		void _moveFrom(SmallFunction& other) {
+			if (other.mOps) {
+				other.mOps->move(&other.mStorage, &mStorage);
+				mOps = other.mOps;
+				other.mOps = nullptr;
+			}
+		}
+	};
+
+	template <typename F>
+	const SmallFunction::Ops SmallFunction::InlineOps<F>::ops = { &invoke, &move, &destroy };
+}
@@ -13,6 +13,11 @@ namespace Dojo {
 			while (mLock.test_and_set(std::memory_order_acquire)); //spin
 		}
 
+		///returns false right away if the lock is taken
+		bool try_lock() {
+			return not mLock.test_and_set(std::memory_order_acquire);
+		}
+
 		void unlock() {
 			mLock.clear(std::memory_order_release);
 		}
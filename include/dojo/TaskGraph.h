@@ -0,0 +1,69 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include <deque>
+
+namespace Dojo {
+	class WorkerPool;
+
+	///A TaskGraph runs a set of tasks on a WorkerPool, each one as soon as the tasks it depends on are done
+	/**
+	The tasks are added first, each with the tasks it waits for; those must have been added before it, so the graph
+	can't have cycles. start() queues the tasks without dependencies, and each task that finishes queues the ones
+	that were only waiting for it.
+	The callback given to start() runs on the thread that runs the callbacks of the pool once all the tasks are done,
+	wait() instead runs the tasks of the pool on the calling thread until then.
+	The tasks refer to the graph, so it must live until it's done; a graph that is let go once started can keep itself
+	alive with a Shared<TaskGraph> captured by its own callback.
+	*/
+	class TaskGraph {
+	public:
+		typedef uint32_t TaskID;
+
+		explicit TaskGraph(WorkerPool& pool);
+		TaskGraph(const TaskGraph&) = delete;
+		TaskGraph& operator=(const TaskGraph&) = delete;
+
+		///waits for the tasks if the graph was started
+		~TaskGraph();
+
+		///adds a task that runs after all of its dependencies
+		TaskID add(AsyncTask task, std::initializer_list<TaskID> dependencies = {});
+
+		///adds a task that runs after all of the tasks added so far
+		TaskID addContinuation(AsyncTask task);
+
+		///queues the tasks that don't depend on anything, the graph can't change after this
+		void start(AsyncCallback onDone = {});
+
+		bool isDone() const {
+			return mDone;
+		}
+
+		///runs the tasks of the pool on this thread until all the tasks of the graph are done
+		void wait();
+
+	private:
+		struct Node {
+			AsyncTask task;
+			std::atomic<uint32_t> dependencyCount;
+			std::vector<TaskID> continuations;
+
+			Node(AsyncTask&& task, uint32_t dependencyCount);
+		};
+
+		WorkerPool& mPool;
+		///the references to the Nodes stay valid as the graph grows
+		std::deque<Node> mNodes;
+
+		bool mStarted = false;
+		std::atomic<uint32_t> mRemaining;
+		std::atomic<bool> mDone;
+		AsyncCallback mOnDone;
+
+		void _queue(TaskID id);
+		void _run(TaskID id);
+		void _finish();
+	};
+}
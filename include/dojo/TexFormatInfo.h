@@ -13,13 +13,37 @@ namespace Dojo {
 		uint32_t sourceFormat, sourceElementType;
 
 		bool hasAlpha;
+		bool sRGB;
+
+		///size of a compressed block in texels and bytes, 0 for uncompressed formats
+		uint32_t blockWidth, blockHeight, blockBytes;
 
 		static const TexFormatInfo& getFor(PixelFormat format);
 
+		///returns the compressed PixelFormat matching the given GL internal format, or Unknown
+		static PixelFormat findCompressed(uint32_t glInternalFormat);
+
+		///returns true if the current GL context can sample this format
+		/**
+		must be called on the main thread, as it queries the driver extensions */
+		static bool isSupported(PixelFormat format);
+
+		bool isCompressed() const {
+			return blockBytes > 0;
+		}
+
 		bool isGPUFormat() const {
-			return glm::isPowerOfTwo(internalPixelSize);
+			return isCompressed() or glm::isPowerOfTwo(internalPixelSize);
+		}
+
+		///returns how many bytes a w*h level takes in the source layout
+		size_t getLevelByteSize(uint32_t width, uint32_t height) const {
+			//in size_t, the dimensions come from files too
+			if (isCompressed()) {
+				return (((size_t)width + blockWidth - 1) / blockWidth) * (((size_t)height + blockHeight - 1) / blockHeight) * blockBytes;
+			}
+			return (size_t)width * height * sourcePixelSize;
 		}
 	};
 
 }
-
@@ -15,16 +15,22 @@
 #include "Vector.h"
 #include "PixelFormat.h"
 #include "RenderSurface.h"
+#include "MipChain.h"
+#include "TextureStreamer.h"
 
 namespace Dojo {
 	class Mesh;
 	class FrameSet;
+	struct TexFormatInfo;
 
 	///A Texture is the image container in Dojo; all the images to be displayed need to be loaded in GPU memory using one
 	class Texture : 
 		public RenderSurface,
 		public Resource {
 	public:
+		///set when a texture changes its GL handle behind the back of the RenderStates that bound it
+		static bool gTextureBindingsDirty;
+
 		///Create a empty new texture
 		Texture(optional_ref<ResourceGroup> creator = {});
 
@@ -37,9 +43,19 @@ namespace Dojo {
 		bool loadEmpty(uint32_t width, uint32_t height, PixelFormat destFormat);
 
 		///loads the texture from a memory area with RGBA8 format
+		/**
+		if mipmaps are enabled, the rest of the chain is generated on the background pool and uploaded when ready */
 		bool loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat sourceFormat);
 
+		///loads the texture from a memory area, taking the lower levels from an already generated MipChain
+		/**
+		use this to skip the generation for data that was already mipped offline */
+		bool loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat sourceFormat, const MipChain& mips);
+
 		///loads the texture from the image pointed by the filename
+		/**
+		.ktx and .ktx2 files are uploaded in their compressed format; if the driver can't sample it, an image with the same
+		name and a .png or .jpg extension is loaded instead */
 		bool loadFromFile(utf::string_view path);
 
 		///loads the texture from the given area in a Texture Atlas, without duplicating data
@@ -56,7 +72,24 @@ namespace Dojo {
 			return loaded;
 		}
 
-		///internal - binds this texture as the current GL active one
+		///a texture is resident when its pixels are on the GPU; streamed textures are loaded but not resident while decoding
+		bool isResident() const {
+			return loaded and not mStreamPending;
+		}
+
+		///if enabled, onLoad decodes the image on the background pool and the texture shows a placeholder until resident
+		/**
+		streaming is enabled by default if the creator ResourceGroup has streamTextures set.
+		A streamed texture reports a 0 size until it is resident. */
+		void setStreamingEnabled(bool enabled) {
+			mStreamingEnabled = enabled;
+		}
+
+		bool isStreamingEnabled() const {
+			return mStreamingEnabled;
+		}
+
+		///internal - binds this texture as the current GL active one, or the streaming placeholder if it's not resident
 		virtual void bind(uint32_t index);
 
 		void enableBilinearFiltering();
@@ -70,6 +103,22 @@ namespace Dojo {
 		///A tiled texture repeats when UV > 1 or < 0, while a clamped texture does not
 		void disableTiling();
 
+		///enables or disables the mip chain for the next loads of this texture
+		/**
+		mipmaps are enabled by default unless the creator ResourceGroup has disableMipmaps set */
+		void setMipmapsEnabled(bool enabled) {
+			mMipmapsEnabled = enabled;
+		}
+
+		bool areMipmapsEnabled() const {
+			return mMipmapsEnabled;
+		}
+
+		///returns the amount of levels that are currently sampled by the GPU
+		uint32_t getMipLevelCount() const {
+			return mResidentLevels;
+		}
+
 		///returns the texture size in the UV space of the parent atlas/padded image
 		const Vector& getUVSize() const {
 			return UVSize;
@@ -121,9 +170,26 @@ namespace Dojo {
 
 		void _addAsAttachment(uint32_t index, uint32_t width, uint32_t height, uint8_t miplevel);
 
+		///internal - changes each time the GL handle is replaced, a Framebuffer that attached an older one has to attach it again
+		uint32_t _getHandleGeneration() const {
+			return mHandleGeneration;
+		}
+
+		///internal - decodes an image file and its mip chain into a TextureStreamer::Image, runs on any thread
+		static void _decodeForStreaming(utf::string_view path, bool mipmaps, TextureStreamer::Image& out);
+
+		///internal - creates the storage and uploads a streamed image, data is an offset when an unpack buffer is bound
+		void _uploadStreamed(const TextureStreamer::Image& image, const uint8_t* data);
+
 	private:
 
 		bool mTransparency = false;
+		bool mMipmapsEnabled = true;
+		bool mBilinearFiltering = true, mTiling = true;
+		float mAnisotropy = 0;
+		uint32_t mHandleGeneration = 0;
+		bool mStreamingEnabled = false, mStreamPending = false;
+		uint32_t mStorageLevels = 1, mResidentLevels = 1;
 		uint32_t internalWidth, internalHeight;
 		Vector UVSize, UVOffset;
 
@@ -137,10 +203,26 @@ namespace Dojo {
 
 		Vector screenSize;
 
+		///invalidated on unload so that late mip chains from the background pool are discarded
+		Shared<bool> mLoadToken;
+
 		///builds the optimal billboard for this texture, used in AnimatedQuads
 		void _rebuildOptimalBillboard();
 
 		bool _setupAtlas();
-		bool _createStorage(uint32_t w, uint32_t h, PixelFormat formatID);
+		void _bindOwnHandle();
+		void _setupSamplerFromCreator();
+		///sets the filtering and wrapping of this texture on the bound handle
+		void _applySamplerState();
+		bool _createStorage(uint32_t w, uint32_t h, PixelFormat formatID, uint32_t levels = 1);
+		bool _uploadBaseLevel(const uint8_t* imageData, PixelFormat format);
+		void _uploadLevel(uint32_t level, uint32_t w, uint32_t h, const uint8_t* data, size_t byteSize, const TexFormatInfo& formatDesc);
+		void _uploadMipChain(const MipChain& chain);
+		void _setResidentLevels(uint32_t count);
+
+		bool _loadFromImage(utf::string_view path);
+		bool _loadStreamed(utf::string_view path);
+		bool _loadFromKTX(utf::string_view path);
+		bool _loadFallbackImage(utf::string_view ktxPath);
 	};
 }
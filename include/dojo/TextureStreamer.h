@@ -0,0 +1,96 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "PixelFormat.h"
+#include "Color.h"
+
+namespace Dojo {
+	class Texture;
+
+	///The TextureStreamer decodes streamed Textures on the background pool and uploads them within a per-frame budget
+	/**
+	Decoded images are copied in a small ring of pixel unpack buffers, so that the driver can move them to VRAM
+	asynchronously; a fence guards each buffer before it is reused.
+	Until a Texture is resident, it binds the placeholder in its place.
+	*/
+	class TextureStreamer {
+	public:
+		///a decoded image with all of its mip levels packed one after the other, base level first
+		struct Image {
+			PixelFormat format = PixelFormat::Unknown;
+			uint32_t width = 0, height = 0, levelCount = 1;
+			bool transparency = false;
+			std::vector<uint8_t> data;
+		};
+
+		static const size_t DEFAULT_FRAME_BUDGET = 4 * 1024 * 1024;
+		static const uint32_t UNPACK_BUFFER_COUNT = 3;
+
+		TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		~TextureStreamer();
+
+		///starts decoding the image at path for the given texture
+		/**
+		the upload is dropped if token expires before the image is ready */
+		void stream(Texture& texture, utf::string_view path, std::weak_ptr<bool> token, bool mipmaps);
+
+		///uploads ready images until the frame budget runs out; at least one image is uploaded per frame
+		void update();
+
+		///sets how many bytes can be uploaded each frame
+		void setFrameBudget(size_t bytes);
+
+		size_t getFrameBudget() const {
+			return mFrameBudget;
+		}
+
+		///returns the amount of textures that were decoded but are still waiting for their upload
+		size_t getPendingUploadCount() const {
+			return mReadyImages.size();
+		}
+
+		///returns the bytes uploaded in the last update
+		size_t getLastFrameUploadedBytes() const {
+			return mLastFrameBytes;
+		}
+
+		///sets the color of the 1x1 texture shown in place of non-resident textures
+		void setPlaceholderColor(const Color& color);
+
+		///returns the texture bound in place of textures that are still streaming
+		Texture& getPlaceholder() {
+			return *mPlaceholder;
+		}
+
+	private:
+		struct ReadyImage {
+			Texture* texture;
+			std::weak_ptr<bool> token;
+			Shared<Image> image;
+		};
+
+		struct UnpackBuffer {
+			uint32_t handle = 0;
+			void* fence = nullptr;
+		};
+
+		std::deque<ReadyImage> mReadyImages;
+
+		size_t mFrameBudget = DEFAULT_FRAME_BUDGET, mLastFrameBytes = 0;
+
+		std::array<UnpackBuffer, UNPACK_BUFFER_COUNT> mUnpackBuffers;
+		uint32_t mNextUnpackBuffer = 0;
+
+		Color mPlaceholderColor = Color::Gray;
+		Unique<Texture> mPlaceholder;
+
+		void _createPlaceholder();
+		bool _upload(const ReadyImage& ready);
+		optional_ref<UnpackBuffer> _acquireUnpackBuffer();
+		void _releaseUnpackBuffers();
+	};
+}
@@ -88,9 +88,15 @@ namespace Dojo {
 
 		void _incrementTouches(const Touch& touch);
 
+		///internal - the position of this TouchArea in the list of its GameState
+		uint32_t& _getGameStateSlot() {
+			return mGameStateSlot;
+		}
+
 	private:
 		bool mPressed, top = false;
 		int mLayer;
+		uint32_t mGameStateSlot = 0xffffffff;
 
 		TouchList mTouches;
 
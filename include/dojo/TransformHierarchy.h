@@ -0,0 +1,144 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+#include "SpinLock.h"
+
+#include <deque>
+
+namespace Dojo {
+	///TransformHierarchy stores the transforms of all the Objects of a GameState in contiguous arrays
+	/**
+	The local positions, rotations and world matrices are kept in structure-of-arrays form, ordered so that each
+	parent comes before its children; update() recomputes the world matrices in a single linear pass.
+	Changing a position, a rotation or a parent marks the transform dirty, and only the dirty transforms and their
+	subtrees are recomputed; each recomputation increments the version of the transform, so that the users of a
+	world matrix can tell when it changed without comparing it.
+	Objects refer to their transform with a stable ID, while the slot it maps to changes when the arrays are
+	reordered or compacted.
+
+	Between beginParallel() and endParallel() transforms can be added and removed from several threads: the new ones
+	are kept aside as roots and join the arrays at endParallel().
+	*/
+	class TransformHierarchy {
+	public:
+		typedef uint32_t ID;
+		static const ID NONE = 0xffffffff;
+
+		TransformHierarchy();
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+		///makes room for count more transforms
+		void reserve(size_t count);
+
+		///adds a new transform without a parent
+		ID add(const Vector& position, const Quaternion& rotation);
+
+		///removes a transform, it must not have children
+		void remove(ID id);
+
+		///sets the parent of a transform, or NONE to make it a root
+		void setParent(ID id, ID parent);
+
+		const Vector& getPosition(ID id) const {
+			if (_isPending(id)) {
+				return _getPending(id).position;
+			}
+			return mPositions[mSlotOfID[id]];
+		}
+
+		void setPosition(ID id, const Vector& position);
+
+		const Quaternion& getRotation(ID id) const {
+			if (_isPending(id)) {
+				return _getPending(id).rotation;
+			}
+			return mRotations[mSlotOfID[id]];
+		}
+
+		void setRotation(ID id, const Quaternion& rotation);
+
+		///returns the world matrix computed by the last update
+		const Matrix& getWorldTransform(ID id) const {
+			if (_isPending(id)) {
+				return _getPending(id).worldTransform;
+			}
+			return mWorldTransforms[mSlotOfID[id]];
+		}
+
+		///returns a number that changes each time the world matrix is recomputed, never 0
+		uint32_t getVersion(ID id) const {
+			if (_isPending(id)) {
+				return 1;
+			}
+			return mVersions[mSlotOfID[id]];
+		}
+
+		///returns the world matrix of the parent, or the identity for a root
+		Matrix getParentWorldTransform(ID id) const;
+
+		///recomputes the world matrix of a single transform from the current one of its parent
+		/**
+		its children follow at the next update() */
+		void updateWorldTransform(ID id);
+
+		///recomputes the world matrices of the dirty transforms and of their children, parents first
+		void update();
+
+		///allows add() and remove() to be called from several threads, until endParallel()
+		void beginParallel();
+
+		///moves the transforms added since beginParallel() into the arrays
+		void endParallel();
+
+		///returns the number of live transforms
+		size_t size() const {
+			return mIDOfSlot.size() - mFreeSlots;
+		}
+
+	private:
+		static const uint32_t FREE_SLOT = 0xfffffffe;
+
+		///a transform added during the parallel phase
+		struct Pending {
+			Vector position;
+			Quaternion rotation;
+			Matrix worldTransform;
+			bool removed = false;
+		};
+
+		std::vector<Vector> mPositions;
+		std::vector<Quaternion> mRotations;
+		std::vector<Matrix> mWorldTransforms;
+		///the slot of the parent, NONE for roots and FREE_SLOT for removed transforms
+		std::vector<uint32_t> mParentSlots;
+		std::vector<uint8_t> mDirty;
+		std::vector<uint32_t> mVersions;
+
+		std::vector<ID> mIDOfSlot;
+		std::vector<uint32_t> mSlotOfID;
+		std::vector<ID> mFreeIDs;
+
+		uint32_t mFreeSlots = 0;
+		bool mOrderDirty = false;
+
+		bool mParallel = false;
+		mutable SpinLock mLock;
+		///the references to the elements of a deque stay valid when other threads add to it
+		std::deque<Pending> mPending;
+
+		///the IDs past the mapped ones were given out during the parallel phase
+		bool _isPending(ID id) const {
+			return id >= mSlotOfID.size();
+		}
+
+		Pending& _getPending(ID id) const;
+
+		///compacts the removed slots away and sorts the slots by depth, so that parents come first
+		void _sortSlots();
+
+		void _computeWorldTransform(uint32_t slot);
+	};
+}
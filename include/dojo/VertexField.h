@@ -12,6 +12,11 @@ namespace Dojo {
 		UV0,
 		UVMax = UV0 + DOJO_MAX_TEXTURE_COORDS - 1,
 
+		//the fields below are appended to keep the values stored in .mesh files
+
+		PositionQuantized, ///<16 bit normalized position in the mesh bounds, decoded with the POSITION_DECODE_* uniforms
+		NormalOctahedral, ///<16 bit normalized octahedral normal
+
 		None,
 		_Count = None
 	};
@@ -198,7 +198,7 @@ namespace Dojo {
 
 		bool mClearColorEnabled = true, mFrustumDirty = true, mRegistered = false;
 
-		Matrix mLastWorldTransform;
+		uint32_t mLastTransformVersion = 0;
 
 		Color mClearColor;
 		float mClearDepth;
@@ -3,44 +3,68 @@
 #include "dojo_common_header.h"
 
 #include "TimedEvent.h"
-#include "TexFormatInfo.h"
 #include "AsyncJob.h"
 
 namespace Dojo {
 	class Viewport;
+	class AsyncReadback;
 
-	//a class that just before submitting a frame, it adds it to a recorded stream
+	///a class that records the frames of a Viewport to an animated gif, streaming them to the file as they are captured
+	/**
+	Frames are read back through an AsyncReadback and quantized on the background pool as soon as the GPU is done
+	with them, then they are appended to the file in order.
+	Memory stays bounded regardless of the length of the clip: when too many frames are waiting for the encoder,
+	new captures are dropped.
+	*/
 	class ViewportRecorder {
 	public:
+		static const uint32_t DEFAULT_MAX_FRAMES_IN_FLIGHT = 8;
+
 		ViewportRecorder(Viewport& viewport, Duration videoLength, Duration frequency);
 		virtual ~ViewportRecorder();
 
 		void setViewport(Viewport& viewport);
 
-		bool hasPBOID(uint32_t ID) const;
+		///sets how many captured frames can wait for the encoder before new captures are dropped
+		void setMaxFramesInFlight(uint32_t count);
+
+		///starts a new clip in the Pictures folder, finishing the current one if any
+		void start();
+
+		///true between start() and makeVideo()
+		bool isRecording() const {
+			return mClip != nullptr;
+		}
+
+		///true while a finished clip is still being encoded and written
+		bool isEncoding() const {
+			return not mFinishingClip.expired();
+		}
 
+		///captures the current content of the viewport; starts a clip if none is being recorded
+		/**
+		the clip is finished automatically when it reaches the video length */
 		void captureFrame();
 
+		///stops recording; the file is completed in the background once all the captured frames are encoded
 		void makeVideo();
 
 	private:
+		struct Clip;
+
 		optional_ref<Viewport> mViewport;
 
-		uint32_t mFrameSize = 0;
-		uint32_t mWidth, mHeight;
-		TexFormatInfo mFormatInfo;
+		uint32_t mWidth = 0, mHeight = 0;
+
+		Unique<AsyncReadback> mReadback;
 
-		std::vector<uint32_t> mPBOs;
-		size_t mInitializedPBOs = 0;
-		size_t mNextPBO = 0;
 		int64_t mTotalFrameCount;
 		Duration mFrequency;
+		uint32_t mMaxFramesInFlight = DEFAULT_MAX_FRAMES_IN_FLIGHT;
 
-		AsyncJob::StatusPtr mAsyncJobStatus;
-		
-		void _bindNextPBO();
-		void _destroyAllPBOs();
+		Shared<Clip> mClip;
+		std::weak_ptr<Clip> mFinishingClip;
 
+		static void _write(const Shared<Clip>& clip);
 	};
 }
-
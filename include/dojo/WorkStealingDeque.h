@@ -0,0 +1,129 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///A Chase-Lev work-stealing deque of pointers
+	/**
+	The owner thread pushes and pops at the bottom like a stack, any other thread can steal from the top.
+	push() and pop() never lock; steal() is one compare-and-swap and can fail when it races with another thief or
+	with the owner taking the last item.
+	The buffer grows when it's full; the old buffers are kept until the deque is destroyed because a thief may
+	still be reading from them.
+	*/
+	template <typename T>
+	class WorkStealingDeque {
+		static_assert(std::is_pointer<T>::value, "The deque only stores pointers");
+
+	public:
+		explicit WorkStealingDeque(size_t capacity = 256) :
+			mTop(0),
+			mBottom(0) {
+			DEBUG_ASSERT(capacity > 0 and (capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+
+			mBuffers.emplace_back(make_unique<Buffer>(capacity));
+			mBuffer = mBuffers.back().get();
+		}
+
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+		///adds an item at the bottom, only the owner can call it
+		void push(T item) {
+			auto bottom = mBottom.load(std::memory_order_relaxed);
+			auto top = mTop.load(std::memory_order_acquire);
+			auto buffer = mBuffer.load(std::memory_order_relaxed);
+
+			if (bottom - top >= (int64_t)buffer->capacity) {
+				buffer = _grow(*buffer, top, bottom);
+			}
+
+			buffer->put(bottom, item);
+			std::atomic_thread_fence(std::memory_order_release);
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		///takes the last pushed item, only the owner can call it
+		/**
+		\returns nullptr if the deque is empty */
+		T pop() {
+			auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+			auto buffer = mBuffer.load(std::memory_order_relaxed);
+			mBottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto top = mTop.load(std::memory_order_relaxed);
+
+			if (top > bottom) {
+				mBottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			auto item = buffer->get(bottom);
+			if (top == bottom) {
+				//the last item, the thieves may want it too
+				if (not mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					item = nullptr;
+				}
+				mBottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		///takes the oldest item, any thread can call it
+		/**
+		\returns nullptr if the deque is empty or if another thread took the item first */
+		T steal() {
+			auto top = mTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto bottom = mBottom.load(std::memory_order_acquire);
+
+			if (top >= bottom) {
+				return nullptr;
+			}
+
+			auto item = mBuffer.load(std::memory_order_acquire)->get(top);
+			if (not mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return item;
+		}
+
+	private:
+		struct Buffer {
+			const size_t capacity;
+			std::unique_ptr<std::atomic<T>[]> items;
+
+			explicit Buffer(size_t capacity) :
+				capacity(capacity),
+				items(new std::atomic<T>[capacity]) {
+
+			}
+
+			T get(int64_t index) const {
+				return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+			}
+
+			void put(int64_t index, T item) {
+				items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+			}
+		};
+
+		std::atomic<int64_t> mTop, mBottom;
+		std::atomic<Buffer*> mBuffer;
+
+		///only the owner touches the list, the thieves only see mBuffer
+		std::vector<Unique<Buffer>> mBuffers;
+
+		Buffer* _grow(const Buffer& buffer, int64_t top, int64_t bottom) {
+			mBuffers.emplace_back(make_unique<Buffer>(buffer.capacity * 2));
+			auto bigger = mBuffers.back().get();
+
+			for (auto i = top; i < bottom; ++i) {
+				bigger->put(i, buffer.get(i));
+			}
+
+			mBuffer.store(bigger, std::memory_order_release);
+			return bigger;
+		}
+	};
+}
@@ -1,27 +1,120 @@
 #pragma once
 
 #include "AsyncJob.h"
+#include "MPSCQueue.h"
+#include "SPSCQueue.h"
+#include "SlotPool.h"
+#include "SpinLock.h"
+#include "WorkStealingDeque.h"
 
 namespace Dojo {
-	class BackgroundWorker;
-
 	///a pool of worker that can execute tasks and sends back callbacks
+	/**
+	The tasks queued from outside the pool go to a shared lock-free injection queue; the tasks queued by a task go to
+	the deque of the worker that runs it, so that the newest ones run first and stay in its cache.
+	An idle worker takes from its own deque, then from the injection queue, then steals the oldest task of another
+	worker picked at random, so a long task only delays the tasks that no other worker is free to take.
+	The callbacks are always run on the thread that calls runOneCallback() or sync(), usually the main thread.
+
+	The jobs and their statuses come from pools that are reused, and the tasks with small captures are stored inline,
+	so queueing a job doesn't allocate once the pools are warm.
+
+	A pool that isn't async has no threads: runOneCallback() runs its tasks too, one at a time.
+
+	parallelFor() runs chunks on the calling thread too; once none are left to start, it only waits for its own.
+	waitUntil() instead runs any queued task while it waits, for the callers that would rather help than block.
+	*/
 	class WorkerPool {
 	public:
+		typedef std::function<void(uint32_t begin, uint32_t end)> RangeTask;
+
+		///how many chunks parallelFor() makes for each thread when the chunk size is automatic
+		static const uint32_t CHUNKS_PER_THREAD = 4;
+
 		const bool isAsync;
 
-		explicit WorkerPool(uint32_t workerCount, bool async = true, bool allowMultipleProducers = false);
+		explicit WorkerPool(uint32_t workerCount, bool async = true);
 		~WorkerPool();
 
-		AsyncJob::StatusPtr queue(AsyncTask task, AsyncCallback callback = {});
+		///queues a task to be run on a worker, and its callback to be run by runOneCallback() once it's done
+		AsyncJob::StatusPtr queue(AsyncJob::Function task, AsyncJob::Function callback = {});
 
+		///waits until all the tasks are done and runs all the callbacks, including those of the tasks they queue
 		void sync();
 
+		///runs a callback of a finished task, or a task if the pool isn't async
+		/**
+		\returns false if there was nothing to run */
 		bool runOneCallback();
+
+		///runs one queued task on the calling thread
+		/**
+		\returns false if no task could be taken */
+		bool runOneTask();
+
+		///runs the queued tasks on the calling thread until isDone returns true
+		/**
+		The tasks it runs can be unrelated to the ones waited for, so the wait can last as long as any of them. */
+		void waitUntil(const std::function<bool()>& isDone);
+
+		///splits [0, count) in chunks and runs body on each of them, on the workers and on the calling thread
+		/**
+		Returns when all the chunks are done. A chunkSize of 0 makes about CHUNKS_PER_THREAD chunks for each thread. */
+		void parallelFor(uint32_t count, uint32_t chunkSize, const RangeTask& body);
+
+		uint32_t getWorkerCount() const {
+			return (uint32_t)mWorkers.size();
+		}
 	private:
-		uint32_t mNextWorker = 0;
-		std::vector<Unique<BackgroundWorker>> mWorkers;
-	private:
+		struct PooledJob {
+			AsyncJob job;
+			uint32_t index = 0;
+		};
+
+		struct Worker {
+			WorkerPool& pool;
+			WorkStealingDeque<PooledJob*> jobs;
+			///written by the worker, read by the thread that runs the callbacks
+			SPSCQueue<PooledJob*> completedJobs;
+			std::thread thread;
+			uint32_t randomState;
+
+			Worker(WorkerPool& pool, uint32_t index);
+		};
+
+		///the worker that runs on this thread, if any
+		static thread_local Worker* gCurrentWorker;
+
+		SlotPool<PooledJob, 256> mJobPool;
+
+		std::vector<Unique<Worker>> mWorkers;
+
+		///the producers never wait on each other; the queue has one consumer at a time, a thread that finds
+		///mInjectionConsumerLock taken goes stealing instead
+		MPSCQueue<PooledJob*> mInjectedJobs;
+		SpinLock mInjectionConsumerLock;
+
+		///the finished jobs run by threads that aren't workers
+		MPSCQueue<PooledJob*> mHelperCompletedJobs;
+
+		std::atomic<bool> mRunning;
+		///the jobs that can be taken, it can briefly go below 0 when a job is taken before it's counted
+		std::atomic<int32_t> mAvailableJobs;
+		///the jobs that were queued and aren't done yet
+		std::atomic<uint32_t> mPendingJobs;
+
+		std::mutex mSleepMutex;
+		std::condition_variable mJobAvailable, mAllJobsDone;
+
+		void _injectJob(PooledJob* job);
+		PooledJob* _takeInjectedJob();
+		///takes a job from the worker's deque, the injection queue or another worker, worker can be null
+		PooledJob* _takeJob(Worker* worker);
+		void _runJob(Worker* worker, PooledJob* pooled);
+		void _runCallback(PooledJob* pooled);
+		void _workerLoop(Worker& worker);
+
+		bool _runAllCallbacks();
 	};
 }
 
@@ -0,0 +1,92 @@
+#include "AsyncJob.h"
+
+#include "SlotPool.h"
+
+using namespace Dojo;
+
+const uint32_t AsyncJob::NO_STATUS;
+
+namespace {
+	struct StatusBlock {
+		std::atomic<uint32_t> generation;
+		std::atomic<AsyncJob::Status> status;
+
+		StatusBlock() :
+			generation(0),
+			status(AsyncJob::Status::NotRunning) {
+
+		}
+	};
+
+	typedef SlotPool<StatusBlock> StatusPool;
+
+	StatusPool& getStatusPool() {
+		//never destroyed, the workers could still be releasing statuses when the statics go away
+		static auto pool = new StatusPool();
+		return *pool;
+	}
+}
+
+AsyncJob::StatusPtr::operator Status() const {
+	if (mSlot == NO_STATUS) {
+		return Status::NotRunning;
+	}
+
+	//the status is only valid if the slot wasn't reused after reading it
+	auto& block = getStatusPool()[mSlot];
+	auto status = block.status.load(std::memory_order_acquire);
+	if (block.generation.load(std::memory_order_acquire) != mGeneration) {
+		return Status::NotRunning;
+	}
+	return status;
+}
+
+AsyncJob::AsyncJob(Function&& task, Function&& callback) :
+	task(std::move(task)),
+	callback(std::move(callback)),
+	mStatusSlot(getStatusPool().acquire()) {
+
+	auto& block = getStatusPool()[mStatusSlot];
+	mGeneration = block.generation.load(std::memory_order_relaxed);
+	block.status.store(Status::Scheduled, std::memory_order_release);
+}
+
+AsyncJob::AsyncJob(AsyncJob&& other) :
+	task(std::move(other.task)),
+	callback(std::move(other.callback)),
+	mStatusSlot(other.mStatusSlot),
+	mGeneration(other.mGeneration) {
+	other.mStatusSlot = NO_STATUS;
+}
+
+AsyncJob& AsyncJob::operator=(AsyncJob&& other) {
+	if (this != &other) {
+		_releaseStatus();
+
+		task = std::move(other.task);
+		callback = std::move(other.callback);
+		mStatusSlot = other.mStatusSlot;
+		mGeneration = other.mGeneration;
+		other.mStatusSlot = NO_STATUS;
+	}
+	return self;
+}
+
+AsyncJob::~AsyncJob() {
+	_releaseStatus();
+}
+
+void AsyncJob::setStatus(Status status) {
+	DEBUG_ASSERT(mStatusSlot != NO_STATUS, "This job has no status");
+	getStatusPool()[mStatusSlot].status.store(status, std::memory_order_release);
+}
+
+void AsyncJob::_releaseStatus() {
+	if (mStatusSlot != NO_STATUS) {
+		//the StatusPtrs to this job read NotRunning from now on
+		auto& pool = getStatusPool();
+		pool[mStatusSlot].generation.fetch_add(1, std::memory_order_release);
+		pool.release(mStatusSlot);
+		mStatusSlot = NO_STATUS;
+	}
+}
@@ -0,0 +1,248 @@
+#include "AsyncReadback.h"
+
+#include "Framebuffer.h"
+#include "Texture.h"
+#include "Platform.h"
+#include "WorkerPool.h"
+
+#include "glad/glad.h"
+
+using namespace Dojo;
+
+namespace {
+	//glReadPixels can only return RGBA8 on GLES3
+	const uint32_t PIXEL_SIZE = 4;
+
+	//how long flush() waits for each read before giving up on it
+	const GLuint64 FLUSH_TIMEOUT_NS = 1000000000;
+}
+
+struct AsyncReadback::Request {
+	enum class State {
+		Free,
+		Reading,
+		Mapped
+	};
+
+	State state = State::Free;
+
+	uint32_t pbo = 0;
+	size_t capacity = 0;
+	void* fence = nullptr;
+
+	uint32_t width = 0, height = 0;
+
+	AsyncReadback::PixelTask task;
+	AsyncCallback callback;
+};
+
+AsyncReadback::AsyncReadback() {
+
+}
+
+AsyncReadback::~AsyncReadback() {
+	//the workers could still be reading from mapped buffers
+	for (auto&& request : mRequests) {
+		if (request->state == Request::State::Mapped) {
+			Platform::singleton().getBackgroundPool().sync();
+			break;
+		}
+	}
+
+	for (auto&& request : mRequests) {
+		if (request->fence) {
+			glDeleteSync((GLsync)request->fence);
+		}
+		//deleting a mapped buffer also unmaps it
+		glDeleteBuffers(1, &request->pbo);
+
+		//tell the callbacks still in the queue that the buffer is gone
+		request->pbo = 0;
+	}
+
+	if (mReadFBO) {
+		glDeleteFramebuffers(1, &mReadFBO);
+	}
+}
+
+void AsyncReadback::setMaxRequestsInFlight(uint32_t count) {
+	DEBUG_ASSERT(count > 0, "At least one request must be allowed in flight");
+
+	mMaxRequestsInFlight = count;
+}
+
+Shared<AsyncReadback::Request> AsyncReadback::_acquire(size_t bytes) {
+	if (not canRead()) {
+		return{};
+	}
+
+	//prefer a free buffer that is already large enough
+	Shared<Request> found;
+	for (auto&& request : mRequests) {
+		if (request->state == Request::State::Free) {
+			found = request;
+			if (request->capacity >= bytes) {
+				break;
+			}
+		}
+	}
+
+	if (not found) {
+		found = make_shared<Request>();
+		glGenBuffers(1, &found->pbo);
+		mRequests.push_back(found);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, found->pbo);
+
+	if (found->capacity < bytes) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		found->capacity = bytes;
+	}
+
+	return found;
+}
+
+bool AsyncReadback::_issue(uint32_t surfaceWidth, uint32_t surfaceHeight, const Region& region, PixelTask&& task, AsyncCallback&& callback) {
+	DEBUG_ASSERT_MAIN_THREAD;
+	DEBUG_ASSERT(region.x < surfaceWidth and region.y < surfaceHeight, "The region is outside of the surface");
+
+	auto width = region.width ? region.width : surfaceWidth - region.x;
+	auto height = region.height ? region.height : surfaceHeight - region.y;
+
+	DEBUG_ASSERT(region.x + width <= surfaceWidth and region.y + height <= surfaceHeight, "The region is outside of the surface");
+
+	auto request = _acquire(width * height * PIXEL_SIZE);
+	if (not request) {
+		return false;
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(region.x, region.y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	request->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	request->state = Request::State::Reading;
+	request->width = width;
+	request->height = height;
+	request->task = std::move(task);
+	request->callback = std::move(callback);
+
+	++mRequestsInFlight;
+	mIssued.push_back(std::move(request));
+	return true;
+}
+
+bool AsyncReadback::read(Framebuffer& framebuffer, const Region& region, PixelTask task, AsyncCallback callback) {
+	if (not canRead()) {
+		return false;
+	}
+
+	framebuffer.bind();
+
+	return _issue(framebuffer.getWidth(), framebuffer.getHeight(), region, std::move(task), std::move(callback));
+}
+
+bool AsyncReadback::read(Texture& texture, const Region& region, PixelTask task, AsyncCallback callback) {
+	DEBUG_ASSERT(texture.isLoaded(), "The texture has no GPU data to read");
+	DEBUG_ASSERT(texture.getParentAtlas().is_none(), "Read the atlas instead of its tiles");
+
+	if (not canRead()) {
+		return false;
+	}
+
+	if (not mReadFBO) {
+		glGenFramebuffers(1, &mReadFBO);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mReadFBO);
+	texture._addAsAttachment(0, texture.getWidth(), texture.getHeight(), 0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	auto issued = _issue(texture.getWidth(), texture.getHeight(), region, std::move(task), std::move(callback));
+
+	//don't keep the texture referenced by the framebuffer
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	Texture::gTextureBindingsDirty = true;
+	return issued;
+}
+
+bool AsyncReadback::_tryDispatch(const Shared<Request>& owner, bool wait) {
+	auto& request = *owner;
+
+	auto status = glClientWaitSync(
+		(GLsync)request.fence,
+		wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+		wait ? FLUSH_TIMEOUT_NS : 0);
+
+	bool ready = status == GL_ALREADY_SIGNALED or status == GL_CONDITION_SATISFIED;
+	if (not ready and not wait) {
+		return false;
+	}
+
+	glDeleteSync((GLsync)request.fence);
+	request.fence = nullptr;
+
+	const uint8_t* pixels = nullptr;
+	if (ready) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, request.pbo);
+		pixels = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, request.width * request.height * PIXEL_SIZE, GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		DEBUG_ASSERT(pixels, "Cannot map the readback buffer");
+	}
+
+	request.state = Request::State::Mapped;
+
+	Platform::singleton().getBackgroundPool().queue(
+		[owner, pixels] {
+			if (pixels and owner->task) {
+				owner->task(pixels, owner->width, owner->height);
+			}
+		},
+		[this, owner, pixels] {
+			//the AsyncReadback was destroyed in the meantime
+			if (not owner->pbo) {
+				return;
+			}
+
+			if (pixels) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, owner->pbo);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+
+			auto callback = std::move(owner->callback);
+
+			owner->task = {};
+			owner->callback = {};
+			owner->state = Request::State::Free;
+			--mRequestsInFlight;
+
+			if (callback) {
+				callback();
+			}
+		}
+	);
+	return true;
+}
+
+void AsyncReadback::update() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	//dispatch in order, stop at the first read that isn't complete
+	while (mIssued.size() > 0 and _tryDispatch(mIssued.front(), false)) {
+		mIssued.pop_front();
+	}
+}
+
+void AsyncReadback::flush() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	while (mIssued.size() > 0) {
+		_tryDispatch(mIssued.front(), true);
+		mIssued.pop_front();
+	}
+}
@@ -0,0 +1,34 @@
+#include "ComponentPool.h"
+
+using namespace Dojo;
+
+ComponentPool::ComponentPool() {
+
+}
+
+Component& ComponentPool::add(Unique<Component> component) {
+	std::lock_guard<SpinLock> lock(mLock);
+
+	auto& ref = *component;
+	ref.mPoolIndex = (uint32_t)mComponents.size();
+	mComponents.emplace_back(std::move(component));
+	return ref;
+}
+
+Unique<Component> ComponentPool::remove(Component& component) {
+	std::lock_guard<SpinLock> lock(mLock);
+
+	auto index = component.mPoolIndex;
+	DEBUG_ASSERT(index < mComponents.size() and mComponents[index].get() == &component, "This Component is not in the pool");
+
+	auto owned = std::move(mComponents[index]);
+
+	//move the last one in the hole to keep the array dense
+	if (index + 1 < mComponents.size()) {
+		mComponents[index] = std::move(mComponents.back());
+		mComponents[index]->mPoolIndex = index;
+	}
+	mComponents.pop_back();
+
+	return owned;
+}
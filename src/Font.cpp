@@ -294,6 +294,8 @@ bool Font::Page::onLoad() {
 
 	//drop the buffer in the texture
 	//TODO can probably easily use 565 or less
+	//pages are always drawn pixel-perfect, don't waste time on a mip chain
+	texture->setMipmapsEnabled(false);
 	loaded = texture->loadFromMemory(buf.data(), sxp2, syp2, PixelFormat::RGBA_8_8_8_8);
 	texture->disableBilinearFiltering();
 	texture->disableTiling();
@@ -31,6 +31,9 @@ void FrameSet::setAtlas(const Table& atlasTable, ResourceGroup& atlasTextureProv
 
 	auto& atlas = atlasSet.unwrap().getFrame(0);
 
+	//tiles need the atlas size as soon as they are loaded
+	atlas.setStreamingEnabled(false);
+
 	mPreferredAnimationTime = atlasTable.getNumber("animationFrameTime");
 
 	auto& tiles = atlasTable.getTable("tiles");
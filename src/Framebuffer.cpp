@@ -45,7 +45,7 @@ namespace Dojo {
 
 	void Framebuffer::addColorAttachment(Texture& texture, uint8_t miplevel /*= 0*/) {
 		DEBUG_ASSERT(!isCreated(), "Already configured. Too late");
-		mColorAttachments.emplace_back(TextureAttachment{ &texture, miplevel });
+		mColorAttachments.emplace_back(TextureAttachment{ &texture, miplevel, texture._getHandleGeneration() });
 	}
 
 	void Framebuffer::addDepthAttachment(std::shared_ptr<RenderBuffer> buffer /*= nullptr*/) {
@@ -99,6 +99,7 @@ namespace Dojo {
 				uint32_t i = 0;
 				for (auto&& color : mColorAttachments) {
 					color.texture->_addAsAttachment(i, width, height, color.miplevel);
+					color.handleGeneration = color.texture->_getHandleGeneration();
 					mAttachmentList.push_back(GL_COLOR_ATTACHMENT0 + i);
 					++i;
 				}
@@ -121,6 +122,7 @@ namespace Dojo {
 			}
 			else {
 				glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+				_refreshAttachments();
 			}
 
 			glFrontFace(GL_CW); //invert vertex winding when inverting the view
@@ -129,6 +131,21 @@ namespace Dojo {
 		}
 	}
 
+	void Framebuffer::_refreshAttachments() {
+		uint32_t i = 0;
+		for (auto&& color : mColorAttachments) {
+			auto generation = color.texture->_getHandleGeneration();
+			if (color.handleGeneration != generation) {
+				color.texture->_addAsAttachment(i, getWidth(), getHeight(), color.miplevel);
+				color.handleGeneration = generation;
+
+				//attaching binds the texture
+				Texture::gTextureBindingsDirty = true;
+			}
+			++i;
+		}
+	}
+
 	void Framebuffer::invalidate() {
 		if (not isBackbuffer()) {
 			bind();
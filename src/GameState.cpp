@@ -14,17 +14,29 @@ using namespace Dojo;
 GameState::GameState(Game& parentGame) :
 	Object(self, Vector::Zero, Vector::One),
 	ResourceGroup(),
-	game(parentGame) {
+	game(parentGame),
+	mObjectArena(make_unique<ObjectArena>()),
+	mTransformHierarchy(make_unique<TransformHierarchy>()) {
 	gameState = self; //useful to pass a GameState around as an Object
+	_addTransform(Vector::Zero);
 }
 
 GameState::~GameState() {
 	clear();
+
+	//the hierarchy and the pools are destroyed before the Object base
+	_destroyComponents();
+	_removeTransform();
 }
 
 void GameState::clear() {
 	removeAllChildren();
 
+	//the destructors returned the blocks of the children, unless the GameState has components of its own in there
+	if (mObjectArena->getLiveAllocationCount() == 0) {
+		mObjectArena->release();
+	}
+
 	//flush resources
 	unloadResources(false);
 }
@@ -59,15 +71,11 @@ void GameState::touchAreaAtPoint(const Touch& touch) {
 }
 
 void GameState::addTouchArea(TouchArea& t) {
-	mTouchAreas.emplace_back(&t);
+	mTouchAreas.emplace(&t);
 }
 
 void GameState::removeTouchArea(TouchArea& t) {
-	auto elem = std::find(mTouchAreas.begin(), mTouchAreas.end(), &t);
-
-	if (elem != mTouchAreas.end()) {
-		mTouchAreas.erase(elem);
-	}
+	mTouchAreas.erase(t);
 }
 
 void GameState::updateClickableState() {
@@ -93,14 +101,18 @@ void GameState::onLoop(float dt) {
 	updateClickableState();
 
 	updateChilds(dt);
+
+	mTransformHierarchy->update();
+
+	mObjectArena->endFrame();
 }
 
 void GameState::begin() {
-	active = true;
+	setActive(true);
 	StateInterface::begin();
 }
 
 void GameState::end() {
-	active = false;
+	setActive(false);
 	StateInterface::end();
 }
@@ -0,0 +1,278 @@
+#include "KTXFile.h"
+
+#include "TexFormatInfo.h"
+#include "MipChain.h"
+#include "Path.h"
+#include "Log.h"
+#include "range.h"
+
+#include "glad/glad.h"
+
+using namespace Dojo;
+
+namespace {
+	const uint8_t KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	const uint32_t KTX1_NATIVE_ENDIANNESS = 0x04030201;
+
+	///bigger than any texture a GPU can sample, it keeps the level sizes far from overflowing
+	const uint32_t MAX_DIMENSION = 1 << 16;
+
+	struct KTX1Header {
+		uint32_t endianness;
+		uint32_t glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat;
+		uint32_t pixelWidth, pixelHeight, pixelDepth;
+		uint32_t numberOfArrayElements, numberOfFaces, numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	struct KTX2Header {
+		uint32_t vkFormat, typeSize;
+		uint32_t pixelWidth, pixelHeight, pixelDepth;
+		uint32_t layerCount, faceCount, levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+		uint64_t sgdByteOffset, sgdByteLength;
+	};
+
+	struct KTX2LevelIndex {
+		uint64_t byteOffset, byteLength, uncompressedByteLength;
+	};
+
+	template<typename T>
+	bool readAt(const uint8_t* data, size_t size, size_t offset, T& out) {
+		if (offset > size or sizeof(T) > size - offset) {
+			return false;
+		}
+		//the containers give no alignment guarantees for their headers
+		memcpy(&out, data + offset, sizeof(T));
+		return true;
+	}
+
+	PixelFormat uncompressedFormatFor(uint32_t glInternalFormat) {
+		switch (glInternalFormat) {
+		case GL_RGBA8: return PixelFormat::RGBA_8_8_8_8;
+		case GL_SRGB8_ALPHA8: return PixelFormat::RGBA_8_8_8_8_SRGB;
+		case GL_RGB8: return PixelFormat::RGB_8_8_8;
+		case GL_SRGB8: return PixelFormat::RGB_8_8_8_SRGB;
+		case GL_R8: return PixelFormat::R_8;
+		case GL_RG8: return PixelFormat::RG_8;
+		default: return PixelFormat::Unknown;
+		}
+	}
+
+	PixelFormat formatForVulkan(uint32_t vkFormat) {
+		switch (vkFormat) {
+		case 9: return PixelFormat::R_8; //VK_FORMAT_R8_UNORM
+		case 16: return PixelFormat::RG_8; //VK_FORMAT_R8G8_UNORM
+		case 23: return PixelFormat::RGB_8_8_8; //VK_FORMAT_R8G8B8_UNORM
+		case 29: return PixelFormat::RGB_8_8_8_SRGB; //VK_FORMAT_R8G8B8_SRGB
+		case 37: return PixelFormat::RGBA_8_8_8_8; //VK_FORMAT_R8G8B8A8_UNORM
+		case 43: return PixelFormat::RGBA_8_8_8_8_SRGB; //VK_FORMAT_R8G8B8A8_SRGB
+		case 131: return PixelFormat::BC1_RGB; //VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		case 133: return PixelFormat::BC1_RGBA; //VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		case 135: return PixelFormat::BC2_RGBA; //VK_FORMAT_BC2_UNORM_BLOCK
+		case 137: return PixelFormat::BC3_RGBA; //VK_FORMAT_BC3_UNORM_BLOCK
+		case 138: return PixelFormat::BC3_RGBA_SRGB; //VK_FORMAT_BC3_SRGB_BLOCK
+		case 139: return PixelFormat::BC4_R; //VK_FORMAT_BC4_UNORM_BLOCK
+		case 141: return PixelFormat::BC5_RG; //VK_FORMAT_BC5_UNORM_BLOCK
+		case 145: return PixelFormat::BC7_RGBA; //VK_FORMAT_BC7_UNORM_BLOCK
+		case 146: return PixelFormat::BC7_RGBA_SRGB; //VK_FORMAT_BC7_SRGB_BLOCK
+		case 147: return PixelFormat::ETC2_RGB_8; //VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+		case 148: return PixelFormat::ETC2_RGB_8_SRGB; //VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+		case 151: return PixelFormat::ETC2_RGBA_8; //VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+		case 152: return PixelFormat::ETC2_RGBA_8_SRGB; //VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+		case 153: return PixelFormat::EAC_R_11; //VK_FORMAT_EAC_R11_UNORM_BLOCK
+		case 155: return PixelFormat::EAC_RG_11; //VK_FORMAT_EAC_R11G11_UNORM_BLOCK
+		case 157: return PixelFormat::ASTC_4x4_RGBA; //VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+		case 158: return PixelFormat::ASTC_4x4_RGBA_SRGB; //VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+		case 165: return PixelFormat::ASTC_6x6_RGBA; //VK_FORMAT_ASTC_6x6_UNORM_BLOCK
+		case 166: return PixelFormat::ASTC_6x6_RGBA_SRGB; //VK_FORMAT_ASTC_6x6_SRGB_BLOCK
+		case 171: return PixelFormat::ASTC_8x8_RGBA; //VK_FORMAT_ASTC_8x8_UNORM_BLOCK
+		case 172: return PixelFormat::ASTC_8x8_RGBA_SRGB; //VK_FORMAT_ASTC_8x8_SRGB_BLOCK
+		default: return PixelFormat::Unknown;
+		}
+	}
+}
+
+bool KTXFile::isKTXPath(utf::string_view path) {
+	auto ext = Path::getFileExtension(path);
+	return ext == "ktx" or ext == "ktx2";
+}
+
+KTXFile::KTXFile(utf::string_view path) :
+	mFile(path) {
+
+}
+
+bool KTXFile::open() {
+	if (not mFile.open()) {
+		return false;
+	}
+
+	auto data = mFile.data();
+	auto size = mFile.size();
+
+	if (size >= sizeof(KTX1_IDENTIFIER) and memcmp(data, KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER)) == 0) {
+		return _parseKTX1();
+	}
+	else if (size >= sizeof(KTX2_IDENTIFIER) and memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+		return _parseKTX2();
+	}
+
+	DEBUG_MESSAGE("Not a KTX file");
+	return false;
+}
+
+const uint8_t* KTXFile::getPackedData(const Level& level, std::vector<uint8_t>& buffer) const {
+	auto& formatInfo = TexFormatInfo::getFor(mFormat);
+	if (formatInfo.isCompressed()) {
+		return level.data;
+	}
+
+	auto packedRow = (size_t)level.width * formatInfo.sourcePixelSize;
+	auto paddedRow = (packedRow + mRowAlignment - 1) / mRowAlignment * mRowAlignment;
+	if (packedRow == paddedRow) {
+		return level.data;
+	}
+
+	buffer.resize(packedRow * level.height);
+	for (auto y : range(level.height)) {
+		memcpy(buffer.data() + y * packedRow, level.data + y * paddedRow, packedRow);
+	}
+	return buffer.data();
+}
+
+bool KTXFile::_isComplete(const Level& level) const {
+	auto& formatInfo = TexFormatInfo::getFor(mFormat);
+	if (formatInfo.isCompressed()) {
+		return level.byteSize >= formatInfo.getLevelByteSize(level.width, level.height);
+	}
+
+	auto packedRow = (size_t)level.width * formatInfo.sourcePixelSize;
+	auto paddedRow = (packedRow + mRowAlignment - 1) / mRowAlignment * mRowAlignment;
+	return level.byteSize >= paddedRow * level.height;
+}
+
+bool KTXFile::_parseKTX1() {
+	auto data = mFile.data();
+	auto size = mFile.size();
+
+	KTX1Header header;
+	if (not readAt(data, size, sizeof(KTX1_IDENTIFIER), header)) {
+		return false;
+	}
+
+	if (header.endianness != KTX1_NATIVE_ENDIANNESS) {
+		DEBUG_MESSAGE("KTX files with swapped endianness are not supported");
+		return false;
+	}
+
+	if (header.pixelWidth == 0 or header.pixelWidth > MAX_DIMENSION or header.pixelHeight == 0 or header.pixelHeight > MAX_DIMENSION or
+		header.pixelDepth > 1 or header.numberOfArrayElements > 0 or header.numberOfFaces != 1) {
+		DEBUG_MESSAGE("Only plain 2D KTX textures are supported");
+		return false;
+	}
+
+	//glType is 0 for compressed formats
+	mFormat = header.glType == 0 ?
+		TexFormatInfo::findCompressed(header.glInternalFormat) :
+		uncompressedFormatFor(header.glInternalFormat);
+
+	if (mFormat == PixelFormat::Unknown) {
+		DEBUG_MESSAGE("Unknown KTX internal format");
+		return false;
+	}
+
+	mRowAlignment = 4;
+
+	//a corrupted count could reserve gigabytes, no base size has more levels than its full chain
+	auto levelCount = std::min(
+		std::max(header.numberOfMipmapLevels, 1u),
+		MipChain::getLevelCountFor(header.pixelWidth, header.pixelHeight));
+	size_t offset = sizeof(KTX1_IDENTIFIER) + sizeof(KTX1Header) + header.bytesOfKeyValueData;
+
+	mLevels.reserve(levelCount);
+	for (auto i : range(levelCount)) {
+		uint32_t imageSize;
+		if (not readAt(data, size, offset, imageSize) or imageSize > size - offset - sizeof(imageSize)) {
+			DEBUG_MESSAGE("Truncated KTX file");
+			return false;
+		}
+		offset += sizeof(imageSize);
+
+		mLevels.push_back({
+			std::max(header.pixelWidth >> i, 1u),
+			std::max(header.pixelHeight >> i, 1u),
+			data + offset,
+			imageSize
+		});
+
+		if (not _isComplete(mLevels.back())) {
+			DEBUG_MESSAGE("A KTX level is smaller than its size requires");
+			return false;
+		}
+
+		//each level is padded to 4 bytes
+		offset += ((size_t)imageSize + 3) & ~(size_t)3;
+	}
+
+	return true;
+}
+
+bool KTXFile::_parseKTX2() {
+	auto data = mFile.data();
+	auto size = mFile.size();
+
+	KTX2Header header;
+	if (not readAt(data, size, sizeof(KTX2_IDENTIFIER), header)) {
+		return false;
+	}
+
+	if (header.pixelWidth == 0 or header.pixelWidth > MAX_DIMENSION or header.pixelHeight == 0 or header.pixelHeight > MAX_DIMENSION or
+		header.pixelDepth > 1 or header.layerCount > 1 or header.faceCount != 1) {
+		DEBUG_MESSAGE("Only plain 2D KTX textures are supported");
+		return false;
+	}
+
+	if (header.supercompressionScheme != 0) {
+		DEBUG_MESSAGE("Supercompressed KTX2 files are not supported");
+		return false;
+	}
+
+	mFormat = formatForVulkan(header.vkFormat);
+	if (mFormat == PixelFormat::Unknown) {
+		DEBUG_MESSAGE("Unknown KTX2 vkFormat");
+		return false;
+	}
+
+	auto levelCount = std::min(
+		std::max(header.levelCount, 1u),
+		MipChain::getLevelCountFor(header.pixelWidth, header.pixelHeight));
+	size_t indexOffset = sizeof(KTX2_IDENTIFIER) + sizeof(KTX2Header);
+
+	mLevels.reserve(levelCount);
+	for (auto i : range(levelCount)) {
+		KTX2LevelIndex index;
+		if (not readAt(data, size, indexOffset + i * sizeof(KTX2LevelIndex), index) or
+			index.byteOffset > size or index.byteLength > size - index.byteOffset) {
+			DEBUG_MESSAGE("Truncated KTX2 file");
+			return false;
+		}
+
+		mLevels.push_back({
+			std::max(header.pixelWidth >> i, 1u),
+			std::max(header.pixelHeight >> i, 1u),
+			data + index.byteOffset,
+			(size_t)index.byteLength
+		});
+
+		if (not _isComplete(mLevels.back())) {
+			DEBUG_MESSAGE("A KTX2 level is smaller than its size requires");
+			return false;
+		}
+	}
+
+	return true;
+}
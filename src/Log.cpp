@@ -1,6 +1,5 @@
 #include "Log.h"
 #include "Platform.h"
-#include "BackgroundWorker.h"
 #include "LogListener.h"
 
 using namespace Dojo;
@@ -0,0 +1,99 @@
+#ifdef PLATFORM_WIN32
+#include "dojo_win_header.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+#include "Platform.h"
+
+using namespace Dojo;
+
+MappedFile::MappedFile(utf::string_view path) :
+	mPath(path.copy()) {
+	DEBUG_ASSERT(path.not_empty(), "The file path is empty");
+}
+
+MappedFile::~MappedFile() {
+	if (isOpen()) {
+		close();
+	}
+}
+
+bool MappedFile::open() {
+	DEBUG_ASSERT(not isOpen(), "The file was already open");
+
+#ifdef WIN32
+	auto file = CreateFileW(String::toUTF16(mPath).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) and fileSize.QuadPart > 0) {
+			if (auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+				if (auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) {
+					mFileHandle = file;
+					mMappingHandle = mapping;
+					mData = (const uint8_t*)view;
+					mSize = (size_t)fileSize.QuadPart;
+					return mMapped = true;
+				}
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	auto fd = ::open(mPath.bytes().c_str(), O_RDONLY);
+	if (fd >= 0) {
+		struct stat info;
+		if (fstat(fd, &info) == 0 and info.st_size > 0) {
+			auto view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED) {
+				//the mapping keeps the file alive
+				::close(fd);
+
+				mData = (const uint8_t*)view;
+				mSize = (size_t)info.st_size;
+				return mMapped = true;
+			}
+		}
+		::close(fd);
+	}
+#endif
+
+	//not a plain file, or the OS refused to map it
+	mFallbackBuffer = Platform::singleton().loadFileContent(mPath);
+	if (mFallbackBuffer.empty()) {
+		return false;
+	}
+
+	mData = mFallbackBuffer.data();
+	mSize = mFallbackBuffer.size();
+	mMapped = false;
+	return true;
+}
+
+void MappedFile::close() {
+	DEBUG_ASSERT(isOpen(), "Tried to close a file which wasn't open");
+
+	if (mMapped) {
+#ifdef WIN32
+		UnmapViewOfFile(mData);
+		CloseHandle(mMappingHandle);
+		CloseHandle(mFileHandle);
+		mMappingHandle = mFileHandle = nullptr;
+#else
+		munmap((void*)mData, mSize);
+#endif
+	}
+	else {
+		mFallbackBuffer = {};
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mMapped = false;
+}
@@ -5,9 +5,18 @@
 #include "dojomath.h"
 #include "PrimitiveMode.h"
 #include "enum_cast.h"
+#include "ResidencyManager.h"
+#include "Renderer.h"
+#include "MeshFile.h"
+#include "range.h"
 
 #include "glad/glad.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define DOJO_MESH_SSE2
+	#include <emmintrin.h>
+#endif
+
 using namespace Dojo;
 
 struct VertexFieldInfo {
@@ -25,6 +34,9 @@ static const VERTEX_FIELD_INFO[enum_cast(VertexField::_Count)] = {
 
 	{ GL_HALF_FLOAT, 2, false, 2 * sizeof(GLshort) },	// 	UV
 	{ GL_HALF_FLOAT, 2, false, 2 * sizeof(GLshort) },	// 	UV
+
+	{ GL_UNSIGNED_SHORT, 4, true, 4 * sizeof(GLushort) },	// 	PositionQuantized, w is padding
+	{ GL_SHORT, 2, true, 2 * sizeof(GLshort) },	// 	NormalOctahedral
 };
 
 bool Mesh::gBufferBindingsDirty = true;
@@ -60,9 +72,12 @@ Mesh::~Mesh() {
 void Mesh::destroyBuffers() {
 	auto cleanup = std::move(vertices);
 	cleanup = std::move(indices);
+	cleanup = std::move(mPackedIndices);
+
+	auto positions = std::move(mSourcePositions);
 }
 
-void Mesh::begin(IndexType extimatedVerts /*= 1 */) {
+void Mesh::begin(IndexType extimatedVerts /*= 1 */, uint32_t extimatedIndices /*= 0 */) {
 	//be sure that we aren't already building
 	DEBUG_ASSERT(extimatedVerts > 0, "begin: extimated vertices for this batch must be more than 0");
 	DEBUG_ASSERT(not isEditing(), "begin: this Mesh is already in Edit mode");
@@ -70,12 +85,20 @@ void Mesh::begin(IndexType extimatedVerts /*= 1 */) {
 
 	vertices.clear();
 	indices.clear();
+	mSourcePositions.clear();
 	vertices.reserve(extimatedVerts * vertexSize);
+	indices.reserve(extimatedIndices * indexSize);
+
+	if (_isQuantized()) {
+		mSourcePositions.reserve(extimatedVerts);
+	}
 
 	vertexCount = indexCount = 0;
 	currentVertex = nullptr;
 
 	bounds = AABB::Invalid;
+	mBoundsStart = 0;
+	mMaxIndex = 0;
 	vertexTransparency = false;
 
 	editing = true;
@@ -86,6 +109,7 @@ void Mesh::beginAppend() {
 	DEBUG_ASSERT(dynamic, "can't call append() on a static mesh");
 	DEBUG_ASSERT(vertices.size() > 0, "This mesh was never begin'd!");
 
+	mBoundsStart = vertexCount;
 	editing = true;
 }
 
@@ -112,9 +136,25 @@ void Mesh::setIndexByteSize(uint8_t bytenumber) {
 	}
 }
 
+void Mesh::setAutoIndexSize(bool enabled) {
+	DEBUG_ASSERT(not editing, "setAutoIndexSize must be called BEFORE begin!");
+
+	mAutoIndexSize = enabled;
+
+	//the CPU copy always uses 32 bits, end() picks the GPU type
+	if (enabled) {
+		setIndexByteSize(sizeof(GLuint));
+	}
+}
+
 void Mesh::setVertexFieldEnabled(VertexField f) {
 	DEBUG_ASSERT(not editing, "setVertexFieldEnabled must be called BEFORE begin!");
 
+	//reloading a file enables the same fields again
+	if (isVertexFieldEnabled(f)) {
+		return;
+	}
+
 	vertexFieldOffset[enum_cast(f)] = vertexSize;
 	vertexSize += VERTEX_FIELD_INFO[enum_cast(f)].bytes;
 }
@@ -151,11 +191,12 @@ void Mesh::index(IndexType idx) {
 		break;
 	}
 
+	mMaxIndex = std::max(mMaxIndex, idx);
 	++indexCount;
 }
 
 
-void Mesh::_prepareVertex(const Vector& v) {
+void Mesh::_prepareVertex() {
 	DEBUG_ASSERT(isEditing(), "_prepareVertex: this Mesh is not in Edit mode");
 
 	//grow the buffer to the needed size
@@ -164,15 +205,17 @@ void Mesh::_prepareVertex(const Vector& v) {
 
 	currentVertex = (uint8_t*)vertices.data() + curSize;
 
-	bounds = bounds.expandToFit(v);
-
 	++vertexCount;
 }
 
 Mesh::IndexType Mesh::vertex(const Vector& v) {
-	_prepareVertex(v);
+	_prepareVertex();
 
-	if (isVertexFieldEnabled(VertexField::Position3D)) {
+	if (_isQuantized()) {
+		//encoded in end(), when the bounds are known
+		mSourcePositions.push_back(v);
+	}
+	else if (isVertexFieldEnabled(VertexField::Position3D)) {
 		_field<glm::vec3>(VertexField::Position3D) = v;
 	}
 	else {
@@ -183,6 +226,8 @@ Mesh::IndexType Mesh::vertex(const Vector& v) {
 }
 
 void Mesh::appendRawVertexData(void* data, IndexType count) {
+	DEBUG_ASSERT(not _isQuantized(), "Raw data can't be added to a quantized mesh, the positions are needed to compute its bounds");
+
 	int blobSize = count * vertexSize;
 	int oldSize = vertices.size();
 
@@ -191,11 +236,152 @@ void Mesh::appendRawVertexData(void* data, IndexType count) {
 	auto start = vertices.data() + oldSize;
 	memcpy(start, data, blobSize);
 
-	//TODO max and min??
-
+	//bounds are computed in end()
 	vertexCount += count;
 }
 
+Mesh::Writer Mesh::append(IndexType blockVertices, uint32_t blockIndices /*= 0 */) {
+	DEBUG_ASSERT(isEditing(), "append: this Mesh is not in Edit mode");
+	DEBUG_ASSERT(blockVertices > 0 or blockIndices > 0, "append: nothing to add");
+	DEBUG_ASSERT((uint64_t)vertexCount + blockVertices <= (uint64_t)indexMaxValue + 1, "append: the index format chosen is too small");
+
+	auto firstVertex = (IndexType)vertexCount;
+	auto firstIndex = (uint32_t)indexCount;
+
+	//a single resize per block instead of one per vertex
+	vertices.resize(vertices.size() + blockVertices * vertexSize);
+	indices.resize(indices.size() + blockIndices * indexSize);
+
+	if (_isQuantized()) {
+		mSourcePositions.resize(mSourcePositions.size() + blockVertices);
+	}
+
+	vertexCount += blockVertices;
+	indexCount += blockIndices;
+
+	//vertex() and co. can't be used on the block
+	currentVertex = nullptr;
+
+	return{ self, firstVertex, blockVertices, firstIndex, blockIndices };
+}
+
+Mesh::Writer::Writer(Mesh& mesh, IndexType firstVertex, IndexType vertexCount, uint32_t firstIndex, uint32_t indexCount) :
+	firstVertex(firstVertex),
+	vertexCount(vertexCount),
+	indexCount(indexCount),
+	mMesh(mesh),
+	mVertices(mesh.vertices.data() + firstVertex * mesh.vertexSize),
+	mIndices(mesh.indices.data() + firstIndex * mesh.indexSize),
+	mIs3D(mesh.isVertexFieldEnabled(VertexField::Position3D)),
+	mQuantized(mesh._isQuantized()) {
+
+}
+
+void Mesh::Writer::color(IndexType i, const Color& c) {
+	DEBUG_ASSERT(i < vertexCount, "Vertex out of the block");
+
+	mMesh.vertexTransparency |= c.a < 1.f;
+	field<uint32_t>(VertexField::Color)[i] = c.toRGBA();
+}
+
+void Mesh::Writer::normal(IndexType i, const Vector& n) {
+	DEBUG_ASSERT(i < vertexCount, "Vertex out of the block");
+
+	if (mMesh.isVertexFieldEnabled(VertexField::NormalOctahedral)) {
+		field<uint32_t>(VertexField::NormalOctahedral)[i] = packNormalOctahedral(n);
+	}
+	else {
+		field<uint32_t>(VertexField::Normal)[i] = packNormal(n);
+	}
+}
+
+void Mesh::Writer::indices(uint32_t start, std::initializer_list<IndexType> local) {
+	DEBUG_ASSERT(start + local.size() <= indexCount, "Indices out of the block");
+
+	//switch once per call rather than once per index
+	switch (mMesh.indexSize) {
+	case 1: {
+		auto out = (uint8_t*)mIndices + start;
+		for (auto&& idx : local) {
+			*out++ = (uint8_t)(firstVertex + idx);
+		}
+		break;
+	}
+	case 2: {
+		auto out = (uint16_t*)mIndices + start;
+		for (auto&& idx : local) {
+			*out++ = (uint16_t)(firstVertex + idx);
+		}
+		break;
+	}
+	case 4: {
+		auto out = (uint32_t*)mIndices + start;
+		for (auto&& idx : local) {
+			*out++ = (uint32_t)(firstVertex + idx);
+		}
+		break;
+	}
+	}
+
+	if (local.size() > 0) {
+		mMesh.mMaxIndex = std::max(mMesh.mMaxIndex, firstVertex + *std::max_element(local.begin(), local.end()));
+	}
+}
+
+void Mesh::_updateBounds() {
+	if (mBoundsStart >= vertexCount) {
+		return;
+	}
+
+	bool is3D = isVertexFieldEnabled(VertexField::Position3D);
+	auto position = vertices.data() + vertexFieldOffset[enum_cast(is3D ? VertexField::Position3D : VertexField::Position2D)];
+	auto stride = vertexSize;
+
+	//quantized positions are read from the full precision copy
+	if (_isQuantized()) {
+		is3D = true;
+		position = (uint8_t*)mSourcePositions.data();
+		stride = sizeof(Vector);
+	}
+
+#ifdef DOJO_MESH_SSE2
+	auto first = position + mBoundsStart * stride;
+	__m128 v = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)first);
+	if (is3D) {
+		v = _mm_movelh_ps(v, _mm_load_ss((const float*)first + 2));
+	}
+
+	__m128 min = v, max = v;
+	for (auto i : range(mBoundsStart + 1, vertexCount)) {
+		auto ptr = position + i * stride;
+
+		//load exactly the components of the field, the rest of the vertex could be anything
+		v = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)ptr);
+		if (is3D) {
+			v = _mm_movelh_ps(v, _mm_load_ss((const float*)ptr + 2));
+		}
+
+		min = _mm_min_ps(min, v);
+		max = _mm_max_ps(max, v);
+	}
+
+	alignas(16) float minOut[4], maxOut[4];
+	_mm_store_ps(minOut, min);
+	_mm_store_ps(maxOut, max);
+
+	AABB block = { { minOut[0], minOut[1], minOut[2] }, { maxOut[0], maxOut[1], maxOut[2] } };
+#else
+	AABB block = AABB::Invalid;
+	for (auto i : range(mBoundsStart, vertexCount)) {
+		auto ptr = (const float*)(position + i * stride);
+		block = block.expandToFit(Vector(ptr[0], ptr[1], is3D ? ptr[2] : 0.f));
+	}
+#endif
+
+	bounds = bounds.expandToFit(block);
+	mBoundsStart = vertexCount;
+}
+
 int Mesh::getPrimitiveCount() const {
 	auto elemCount = isIndexed() ? getIndexCount() : getVertexCount();
 
@@ -238,21 +424,77 @@ void Mesh::color(const Color& c) {
 }
 
 void Mesh::normal(const Vector& n) {
-	DEBUG_ASSERT(std::abs(n.x) <= 1.f and std::abs(n.y) <= 1.f and std::abs(n.z) <= 1.f, "normal is too long, cannot pack");
 	DEBUG_ASSERT(isEditing(), "normal: this Mesh is not in Edit mode");
 
-	auto& val = _field<GLuint>(VertexField::Normal);
-	val = 0;
-	val |= (Math::packNormalized<int>(n.z, 511) << 20);
-	val |= (Math::packNormalized<int>(n.y, 511) << 10);
-	val |= (Math::packNormalized<int>(n.x, 511) << 0);
+	if (isVertexFieldEnabled(VertexField::NormalOctahedral)) {
+		_field<GLuint>(VertexField::NormalOctahedral) = packNormalOctahedral(n);
+	}
+	else {
+		_field<GLuint>(VertexField::Normal) = packNormal(n);
+	}
 }
 
-void Mesh::bindVertexFormat(const Shader& shader) {
+uint32_t Mesh::packNormalOctahedral(const Vector& n) {
+	auto length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	DEBUG_ASSERT(length > 0, "Cannot pack a zero normal");
+
+	//project on the octahedron, then fold the lower half over the upper one
+	auto ex = n.x / length, ey = n.y / length;
+	if (n.z < 0) {
+		auto fx = (1.f - std::abs(ey)) * (ex >= 0 ? 1.f : -1.f);
+		ey = (1.f - std::abs(ex)) * (ey >= 0 ? 1.f : -1.f);
+		ex = fx;
+	}
+
+	auto x = (uint16_t)(int16_t)std::round(glm::clamp(ex, -1.f, 1.f) * 32767.f);
+	auto y = (uint16_t)(int16_t)std::round(glm::clamp(ey, -1.f, 1.f) * 32767.f);
+	return x | ((uint32_t)y << 16);
+}
+
+Mesh::QuantizedPosition Mesh::packPositionQuantized(const Vector& v, const AABB& extent) {
+	auto size = extent.getSize();
+
+	QuantizedPosition q = {};
+	for (auto i : range(3)) {
+		//flat axes decode to the offset alone
+		if (size[i] > 0) {
+			q[i] = (uint16_t)std::round(glm::clamp((v[i] - extent.min[i]) / size[i], 0.f, 1.f) * 65535.f);
+		}
+	}
+	return q;
+}
+
+void Mesh::_quantizePositions() {
+	DEBUG_ASSERT(mSourcePositions.size() == (size_t)vertexCount, "The positions weren't all written");
+
+	mQuantizationBounds = bounds;
+
+	auto view = FieldView<QuantizedPosition>(vertices.data() + vertexFieldOffset[enum_cast(VertexField::PositionQuantized)], vertexSize);
+	for (auto i : range(vertexCount)) {
+		view[i] = packPositionQuantized(mSourcePositions[i], mQuantizationBounds);
+	}
+}
+
+uint32_t Mesh::packNormal(const Vector& n) {
+	DEBUG_ASSERT(std::abs(n.x) <= 1.f and std::abs(n.y) <= 1.f and std::abs(n.z) <= 1.f, "normal is too long, cannot pack");
+
+	//mask each component, or the sign bits of a negative one overwrite the next
+	uint32_t val = 0;
+	val |= (Math::packNormalized<int>(n.z, 511) & 0x3ff) << 20;
+	val |= (Math::packNormalized<int>(n.y, 511) & 0x3ff) << 10;
+	val |= (Math::packNormalized<int>(n.x, 511) & 0x3ff) << 0;
+	return val;
+}
+
+uint8_t Mesh::getVertexFieldSize(VertexField field) {
+	return VERTEX_FIELD_INFO[enum_cast(field)].bytes;
+}
+
+void Mesh::bindVertexFormat(const Shader& shader, IndexType baseVertex /*= 0 */) {
 	for (auto&& attribute : shader.getAttributes()) {
 		DEBUG_ASSERT(isVertexFieldEnabled(attribute.builtInAttribute), "This mesh doesn't provide a required attribute");
 
-		auto offset = (void*)vertexFieldOffset[enum_cast(attribute.builtInAttribute)];
+		auto offset = (void*)(vertexFieldOffset[enum_cast(attribute.builtInAttribute)] + (uintptr_t)baseVertex * vertexSize);
 		auto& field = VERTEX_FIELD_INFO[enum_cast(attribute.builtInAttribute)];
 
 		glEnableVertexAttribArray(attribute.location);
@@ -277,46 +519,207 @@ bool Mesh::end() {
 		return false;
 	}
 
-	//create the VBO
-	if (not vertexHandle) {
-		glGenBuffers(1, &vertexHandle);
+	currentVertex = nullptr;
+
+	_updateBounds();
+
+	//appended vertices can grow the bounds, so every position is encoded again
+	if (_isQuantized()) {
+		_quantizePositions();
+	}
+
+	auto indexData = indices.data();
+	auto indexBytes = indices.size();
+
+	if (mAutoIndexSize) {
+		_packIndices();
+
+		if (mPackedIndices.size() > 0) {
+			indexData = mPackedIndices.data();
+			indexBytes = mPackedIndices.size();
+		}
+	}
+
+	_uploadToGPU(vertices.data(), vertices.size(), indexData, indexBytes);
+
+	if (not dynamic) { //won't be updated ever again
+		destroyBuffers();
+	}
+	//dynamic meshes keep the capacity for the next update
+	mPackedIndices.clear();
+
+	return loaded;
+}
+
+void Mesh::_packIndices() {
+	mPackedIndices.clear();
+	mSubmeshes.clear();
+	indexGLType = GL_UNSIGNED_INT;
+
+	if (indexCount == 0) {
+		return;
+	}
+
+	auto source = (const uint32_t*)indices.data();
+
+	//keep 32 bits if splitting isn't worth it
+	if (mMaxIndex > 0xffff and not _splitSubmeshes(source)) {
+		return;
+	}
+
+	if (mMaxIndex <= 0xff) {
+		indexGLType = GL_UNSIGNED_BYTE;
+		mPackedIndices.resize(indexCount);
+
+		auto out = mPackedIndices.data();
+		for (auto i : range(indexCount)) {
+			out[i] = (uint8_t)source[i];
+		}
+		return;
+	}
+
+	indexGLType = GL_UNSIGNED_SHORT;
+	mPackedIndices.resize(indexCount * sizeof(uint16_t));
+
+	auto out = (uint16_t*)mPackedIndices.data();
+	if (mSubmeshes.empty()) {
+		for (auto i : range(indexCount)) {
+			out[i] = (uint16_t)source[i];
+		}
+	}
+	else {
+		for (auto&& submesh : mSubmeshes) {
+			for (auto i : range(submesh.indexStart, submesh.indexStart + submesh.indexCount)) {
+				out[i] = (uint16_t)(source[i] - submesh.baseVertex);
+			}
+		}
+	}
+}
+
+bool Mesh::_splitSubmeshes(const uint32_t* source) {
+	//strips can't be cut at any index
+	uint32_t primitiveSize;
+	switch (triangleMode) {
+	case PrimitiveMode::TriangleList:
+		primitiveSize = 3;
+		break;
+	case PrimitiveMode::LineList:
+		primitiveSize = 2;
+		break;
+	case PrimitiveMode::PointList:
+		primitiveSize = 1;
+		break;
+	default:
+		return false;
+	}
+
+	DEBUG_ASSERT(indexCount % primitiveSize == 0, "The indices don't make whole primitives");
+
+	//greedily grow each submesh until its indices don't fit in 16 bits anymore
+	Submesh current = { 0, 0, source[0] };
+	IndexType maxIndex = source[0];
+
+	for (uint32_t i = 0; i + primitiveSize <= (uint32_t)indexCount; i += primitiveSize) {
+		auto primitiveMin = *std::min_element(source + i, source + i + primitiveSize);
+		auto primitiveMax = *std::max_element(source + i, source + i + primitiveSize);
+
+		auto newMin = std::min(current.baseVertex, primitiveMin);
+		auto newMax = std::max(maxIndex, primitiveMax);
+
+		if (newMax - newMin > 0xffff) {
+			mSubmeshes.push_back(current);
+			current = { i, 0, primitiveMin };
+			maxIndex = primitiveMax;
+		}
+		else {
+			current.baseVertex = newMin;
+			maxIndex = newMax;
+		}
+
+		current.indexCount += primitiveSize;
 	}
 
-	uint32_t usage = (dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
-	glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), usage);
+	mSubmeshes.push_back(current);
+
+	if (mSubmeshes.size() * MIN_SUBMESH_INDICES > (uint32_t)indexCount) {
+		mSubmeshes.clear();
+		return false;
+	}
+
+	return true;
+}
 
+bool Mesh::_uploadToGPU(const uint8_t* vertexData, size_t vertexBytes, const uint8_t* indexData, size_t indexBytes) {
+	DEBUG_ASSERT(not mArenaAllocation.isValid(), "This mesh is already in the arena");
 
-	//create the IBO
-	if (isIndexed()) { //we support unindexed meshes
-		if (not indexHandle) {
-			glGenBuffers(1, &indexHandle);
+	//small static meshes share their buffers with the others with the same layout
+	if (not dynamic and mSubmeshes.empty() and (uint32_t)vertexCount <= MeshArena::MAX_MESH_VERTICES) {
+		auto indexByteSize = indexCount > 0 ? (uint8_t)(indexBytes / indexCount) : 0;
+
+		auto& arena = Platform::singleton().getRenderer().getMeshArena();
+		mArenaAllocation = arena.allocate(
+			{ vertexSize, vertexFieldOffset },
+			vertexData,
+			vertexCount,
+			indexData,
+			indexCount,
+			indexByteSize);
+
+		if (mArenaAllocation.isValid()) {
+			mArena = &arena;
+		}
+	}
+
+	if (mArenaAllocation.isValid()) {
+		indexBytes = indexCount * sizeof(GLushort);
+	}
+	else {
+		//create the VBO
+		if (not vertexHandle) {
+			glGenBuffers(1, &vertexHandle);
 		}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexHandle);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size(), indices.data(), usage);
+		uint32_t usage = (dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+		glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, usage);
+
+		//create the IBO
+		if (indexBytes > 0) { //we support unindexed meshes
+			if (not indexHandle) {
+				glGenBuffers(1, &indexHandle);
+			}
 
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexHandle);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, usage);
+		}
 	}
 
 	loaded = true;
 
-	currentVertex = nullptr;
+	size = (int)(vertexBytes + indexBytes);
+	Platform::singleton().getResidencyManager()._notifyLoaded(*this);
 
 	//geometric hints
 	center = bounds.getCenter();
 	dimensions = bounds.getSize();
 
-	if (not dynamic) { //won't be updated ever again
-		destroyBuffers();
-	}
-
 	gBufferBindingsDirty = true;
 	return loaded;
 }
 
+uint32_t Mesh::getIndexGLType() const {
+	//the arena rebases the indices to 16 bits
+	return mArenaAllocation.isValid() ? GL_UNSIGNED_SHORT : indexGLType;
+}
+
 void Mesh::bind() {
-	glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, isIndexed() ? indexHandle : 0); //only bind the index buffer if existing (duh)
+	if (mArenaAllocation.isValid()) {
+		mArena->bind(mArenaAllocation);
+	}
+	else {
+		glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, isIndexed() ? indexHandle : 0); //only bind the index buffer if existing (duh)
+	}
 
 	gBufferBindingsDirty = false;
 }
@@ -328,66 +731,39 @@ bool Mesh::onLoad() {
 		return false;
 	}
 
-	//load binary mesh
-	auto buf = Platform::singleton().loadFileContent(filePath);
-
-	DEBUG_ASSERT_INFO(buf.size() > 0, "onLoad: cannot find or read file", "path = " + filePath);
+	//the file is mapped and its streams go straight to the GPU, without copies
+	MeshFile file(filePath);
+	bool opened = file.open();
 
-	uint8_t* ptr = buf.data();
-
-	//index size
-	setIndexByteSize(*ptr++);
+	DEBUG_ASSERT_INFO(opened, "onLoad: cannot find or read file", "path = " + filePath);
+	if (not opened) {
+		return false;
+	}
 
-	//triangle mode
-	setTriangleMode((PrimitiveMode)*ptr++);
+	setIndexByteSize(file.getIndexByteSize());
+	setTriangleMode(file.getPrimitiveMode());
 
-	//fields
-	for (int i = 0; i < (int)VertexField::_Count; ++i) {
-		if (*ptr++) {
+	for (auto i : range(enum_cast(VertexField::_Count))) {
+		if (file.isFieldEnabled((VertexField)i)) {
 			setVertexFieldEnabled((VertexField)i);
 		}
 	}
 
-	//max and min
-	Vector loadedMax;
-	memcpy(&loadedMax, ptr, sizeof(Vector));
-	ptr += sizeof(Vector);
-
-	Vector loadedMin;
-	memcpy(&loadedMin, ptr, sizeof(Vector));
-	ptr += sizeof(Vector);
-
-	//vertex count
-	IndexType vc = *((IndexType*)ptr);
-	ptr += sizeof(IndexType);
-
-	//index count
-	uint32_t ic = *((uint32_t*)ptr);
-	ptr += sizeof(uint32_t);
-
-	setDynamic(false);
-
-	begin(vc);
-
-	//grab vertex data
-	vertices.resize(vc * vertexSize);
-	memcpy((char*)vertices.data(), ptr, vc * vertexSize);
-	ptr += vc * vertexSize;
-
-	//grab index data
-	if (ic) {
-		indices.resize(ic * indexSize);
-		memcpy((char*)indices.data(), ptr, ic * indexSize);
+	//a file with extra or missing bytes per vertex would be uploaded misaligned
+	if (file.getVertexStride() != vertexSize) {
+		DEBUG_MESSAGE("onLoad: the vertex size doesn't match the fields, path = " + filePath);
+		return false;
 	}
 
-	bounds.max = loadedMax;
-	bounds.min = loadedMin;
+	setDynamic(false);
 
-	vertexCount = vc;
-	indexCount = ic;
+	vertexCount = file.getVertexCount();
+	indexCount = file.getIndexCount();
+	bounds = file.getBounds();
+	mQuantizationBounds = bounds;
 
 	//push over to GPU
-	return end();
+	return _uploadToGPU(file.getVertexData(), file.getVertexDataSize(), file.getIndexData(), file.getIndexDataSize());
 }
 
 void Mesh::onUnload(bool soft /*= false */) {
@@ -395,6 +771,11 @@ void Mesh::onUnload(bool soft /*= false */) {
 
 	//when soft unloading, only unload file-based meshes
 	if (not soft or isReloadable()) {
+		if (mArenaAllocation.isValid()) {
+			mArena->free(mArenaAllocation);
+			mArena = nullptr;
+		}
+
 		glDeleteBuffers(1, &vertexHandle);
 		glDeleteBuffers(1, &indexHandle);
 
@@ -404,12 +785,20 @@ void Mesh::onUnload(bool soft /*= false */) {
 
 		destroyBuffers(); //free CPU side memory
 
+		ResidencyManager::_notifyUnloaded(*this);
+		size = 0;
+
 		gBufferBindingsDirty = true;
 		loaded = false;
 	}
 }
 
 Vector& Mesh::getVertex(int idx) {
+	if (_isQuantized()) {
+		DEBUG_ASSERT(mSourcePositions.size() > (size_t)idx, "The positions of a quantized mesh are only available while it's editable");
+		return mSourcePositions[idx];
+	}
+
 	auto field = isVertexFieldEnabled(VertexField::Position3D) ? VertexField::Position3D : VertexField::Position3D;
 	auto offset = vertexFieldOffset[enum_cast(field)];
 	uint8_t* ptr = (uint8_t*)vertices.data() + (idx * vertexSize) + offset;
@@ -420,6 +809,8 @@ Vector& Mesh::getVertex(int idx) {
 void Mesh::setIndex(int idxidx, IndexType idx) {
 	DEBUG_ASSERT(idxidx >= 0 and idxidx < getIndexCount(), "Index out of bounds");
 
+	mMaxIndex = std::max(mMaxIndex, idx);
+
 	switch (indexSize) {
 	case 1:
 		((uint8_t*)indices.data())[idxidx] = (uint8_t)idx;
@@ -470,6 +861,10 @@ void Mesh::cutSection(IndexType i1, IndexType i2) {
 	auto start = vertices.begin() + i1 * vertexSize;
 	vertices.erase(start, start + size);
 
+	if (_isQuantized()) {
+		mSourcePositions.erase(mSourcePositions.begin() + i1, mSourcePositions.begin() + i2);
+	}
+
 	//remove the indices
 	if (isIndexed()) {
 
@@ -493,6 +888,7 @@ Unique<Mesh> Mesh::cloneWithSameFormat() const {
 	auto c = make_unique<Mesh>();
 
 	c->setIndexByteSize(indexSize);
+	c->mAutoIndexSize = mAutoIndexSize;
 	c->setTriangleMode(triangleMode);
 	c->vertexSize = vertexSize;
 	c->vertexFieldOffset = vertexFieldOffset;
@@ -519,6 +915,10 @@ Unique<Mesh> Mesh::cloneFromSlice(IndexType vertexStart, IndexType vertexEnd, co
 
 		memcpy(c->vertices.data(), vertices.data() + off, size);
 
+		if (_isQuantized()) {
+			c->mSourcePositions.assign(mSourcePositions.begin() + vertexStart, mSourcePositions.begin() + vertexEnd);
+		}
+
 		for (int i = 0; i < c->vertexCount; ++i) {
 			auto& v = c->getVertex(i);
 			v += translation;
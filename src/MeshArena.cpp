@@ -0,0 +1,210 @@
+#include "MeshArena.h"
+
+#include "range.h"
+
+#include "glad/glad.h"
+
+using namespace Dojo;
+
+MeshArena::FreeList::FreeList(uint32_t capacity) {
+	ranges.push_back({ 0, capacity });
+}
+
+bool MeshArena::FreeList::allocate(uint32_t count, uint32_t& start) {
+	for (auto itr = ranges.begin(); itr != ranges.end(); ++itr) {
+		if (itr->count >= count) {
+			start = itr->start;
+			itr->start += count;
+			itr->count -= count;
+
+			if (itr->count == 0) {
+				ranges.erase(itr);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshArena::FreeList::release(uint32_t start, uint32_t count) {
+	auto next = std::lower_bound(ranges.begin(), ranges.end(), start, [](const Range& range, uint32_t start) {
+		return range.start < start;
+	});
+
+	//merge with the neighbours when they touch
+	bool mergePrevious = next != ranges.begin() and (next - 1)->start + (next - 1)->count == start;
+	bool mergeNext = next != ranges.end() and start + count == next->start;
+
+	if (mergePrevious and mergeNext) {
+		(next - 1)->count += count + next->count;
+		ranges.erase(next);
+	}
+	else if (mergePrevious) {
+		(next - 1)->count += count;
+	}
+	else if (mergeNext) {
+		next->start = start;
+		next->count += count;
+	}
+	else {
+		ranges.insert(next, { start, count });
+	}
+}
+
+MeshArena::Page::Page(const Layout& layout) :
+	layout(layout),
+	vertices(PAGE_VERTICES),
+	indices(PAGE_INDICES) {
+	glGenBuffers(1, &vertexHandle);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
+	glBufferData(GL_ARRAY_BUFFER, (size_t)PAGE_VERTICES * layout.vertexSize, nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &indexHandle);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexHandle);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, PAGE_INDICES * sizeof(GLushort), nullptr, GL_STATIC_DRAW);
+}
+
+MeshArena::MeshArena() {
+
+}
+
+MeshArena::~MeshArena() {
+	for (auto&& page : mPages) {
+		glDeleteBuffers(1, &page->vertexHandle);
+		glDeleteBuffers(1, &page->indexHandle);
+	}
+}
+
+MeshArena::Allocation MeshArena::allocate(const Layout& layout, const uint8_t* vertexData, uint32_t vertexCount, const uint8_t* indexData, uint32_t indexCount, uint8_t indexByteSize) {
+	DEBUG_ASSERT(vertexCount > 0, "Cannot allocate an empty mesh");
+	DEBUG_ASSERT(indexCount == 0 or indexByteSize == 1 or indexByteSize == 2 or indexByteSize == 4, "Invalid index size");
+
+	Allocation allocation;
+	if (vertexCount > MAX_MESH_VERTICES or indexCount > PAGE_INDICES) {
+		return allocation;
+	}
+
+	allocation.vertexCount = vertexCount;
+	allocation.indexCount = indexCount;
+
+	auto tryPage = [&](Page& page) {
+		if (not page.vertices.allocate(vertexCount, allocation.firstVertex)) {
+			return false;
+		}
+
+		if (indexCount > 0 and not page.indices.allocate(indexCount, allocation.firstIndex)) {
+			page.vertices.release(allocation.firstVertex, vertexCount);
+			return false;
+		}
+
+		allocation.page = &page;
+		return true;
+	};
+
+	for (auto&& page : mPages) {
+		if (page->layout == layout and tryPage(*page)) {
+			break;
+		}
+	}
+
+	if (not allocation.isValid()) {
+		mPages.emplace_back(make_unique<Page>(layout));
+		tryPage(*mPages.back());
+	}
+
+	auto& page = *allocation.page;
+	++page.allocations;
+
+	glBindBuffer(GL_ARRAY_BUFFER, page.vertexHandle);
+	glBufferSubData(GL_ARRAY_BUFFER, (size_t)allocation.firstVertex * layout.vertexSize, (size_t)vertexCount * layout.vertexSize, vertexData);
+
+	if (indexCount > 0) {
+		//there's no base vertex on GLES3, so the indices are moved to where the vertices are
+		std::vector<GLushort> rebased(indexCount);
+		for (auto i : range(indexCount)) {
+			uint32_t index;
+			switch (indexByteSize) {
+			case 1:
+				index = indexData[i];
+				break;
+			case 2:
+				index = ((const uint16_t*)indexData)[i];
+				break;
+			default:
+				index = ((const uint32_t*)indexData)[i];
+			}
+
+			DEBUG_ASSERT(index < vertexCount, "Index out of the mesh vertices");
+			rebased[i] = (GLushort)(allocation.firstVertex + index);
+		}
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexHandle);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.firstIndex * sizeof(GLushort), indexCount * sizeof(GLushort), rebased.data());
+	}
+
+	return allocation;
+}
+
+void MeshArena::free(Allocation& allocation) {
+	DEBUG_ASSERT(allocation.isValid(), "This allocation isn't in the arena");
+
+	auto& page = *allocation.page;
+	page.vertices.release(allocation.firstVertex, allocation.vertexCount);
+	if (allocation.indexCount > 0) {
+		page.indices.release(allocation.firstIndex, allocation.indexCount);
+	}
+
+	//give the VRAM back as soon as nothing uses the page
+	if (--page.allocations == 0) {
+		glDeleteBuffers(1, &page.vertexHandle);
+		glDeleteBuffers(1, &page.indexHandle);
+
+		mPages.erase(std::find_if(mPages.begin(), mPages.end(), [&](const Unique<Page>& p) {
+			return p.get() == &page;
+		}));
+	}
+
+	allocation = {};
+}
+
+void MeshArena::bind(const Allocation& allocation) const {
+	DEBUG_ASSERT(allocation.isValid(), "This allocation isn't in the arena");
+
+	glBindBuffer(GL_ARRAY_BUFFER, allocation.page->vertexHandle);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, allocation.page->indexHandle);
+}
+
+MeshArena::Stats MeshArena::getStats() const {
+	Stats stats;
+	size_t freeBytes = 0, contiguousBytes = 0;
+
+	for (auto&& page : mPages) {
+		auto vertexSize = page->layout.vertexSize;
+
+		++stats.pages;
+		stats.allocations += page->allocations;
+		stats.capacityBytes += (size_t)PAGE_VERTICES * vertexSize + PAGE_INDICES * sizeof(GLushort);
+
+		auto countFree = [&](const FreeList& list, size_t elementSize) {
+			size_t largest = 0;
+			for (auto&& free : list.ranges) {
+				auto bytes = free.count * elementSize;
+				freeBytes += bytes;
+				largest = std::max(largest, bytes);
+				++stats.freeBlocks;
+			}
+
+			contiguousBytes += largest;
+			stats.largestFreeBlockBytes = std::max(stats.largestFreeBlockBytes, largest);
+		};
+
+		countFree(page->vertices, vertexSize);
+		countFree(page->indices, sizeof(GLushort));
+	}
+
+	stats.usedBytes = stats.capacityBytes - freeBytes;
+	if (freeBytes > 0) {
+		stats.fragmentation = 1.f - contiguousBytes / (float)freeBytes;
+	}
+	return stats;
+}
@@ -0,0 +1,328 @@
+#include "MeshFile.h"
+
+#include "Log.h"
+#include "range.h"
+#include "enum_cast.h"
+
+using namespace Dojo;
+
+namespace {
+	const char MAGIC[4] = { 'D', 'M', 'S', 'H' };
+
+	//the legacy format stores one byte for each field that existed when it was written
+	const uint8_t LEGACY_FIELD_COUNT = enum_cast(VertexField::UVMax) + 1;
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t headerSize; //header and section table
+		uint32_t sectionCount;
+		uint32_t fieldMask;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint8_t indexByteSize;
+		uint8_t primitiveMode;
+		uint8_t reserved[14];
+	};
+
+	struct SectionEntry {
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t byteSize;
+	};
+
+	struct BoundsSection {
+		float min[3], max[3];
+		float reserved[2];
+	};
+
+	static_assert(sizeof(Header) % MeshFile::ALIGNMENT == 0, "The header must keep the sections aligned");
+	static_assert(sizeof(BoundsSection) % MeshFile::ALIGNMENT == 0, "Sections must have an aligned size");
+	static_assert(sizeof(MeshFile::LOD) == 16 and sizeof(MeshFile::Submesh) == 16, "Unexpected padding in the file structures");
+
+	template<typename T>
+	bool readAt(const uint8_t* data, size_t size, size_t offset, T& out) {
+		if (offset > size or sizeof(T) > size - offset) {
+			return false;
+		}
+		memcpy(&out, data + offset, sizeof(T));
+		return true;
+	}
+
+	size_t alignUp(size_t offset) {
+		return (offset + MeshFile::ALIGNMENT - 1) & ~(MeshFile::ALIGNMENT - 1);
+	}
+
+	bool isValidIndexSize(uint8_t size) {
+		return size == 1 or size == 2 or size == 4;
+	}
+}
+
+MeshFile::MeshFile(utf::string_view path) :
+	mFile(make_unique<MappedFile>(path)) {
+
+}
+
+bool MeshFile::open() {
+	DEBUG_ASSERT(mFile, "This MeshFile has no backing file");
+
+	if (not mFile->open()) {
+		return false;
+	}
+
+	return _parse(mFile->data(), mFile->size());
+}
+
+bool MeshFile::_parse(const uint8_t* data, size_t size) {
+	if (size >= sizeof(MAGIC) and memcmp(data, MAGIC, sizeof(MAGIC)) == 0) {
+		return _parseV2(data, size);
+	}
+
+	//legacy files have no magic, they start with the index size
+	return _parseLegacy(data, size);
+}
+
+bool MeshFile::_parseV2(const uint8_t* data, size_t size) {
+	Header header;
+	if (not readAt(data, size, 0, header)) {
+		DEBUG_MESSAGE("Truncated mesh header");
+		return false;
+	}
+
+	if (header.version != VERSION) {
+		DEBUG_MESSAGE("Unsupported mesh version " + utf::to_string(header.version));
+		return false;
+	}
+
+	if (not isValidIndexSize(header.indexByteSize) or header.primitiveMode > (uint8_t)PrimitiveMode::PointList) {
+		DEBUG_MESSAGE("Invalid mesh header");
+		return false;
+	}
+
+	mVersion = header.version;
+	mIndexByteSize = header.indexByteSize;
+	mPrimitiveMode = (PrimitiveMode)header.primitiveMode;
+	mFieldMask = header.fieldMask;
+	mVertexStride = header.vertexStride;
+	mVertexCount = header.vertexCount;
+	mIndexCount = header.indexCount;
+
+	for (auto i : range(header.sectionCount)) {
+		SectionEntry section;
+		if (not readAt(data, size, sizeof(Header) + i * sizeof(SectionEntry), section)) {
+			DEBUG_MESSAGE("Truncated mesh section table");
+			return false;
+		}
+
+		if (section.offset % ALIGNMENT != 0 or
+			section.offset > size or section.byteSize > size - section.offset) {
+			DEBUG_MESSAGE("Invalid mesh section");
+			return false;
+		}
+
+		auto sectionData = data + section.offset;
+		auto sectionSize = (size_t)section.byteSize;
+
+		switch ((SectionType)section.type) {
+		case SectionType::VertexStream:
+			if (sectionSize != getVertexDataSize()) {
+				DEBUG_MESSAGE("The vertex stream doesn't match the header");
+				return false;
+			}
+			mVertexData = sectionData;
+			break;
+
+		case SectionType::Indices:
+			if (sectionSize != getIndexDataSize()) {
+				DEBUG_MESSAGE("The index stream doesn't match the header");
+				return false;
+			}
+			mIndexData = sectionData;
+			break;
+
+		case SectionType::Bounds: {
+			BoundsSection bounds;
+			if (not readAt(sectionData, sectionSize, 0, bounds)) {
+				return false;
+			}
+			mBounds.min = Vector(bounds.min[0], bounds.min[1], bounds.min[2]);
+			mBounds.max = Vector(bounds.max[0], bounds.max[1], bounds.max[2]);
+			break;
+		}
+
+		case SectionType::LODs:
+			mLODs.resize(sectionSize / sizeof(LOD));
+			memcpy(mLODs.data(), sectionData, mLODs.size() * sizeof(LOD));
+			break;
+
+		case SectionType::Submeshes:
+			mSubmeshes.resize(sectionSize / sizeof(Submesh));
+			memcpy(mSubmeshes.data(), sectionData, mSubmeshes.size() * sizeof(Submesh));
+			break;
+
+		default:
+			//unknown sections are skipped so that they can be added without a version bump
+			break;
+		}
+	}
+
+	if (not mVertexData or (mIndexCount > 0 and not mIndexData)) {
+		DEBUG_MESSAGE("The mesh has no vertex or index data");
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshFile::_parseLegacy(const uint8_t* data, size_t size) {
+	size_t offset = 0;
+
+	uint8_t indexByteSize, primitiveMode;
+	if (not readAt(data, size, offset++, indexByteSize) or not readAt(data, size, offset++, primitiveMode)) {
+		return false;
+	}
+
+	if (not isValidIndexSize(indexByteSize) or primitiveMode > (uint8_t)PrimitiveMode::PointList) {
+		DEBUG_MESSAGE("Not a valid mesh file");
+		return false;
+	}
+
+	uint32_t fieldMask = 0;
+	for (auto i : range(LEGACY_FIELD_COUNT)) {
+		uint8_t enabled;
+		if (not readAt(data, size, offset++, enabled)) {
+			return false;
+		}
+		if (enabled) {
+			fieldMask |= 1 << i;
+		}
+	}
+
+	Vector max, min;
+	uint32_t vertexCount, indexCount;
+	if (not readAt(data, size, offset, max) or
+		not readAt(data, size, offset + sizeof(Vector), min) or
+		not readAt(data, size, offset + 2 * sizeof(Vector), vertexCount) or
+		not readAt(data, size, offset + 2 * sizeof(Vector) + sizeof(uint32_t), indexCount)) {
+		DEBUG_MESSAGE("Truncated mesh file");
+		return false;
+	}
+	offset += 2 * sizeof(Vector) + 2 * sizeof(uint32_t);
+
+	//the stride isn't stored, it's whatever is left once the indices are accounted for
+	auto indexBytes = (size_t)indexCount * indexByteSize;
+	if (vertexCount == 0 or indexBytes > size - offset or (size - offset - indexBytes) % vertexCount != 0) {
+		DEBUG_MESSAGE("Truncated mesh file");
+		return false;
+	}
+
+	mVersion = 1;
+	mIndexByteSize = indexByteSize;
+	mPrimitiveMode = (PrimitiveMode)primitiveMode;
+	mFieldMask = fieldMask;
+	mVertexCount = vertexCount;
+	mIndexCount = indexCount;
+	mVertexStride = (uint32_t)((size - offset - indexBytes) / vertexCount);
+
+	mBounds.min = min;
+	mBounds.max = max;
+
+	mVertexData = data + offset;
+	mIndexData = indexCount ? mVertexData + getVertexDataSize() : nullptr;
+
+	return true;
+}
+
+std::vector<uint8_t> MeshFile::serialize(const Description& desc) {
+	DEBUG_ASSERT(isValidIndexSize(desc.indexByteSize), "Invalid index size");
+	DEBUG_ASSERT(desc.vertices and desc.vertexCount > 0 and desc.vertexStride > 0, "The mesh has no vertices");
+	DEBUG_ASSERT(desc.indexCount == 0 or desc.indices, "The indices are missing");
+
+	struct Section {
+		SectionType type;
+		const void* data;
+		size_t byteSize;
+	};
+
+	BoundsSection bounds = {
+		{ desc.bounds.min.x, desc.bounds.min.y, desc.bounds.min.z },
+		{ desc.bounds.max.x, desc.bounds.max.y, desc.bounds.max.z },
+		{ 0, 0 }
+	};
+
+	std::vector<Section> sections = {
+		{ SectionType::Bounds, &bounds, sizeof(bounds) },
+		{ SectionType::VertexStream, desc.vertices, (size_t)desc.vertexCount * desc.vertexStride }
+	};
+
+	if (desc.indexCount > 0) {
+		sections.push_back({ SectionType::Indices, desc.indices, (size_t)desc.indexCount * desc.indexByteSize });
+	}
+	if (desc.lods.size() > 0) {
+		sections.push_back({ SectionType::LODs, desc.lods.data(), desc.lods.size() * sizeof(LOD) });
+	}
+	if (desc.submeshes.size() > 0) {
+		sections.push_back({ SectionType::Submeshes, desc.submeshes.data(), desc.submeshes.size() * sizeof(Submesh) });
+	}
+
+	Header header = {};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.headerSize = (uint32_t)(sizeof(Header) + sections.size() * sizeof(SectionEntry));
+	header.sectionCount = (uint32_t)sections.size();
+	header.vertexStride = desc.vertexStride;
+	header.vertexCount = desc.vertexCount;
+	header.indexCount = desc.indexCount;
+	header.indexByteSize = desc.indexByteSize;
+	header.primitiveMode = (uint8_t)desc.primitiveMode;
+
+	for (auto&& field : desc.fields) {
+		header.fieldMask |= 1 << (uint32_t)field;
+	}
+
+	//lay out the sections one after the other, each on an aligned offset
+	std::vector<SectionEntry> table;
+	size_t offset = alignUp(header.headerSize);
+	for (auto&& section : sections) {
+		table.push_back({ (uint32_t)section.type, 0, offset, section.byteSize });
+		offset = alignUp(offset + section.byteSize);
+	}
+
+	std::vector<uint8_t> out(offset, 0);
+	memcpy(out.data(), &header, sizeof(header));
+	memcpy(out.data() + sizeof(header), table.data(), table.size() * sizeof(SectionEntry));
+
+	for (auto i : range(sections.size())) {
+		memcpy(out.data() + table[i].offset, sections[i].data, sections[i].byteSize);
+	}
+
+	return out;
+}
+
+bool MeshFile::convertLegacy(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+	MeshFile legacy;
+	if (not legacy._parseLegacy(data, size)) {
+		return false;
+	}
+
+	Description desc;
+	desc.indexByteSize = legacy.mIndexByteSize;
+	desc.primitiveMode = legacy.mPrimitiveMode;
+	desc.vertexStride = legacy.mVertexStride;
+	desc.vertexCount = legacy.mVertexCount;
+	desc.indexCount = legacy.mIndexCount;
+	desc.vertices = legacy.mVertexData;
+	desc.indices = legacy.mIndexData;
+	desc.bounds = legacy.mBounds;
+
+	for (auto i : range(enum_cast(VertexField::_Count))) {
+		if (legacy.isFieldEnabled((VertexField)i)) {
+			desc.fields.push_back((VertexField)i);
+		}
+	}
+
+	out = serialize(desc);
+	return true;
+}
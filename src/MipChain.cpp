@@ -0,0 +1,205 @@
+#include "MipChain.h"
+
+#include "TexFormatInfo.h"
+#include "range.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define DOJO_MIPCHAIN_SSE2
+	#include <emmintrin.h>
+#endif
+
+using namespace Dojo;
+
+namespace {
+	const uint32_t LINEAR_TO_SRGB_STEPS = 4096;
+
+	struct SRGBTables {
+		float toLinear[256];
+		uint8_t toSRGB[LINEAR_TO_SRGB_STEPS];
+
+		SRGBTables() {
+			for (auto i : range(256)) {
+				float c = i / 255.f;
+				toLinear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (auto i : range(LINEAR_TO_SRGB_STEPS)) {
+				float l = i / (float)(LINEAR_TO_SRGB_STEPS - 1);
+				float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+				toSRGB[i] = (uint8_t)(c * 255.f + 0.5f);
+			}
+		}
+	};
+
+	const SRGBTables& getSRGBTables() {
+		static const SRGBTables tables;
+		return tables;
+	}
+
+	void _downsampleGeneric(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dest, uint32_t destWidth, uint32_t destHeight, uint32_t pixelSize) {
+		//when a side is 1 wide there's nothing to average on that axis, so sample the same texel twice
+		auto xStep = srcWidth > 1 ? pixelSize : 0;
+		auto rowStride = srcWidth * pixelSize;
+		auto yStep = srcHeight > 1 ? rowStride : 0;
+
+		for (auto y : range(destHeight)) {
+			auto row0 = src + (y * 2) * rowStride;
+			auto row1 = row0 + yStep;
+
+			for (uint32_t x = 0; x < destWidth; ++x, dest += pixelSize) {
+				auto a = row0 + x * 2 * pixelSize;
+				auto b = row1 + x * 2 * pixelSize;
+
+				for (auto c : range(pixelSize)) {
+					dest[c] = (uint8_t)((a[c] + a[c + xStep] + b[c] + b[c + xStep] + 2) >> 2);
+				}
+			}
+		}
+	}
+
+	void _downsampleSRGB(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dest, uint32_t destWidth, uint32_t destHeight, uint32_t pixelSize) {
+		auto& tables = getSRGBTables();
+
+		auto xStep = srcWidth > 1 ? pixelSize : 0;
+		auto rowStride = srcWidth * pixelSize;
+		auto yStep = srcHeight > 1 ? rowStride : 0;
+		auto colorChannels = std::min(pixelSize, 3u);
+
+		for (auto y : range(destHeight)) {
+			auto row0 = src + (y * 2) * rowStride;
+			auto row1 = row0 + yStep;
+
+			for (uint32_t x = 0; x < destWidth; ++x, dest += pixelSize) {
+				auto a = row0 + x * 2 * pixelSize;
+				auto b = row1 + x * 2 * pixelSize;
+
+				for (auto c : range(colorChannels)) {
+					float linear = (
+						tables.toLinear[a[c]] +
+						tables.toLinear[a[c + xStep]] +
+						tables.toLinear[b[c]] +
+						tables.toLinear[b[c + xStep]]) * 0.25f;
+
+					dest[c] = tables.toSRGB[(uint32_t)(linear * (LINEAR_TO_SRGB_STEPS - 1) + 0.5f)];
+				}
+
+				//alpha is never gamma encoded
+				for (auto c = colorChannels; c < pixelSize; ++c) {
+					dest[c] = (uint8_t)((a[c] + a[c + xStep] + b[c] + b[c + xStep] + 2) >> 2);
+				}
+			}
+		}
+	}
+
+#ifdef DOJO_MIPCHAIN_SSE2
+	///4 bytes per pixel fast path, produces exactly the same results as _downsampleGeneric
+	void _downsampleRGBA8SSE2(const uint8_t* src, uint32_t srcWidth, uint8_t* dest, uint32_t destWidth, uint32_t destHeight) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		auto rowStride = srcWidth * 4;
+
+		for (auto y : range(destHeight)) {
+			auto row0 = src + (y * 2) * rowStride;
+			auto row1 = row0 + rowStride;
+			auto out = dest + y * destWidth * 4;
+
+			uint32_t x = 0;
+			//2 destination pixels per iteration
+			for (; x + 2 <= destWidth; x += 2, out += 8) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+				__m128i sum = _mm_unpacklo_epi64(lo, hi);
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+
+				_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(sum, zero));
+			}
+
+			//odd leftover
+			for (; x < destWidth; ++x, out += 4) {
+				auto a = row0 + x * 8;
+				auto b = row1 + x * 8;
+				for (auto c : range(4)) {
+					out[c] = (uint8_t)((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+				}
+			}
+		}
+	}
+#endif
+
+	void _downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dest, uint32_t destWidth, uint32_t destHeight, const TexFormatInfo& info) {
+		auto pixelSize = (uint32_t)info.sourcePixelSize;
+
+		if (info.sRGB) {
+			_downsampleSRGB(src, srcWidth, srcHeight, dest, destWidth, destHeight, pixelSize);
+		}
+#ifdef DOJO_MIPCHAIN_SSE2
+		else if (pixelSize == 4 and srcWidth > 1 and srcHeight > 1) {
+			_downsampleRGBA8SSE2(src, srcWidth, dest, destWidth, destHeight);
+		}
+#endif
+		else {
+			_downsampleGeneric(src, srcWidth, srcHeight, dest, destWidth, destHeight, pixelSize);
+		}
+	}
+}
+
+uint32_t MipChain::getLevelCountFor(uint32_t width, uint32_t height) {
+	auto side = std::max(width, height);
+	uint32_t count = 1;
+	while (side > 1) {
+		side >>= 1;
+		++count;
+	}
+	return count;
+}
+
+bool MipChain::canGenerate(PixelFormat format) {
+	switch (format) {
+	case PixelFormat::RGBA_8_8_8_8:
+	case PixelFormat::RGBA_8_8_8_8_SRGB:
+	case PixelFormat::RGB_8_8_8:
+	case PixelFormat::RGB_8_8_8_SRGB:
+	case PixelFormat::R_8:
+	case PixelFormat::RG_8:
+	case PixelFormat::A_8:
+		return true;
+	default:
+		return false;
+	}
+}
+
+MipChain MipChain::generate(const uint8_t* base, uint32_t width, uint32_t height, PixelFormat format) {
+	DEBUG_ASSERT(base, "null image data");
+	DEBUG_ASSERT(width > 0 and height > 0, "Invalid dimensions");
+	DEBUG_ASSERT(canGenerate(format), "Cannot generate mipmaps for this format");
+
+	auto& info = TexFormatInfo::getFor(format);
+
+	MipChain chain(format, 1);
+	chain.levels.reserve(getLevelCountFor(width, height) - 1);
+
+	auto src = base;
+	while (width > 1 or height > 1) {
+		Level level;
+		level.width = std::max(width / 2, 1u);
+		level.height = std::max(height / 2, 1u);
+		level.data.resize(level.width * level.height * info.sourcePixelSize);
+
+		_downsample(src, width, height, level.data.data(), level.width, level.height, info);
+
+		width = level.width;
+		height = level.height;
+
+		chain.levels.emplace_back(std::move(level));
+		src = chain.levels.back().data.data();
+	}
+
+	return chain;
+}
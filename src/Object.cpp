@@ -6,30 +6,70 @@
 #include "Renderer.h"
 #include "Platform.h"
 #include "range.h"
+#include "WorkerPool.h"
 
 using namespace Dojo;
 using namespace glm;
 
+struct Object::DeferredCommand {
+	enum class Type {
+		AddChild,
+		Dispose,
+		Collect
+	};
+
+	Type type;
+	Object* target;
+	Unique<Object> child;
+};
+
+thread_local Object::DeferredCommandList* Object::gDeferredCommands = nullptr;
+const size_t Object::MIN_CHILDREN_PER_JOB;
+
 Object::Object(Object& parentObject, const Vector& pos, const Vector& bbSize):
-	position(pos),
 	active(true),
 	disposed(false) {
+	//the GameState adds its own transform once it's constructed
 	if (auto gs = parentObject.gameState.to_ref()) {
 		gameState = gs.get();
+		_addTransform(pos);
 	}
 	setSize(bbSize);
 }
 
 Object::~Object() {
+	_destroyComponents();
+
+	removeAllChildren();
+
+	_removeTransform();
+}
+
+void Object::_addTransform(const Vector& position) {
+	mTransforms = gameState.unwrap().getTransformHierarchy();
+	mTransformID = mTransforms.unwrap().add(position, Quaternion());
+}
+
+void Object::_removeTransform() {
+	if (auto transforms = mTransforms.to_ref()) {
+		transforms.get().remove(mTransformID);
+		mTransforms = {};
+		mTransformID = TransformHierarchy::NONE;
+	}
+}
+
+void Object::_destroyComponents() {
 	//allow each component to grab its own ownership, eg. for threaded destruction
-	for(auto&& c : components) {
-		if(c) {
-			auto& ref = *c;
-			ref.onDestroy(std::move(c));
+	for (auto i : range((int)ComponentID::_count)) {
+		if (auto c = components[i]) {
+			components[i] = nullptr;
+			c->onDestroy(gameState.unwrap().getComponentPool(i).remove(*c));
 		}
 	}
+}
 
-	removeAllChildren();
+ObjectArena& Object::_getArena() {
+	return gameState.unwrap().getObjectArena();
 }
 
 void Object::_addChildEvent(Object& child) {
@@ -63,12 +103,18 @@ bool Object::isAttachedToScene() const {
 
 Object& Object::_addChild(Unique<Object> o) {
 	DEBUG_ASSERT(o->parent.is_none(), "The child you want to attach already has a parent");
-	DEBUG_ASSERT(not children.contains(o), "Element already in the vector!");
+	DEBUG_ASSERT(not children.contains(*o), "Element already in the vector!");
 
 	auto& child = *o;
-	child.parent = self;
 
-	children.emplace(std::move(o));
+	//the parents of the other jobs' Objects might be reading the children now
+	if (gDeferredCommands) {
+		gDeferredCommands->push_back({ DeferredCommand::Type::AddChild, this, std::move(o) });
+		return child;
+	}
+
+	_linkChild(std::move(o));
+
 	if (isAttachedToScene()) {
 		_addChildEvent(child);
 	}
@@ -79,6 +125,19 @@ Object& Object::_addChild(Unique<Object> o) {
 	return child;
 }
 
+void Object::_linkChild(Unique<Object> o) {
+	auto& child = *o;
+	child.parent = self;
+	mTransforms.unwrap().setParent(child.mTransformID, mTransformID);
+	child._updateActive();
+
+	if (child.disposed) {
+		mHasDisposedChildren = true;
+	}
+
+	children.emplace(std::move(o));
+}
+
 void Object::_unregisterChild(Object& child) {
 	//call onAttach on all of the children components
 	for (auto&& c : child.components) {
@@ -88,19 +147,18 @@ void Object::_unregisterChild(Object& child) {
 	}
 
 	child.parent = {};
+	mTransforms.unwrap().setParent(child.mTransformID, TransformHierarchy::NONE);
+	child._updateActive();
 }
 
 Unique<Object> Object::removeChild(Object& o) {
 	DEBUG_ASSERT( hasChilds(), "This Object has no childs" );
+	DEBUG_ASSERT(not gDeferredCommands, "Children can't be removed during a parallel update, use dispose instead");
 
-	auto elem = ChildList::find(children, o);
-
-	DEBUG_ASSERT(elem != children.end(), "This object is not a child");
+	DEBUG_ASSERT(children.contains(o), "This object is not a child");
 
-	auto child = std::move(*elem);
-	_unregisterChild(*child);
-	children.erase(elem);
-	return child;
+	_unregisterChild(o);
+	return children.remove(o);
 }
 
 bool Object::canDestroy() const {
@@ -114,16 +172,39 @@ bool Object::canDestroy() const {
 }
 
 void Object::collectChilds() {
-	for (size_t i = 0; i < children.size(); ++i) {
-		auto& child = children[i];
+	//the destructors might touch shared state, they run after the parallel update
+	if (gDeferredCommands) {
+		gDeferredCommands->push_back({ DeferredCommand::Type::Collect, this, nullptr });
+		return;
+	}
+
+	//a destructor might dispose of other children, only then another pass is needed
+	bool waiting = false;
+	while (mHasDisposedChildren) {
+		mHasDisposedChildren = false;
+
+		std::vector<Unique<Object>> collected;
+		children.eraseIf([&](Unique<Object>& child) {
+			if (not child->disposed) {
+				return false;
+			}
+
+			if (not child->canDestroy()) {
+				waiting = true;
+				return false;
+			}
 
-		if (child->disposed and child->canDestroy()) {
 			_unregisterChild(*child);
-			children.erase(child);
+			collected.emplace_back(std::move(child));
+			return true;
+		});
 
-			i = 0; //a destructor might dispose of other children...
-		}
+		//destroy them only now that the list is consistent again
+		collected.clear();
 	}
+
+	//the ones that can't be destroyed yet are checked again next time
+	mHasDisposedChildren = waiting;
 }
 
 Object::ChildList Object::removeAllChildren() {
@@ -163,12 +244,19 @@ Vector Object::getWorldPosition(const Vector& localPos) const {
 	return {pos.x, pos.y, pos.z};
 }
 
-bool Object::isActive() const {
-	return active and not disposed and (parent.is_none() or parent.unwrap().isActive());
+void Object::_updateActive() {
+	auto effectivelyActive = _computeActive();
+	if (effectivelyActive != mEffectivelyActive) {
+		mEffectivelyActive = effectivelyActive;
+
+		for (auto&& child : children) {
+			child->_updateActive();
+		}
+	}
 }
 
 void Object::reset() {
-	active = true;
+	setActive(true);
 	speed.x = speed.y = 0;
 
 	updateWorldTransform();
@@ -196,34 +284,33 @@ Vector Object::getLocalDirection(const Vector& worldDir) {
 }
 
 Radians Object::getRoll() const {
-	return Radians(glm::roll(rotation));
+	return Radians(glm::roll(getRotation()));
 }
 
 Matrix Object::getFullTransformRelativeTo(const Matrix& parent) const {
-	return glm::translate(parent, position) * mat4_cast(rotation);
+	return glm::translate(parent, getPosition()) * mat4_cast(getRotation());
 }
 
 Matrix Object::getParentWorldTransform() const {
-	//compute local matrix from position and orientation
-	if (auto p = parent.to_ref()) {
-		return p.get().getWorldTransform();
-	}
-	return Matrix{ 1 };
+	return mTransforms.unwrap().getParentWorldTransform(mTransformID);
 }
 
 void Object::updateWorldTransform() {
-	mWorldTransform = getFullTransformRelativeTo(getParentWorldTransform());
+	mTransforms.unwrap().updateWorldTransform(mTransformID);
 }
 
 void Object::updateChilds(float dt) {
 	if (children.size() > 0) {
 
-		//WARNING: do not use a ranged for loop in this one!
-		//a child might remove any other child from the array
-		//so we need to always check with the updated size
-		for (size_t i = 0; i < children.size(); ++i) {
-			if (children[i]->isActive()) {
-				children[i]->onAction(dt);
+		//the children of a parallel job are updated serially, and so are the ones too few to split
+		if (not mParallelChildUpdate or gDeferredCommands or not _updateChildsParallel(dt)) {
+			//WARNING: do not use a ranged for loop in this one!
+			//a child might remove any other child from the array
+			//so we need to always check with the updated size
+			for (size_t i = 0; i < children.size(); ++i) {
+				if (children[i]->isActive()) {
+					children[i]->onAction(dt);
+				}
 			}
 		}
 
@@ -231,10 +318,82 @@ void Object::updateChilds(float dt) {
 	}
 }
 
-void Object::onAction(float dt) {
-	position += speed * dt;
+bool Object::_updateChildsParallel(float dt) {
+	auto& pool = mChildUpdatePool.is_some() ? mChildUpdatePool.unwrap() : Platform::singleton().getBackgroundPool();
+	if (not pool.isAsync) {
+		return false;
+	}
 
-	updateWorldTransform();
+	std::vector<Object*> objects, mainThreadObjects;
+
+	for (auto&& child : children) {
+		if (child->isActive()) {
+			(child->mMainThreadOnly ? mainThreadObjects : objects).push_back(child.get());
+		}
+	}
+
+	auto chunkCount = std::min<size_t>(pool.getWorkerCount() + 1, objects.size() / MIN_CHILDREN_PER_JOB);
+	if (chunkCount < 2) {
+		return false;
+	}
+
+	//the commands are kept by chunk and not by thread, so that they replay in the same order each time
+	auto chunkSize = (uint32_t)((objects.size() + chunkCount - 1) / chunkCount);
+	std::vector<DeferredCommandList> chunkCommands(chunkCount);
+
+	auto& transforms = mTransforms.unwrap();
+	transforms.beginParallel();
+
+	pool.parallelFor((uint32_t)objects.size(), chunkSize, [&](uint32_t begin, uint32_t end) {
+		gDeferredCommands = &chunkCommands[begin / chunkSize];
+
+		for (auto i = begin; i < end; ++i) {
+			objects[i]->onAction(dt);
+		}
+
+		gDeferredCommands = nullptr;
+	});
+
+	transforms.endParallel();
+
+	//replay the commands in chunk order, the collections last so that no command targets a destroyed Object
+	for (auto&& commands : chunkCommands) {
+		for (auto&& command : commands) {
+			switch (command.type) {
+			case DeferredCommand::Type::AddChild:
+				command.target->_addChild(std::move(command.child));
+				break;
+			case DeferredCommand::Type::Dispose:
+				command.target->_dispose();
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	for (auto&& commands : chunkCommands) {
+		for (auto&& command : commands) {
+			if (command.type == DeferredCommand::Type::Collect) {
+				command.target->collectChilds();
+			}
+		}
+	}
+
+	for (auto&& object : mainThreadObjects) {
+		if (object->isActive()) {
+			object->onAction(dt);
+		}
+	}
+
+	return true;
+}
+
+void Object::onAction(float dt) {
+	//the world transform is computed later by the TransformHierarchy, and only if something moved
+	if (speed != Vector::Zero) {
+		setPosition(getPosition() + speed * dt);
+	}
 
 	updateChilds(dt);
 }
@@ -250,9 +409,24 @@ void Object::setAllChildrenVisibleHACK(bool visible) {
 }
 
 void Object::dispose() {
+	//onDispose might touch shared state, it runs after the parallel update
+	if (gDeferredCommands) {
+		gDeferredCommands->push_back({ DeferredCommand::Type::Dispose, this, nullptr });
+		return;
+	}
+
+	_dispose();
+}
+
+void Object::_dispose() {
 	DEBUG_ASSERT(not disposed, "Already disposed");
 
 	disposed = true;
+	_updateActive();
+
+	if (auto p = parent.to_ref()) {
+		p.get().mHasDisposedChildren = true;
+	}
 
 	onDispose();
 	for (auto&& c : components) {
@@ -278,15 +452,22 @@ void Object::setSize(const Vector& bbSize) {
 
 Component& Object::_addComponent(Unique<Component> c, int ID) {
 	DEBUG_ASSERT(parent.is_none(), "The object has been already added to the scene");
+	DEBUG_ASSERT(ID >= 0 and ID < ComponentID::_count, "Invalid ComponentID, add it to the ComponentID enum");
 
-	if (ID >= (int)components.size()) {
-		components.resize(ID + 1); //TODO this is shitty very much, need a better O(1) method of storage
+	auto& pool = gameState.unwrap().getComponentPool(ID);
+
+	//a new component replaces the old one
+	if (auto old = components[ID]) {
+		pool.remove(*old);
 	}
 
+	//registered before onAttach, so that the Renderer can tell the Renderable is the Component of this Object
+	auto& component = pool.add(std::move(c));
+	components[ID] = &component;
+
 	if(isAttachedToScene()) {
-		c->onAttach(); //call onAttach immediately because the object is already attached
+		component.onAttach(); //call onAttach immediately because the object is already attached
 	}
 
-	components[ID] = std::move(c);
-	return *components[ID];
+	return component;
 }
@@ -0,0 +1,101 @@
+#include "ObjectArena.h"
+
+using namespace Dojo;
+
+const size_t ObjectArena::CHUNK_SIZE;
+const size_t ObjectArena::GRANULARITY;
+const size_t ObjectArena::MAX_BLOCK_SIZE;
+const size_t ObjectArena::HEADER_SIZE;
+
+void* ObjectArena::allocateFromHeap(size_t size) {
+	auto header = (Header*)::operator new(HEADER_SIZE + size);
+	header->arena = nullptr;
+	header->sizeClass = 0;
+	return (uint8_t*)header + HEADER_SIZE;
+}
+
+void ObjectArena::free(void* ptr) {
+	if (not ptr) {
+		return;
+	}
+
+	auto header = (Header*)((uint8_t*)ptr - HEADER_SIZE);
+	if (header->arena) {
+		header->arena->_deallocate(header);
+	}
+	else {
+		::operator delete(header);
+	}
+}
+
+ObjectArena::ObjectArena() {
+	mFreeLists.fill(nullptr);
+}
+
+ObjectArena::~ObjectArena() {
+	DEBUG_ASSERT(mLiveAllocations == 0, "Some blocks of this arena are still alive");
+}
+
+void* ObjectArena::allocate(size_t size) {
+	auto blockSize = (HEADER_SIZE + size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+
+	std::lock_guard<SpinLock> lock(mLock);
+
+	if (blockSize > MAX_BLOCK_SIZE) {
+		++mCurrentFrameStats.heapAllocations;
+		return allocateFromHeap(size);
+	}
+
+	auto sizeClass = (uint32_t)(blockSize / GRANULARITY);
+	Header* header;
+
+	if (auto block = mFreeLists[sizeClass]) {
+		mFreeLists[sizeClass] = block->next;
+		header = (Header*)block;
+		++mCurrentFrameStats.recycled;
+	}
+	else {
+		//the rest of the last chunk is wasted, at most MAX_BLOCK_SIZE out of CHUNK_SIZE
+		if (mChunkOffset + blockSize > CHUNK_SIZE) {
+			mChunks.emplace_back(new uint8_t[CHUNK_SIZE]);
+			mChunkOffset = 0;
+		}
+
+		header = (Header*)(mChunks.back().get() + mChunkOffset);
+		mChunkOffset += blockSize;
+	}
+
+	header->arena = this;
+	header->sizeClass = sizeClass;
+
+	++mLiveAllocations;
+	++mCurrentFrameStats.allocations;
+	return (uint8_t*)header + HEADER_SIZE;
+}
+
+void ObjectArena::_deallocate(Header* header) {
+	std::lock_guard<SpinLock> lock(mLock);
+
+	auto sizeClass = header->sizeClass;
+	auto block = (FreeBlock*)header;
+	block->next = mFreeLists[sizeClass];
+	mFreeLists[sizeClass] = block;
+
+	--mLiveAllocations;
+	++mCurrentFrameStats.frees;
+}
+
+void ObjectArena::release() {
+	DEBUG_ASSERT(mLiveAllocations == 0, "Cannot release an arena that still has live blocks");
+
+	mChunks.clear();
+	mChunkOffset = CHUNK_SIZE;
+	mFreeLists.fill(nullptr);
+}
+
+void ObjectArena::endFrame() {
+	mCurrentFrameStats.liveAllocations = mLiveAllocations;
+	mCurrentFrameStats.chunkBytes = mChunks.size() * CHUNK_SIZE;
+	mLastFrameStats = mCurrentFrameStats;
+	mCurrentFrameStats = {};
+}
@@ -13,6 +13,7 @@
 #include "Renderer.h"
 #include "FontSystem.h"
 #include "Game.h"
+#include "ResidencyManager.h"
 
 #if defined (PLATFORM_WIN32)
 	#include "win32/Win32Platform.h"
@@ -95,7 +96,7 @@ Platform::Platform(const Table& configTable) :
 
 	//create thread pools
 	//map the main thread to the thread pool system
-	mPools.push_back(make_unique<WorkerPool>(1, false, true)); 
+	mPools.push_back(make_unique<WorkerPool>(1, false));
 
 	//allocate cpus-1 threads
 	//TODO handle asymmetric processors such as BIG.little that should use half the cores
@@ -104,6 +105,8 @@ Platform::Platform(const Table& configTable) :
 	for(auto&& p : mPools) {
 		mAllPools.emplace(p.get());
 	}
+
+	mResidency = make_unique<ResidencyManager>();
 }
 
 Platform::~Platform() {
@@ -92,7 +92,8 @@ void RenderState::apply(const GlobalUniformData& currentState, optional_ref<cons
 	auto prev = lastState.to_raw_ptr();
 
 	bool rebindFormat = false;
-	if (not prev or prev->mesh != mesh or Mesh::gBufferBindingsDirty) {
+	//meshes in the same arena page share the buffers and the vertex format
+	if (not prev or not prev->mesh.unwrap().sharesBuffersWith(mesh.unwrap()) or Mesh::gBufferBindingsDirty) {
 		//when the mesh changes, the uniforms have to be rebound too
 		rebindFormat = true;
 		mesh.unwrap().bind();
@@ -112,11 +113,12 @@ void RenderState::apply(const GlobalUniformData& currentState, optional_ref<cons
 	for (auto i : range(maxTextureSlots)) {
 		//select current slot and load it, others can remain bound to old stuff with shaders
 		if (auto t = textures[i].to_ref()) {
-			if (not prev or textures[i] != prev->textures[i]) {
+			if (not prev or textures[i] != prev->textures[i] or Texture::gTextureBindingsDirty) {
 				t.get().bind(i);
 			}
 		}
 	}
+	Texture::gTextureBindingsDirty = false;
 
 	bool useBlending = isBlendingEnabled();
 	if (not prev or prev->isBlendingEnabled() != useBlending) {
@@ -66,27 +66,30 @@ void Renderable::startFade(float startAlpha, float endAlpha, float duration) {
 
 void Renderable::update(float dt) {
 	if (auto m = mesh.to_ref()) {
-		auto trans = glm::scale(object.getWorldTransform(), scale);
-
 		advanceFade(dt);
 
+		//the version changes whenever the world transform is recomputed, no need to compare the matrices
+		auto version = object.getTransformVersion();
 		auto& meshBounds = m.get().getBounds();
-		if (trans != mTransform or meshBounds != mLastMeshBB) {
+		if (version != mLastTransformVersion or scale != mLastScale or meshBounds != mLastMeshBB) {
 			AABB bounds = m.get().getBounds();
 			bounds.max = Vector::mul(bounds.max, scale);
 			bounds.min = Vector::mul(bounds.min, scale);
 
 			//TODO this caching is really fiddly and 6 floats just for it is hmmm
 			mWorldBB = object.transformAABB(bounds);
-			mTransform = trans;
+			mTransform = glm::scale(object.getWorldTransform(), scale);
 			mLastMeshBB = meshBounds;
+			mLastScale = scale;
+			mLastTransformVersion = version;
 		}
 	}
 }
 
 bool Renderable::canBeRendered() const {
 	if (auto m = mesh.to_ref()) {
-		return isVisible() and m.get().isLoaded() and m.get().getVertexCount() > 2;
+		//evicted meshes are loaded back when drawn
+		return isVisible() and (m.get().isLoaded() or m.get().isEvicted()) and m.get().getVertexCount() > 2;
 	}
 	else {
 		return false;
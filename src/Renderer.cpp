@@ -1,6 +1,7 @@
 #include "Renderer.h"
 
 #include "Renderable.h"
+#include "GameState.h"
 #include "TextArea.h"
 #include "Platform.h"
 #include "Viewport.h"
@@ -10,6 +11,12 @@
 
 #include "Game.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include "AsyncReadback.h"
+#include "MeshArena.h"
+#include "ResidencyManager.h"
+#include "WorkerPool.h"
+#include "range.h"
 
 #include "glad/glad.h"
 
@@ -17,6 +24,8 @@ using namespace Dojo;
 
 GLuint gDefaultVAO = 0;
 
+const uint32_t Renderer::MIN_ELEMENTS_PER_CULL_JOB;
+
 
 const char* _errorToString(GLenum errorType) {
 	switch (errorType)
@@ -130,6 +139,10 @@ Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation
 
 	setInterfaceOrientation(Platform::singleton().getGame().getNativeOrientation());
 
+	mTextureStreamer = make_unique<TextureStreamer>();
+	mAsyncReadback = make_unique<AsyncReadback>();
+	mMeshArena = make_unique<MeshArena>();
+
 	//HACK GL core doesn't work without a VAO bound... but ain't nobody got time fo' dat
 	glGenVertexArrays(1, &gDefaultVAO);
 	glBindVertexArray(gDefaultVAO);
@@ -160,6 +173,10 @@ Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation
 Renderer::~Renderer() {
 	clearLayers();
 
+	mAsyncReadback = {};
+	mTextureStreamer = {};
+	mMeshArena = {};
+
 	if(gDefaultVAO) {
 		glDeleteVertexArrays(1, &gDefaultVAO);
 		gDefaultVAO = 0;
@@ -185,11 +202,26 @@ void Renderer::addRenderable(Renderable& s) {
 	//get the needed layer
 	RenderLayer& layer = getLayer(s.getLayerID());
 
-	DEBUG_ASSERT(layer.elements.contains(&s) == false, "This object is already registered!");
+	DEBUG_ASSERT(layer.elements.contains(s) == false, "This object is already registered!");
 
 	//append at the end
 	layer.elements.emplace(&s);
-	layer.elementsChangedThisFrame |= true;
+
+	//the Components are updated through the pool of their GameState, the others through their own list
+	auto& object = s.getObject();
+	if (not object.has<Renderable>() or &object.get<Renderable>() != &s) {
+		mLayerOnlyRenderables.emplace(&s);
+		return;
+	}
+
+	auto& pool = s.getGameState().getComponentPool(Renderable::ID);
+	for (auto&& entry : mRenderablePools) {
+		if (entry.pool == &pool) {
+			++entry.registeredCount;
+			return;
+		}
+	}
+	mRenderablePools.push_back({ &pool, 1 });
 }
 
 void Renderer::removeRenderable(Renderable& s) {
@@ -197,8 +229,10 @@ void Renderer::removeRenderable(Renderable& s) {
 
 	if (hasLayer(s.getLayerID())) {
 		auto& layer = getLayer(s.getLayerID());
-		layer.elements.erase(&s);
-		layer.elementsChangedThisFrame |= true;
+		if (layer.elements.contains(s)) {
+			layer.elements.remove(s);
+			_unregisterUpdate(s);
+		}
 	}
 
 	if(lastRenderState == s) {
@@ -206,11 +240,33 @@ void Renderer::removeRenderable(Renderable& s) {
 	}
 }
 
+void Renderer::_unregisterUpdate(Renderable& s) {
+	if (mLayerOnlyRenderables.contains(s)) {
+		mLayerOnlyRenderables.remove(s);
+		return;
+	}
+
+	auto& pool = s.getGameState().getComponentPool(Renderable::ID);
+	auto entry = std::find_if(mRenderablePools.begin(), mRenderablePools.end(), [&](const RenderablePool& e) {
+		return e.pool == &pool;
+	});
+	DEBUG_ASSERT(entry != mRenderablePools.end(), "The pool of this Renderable was never registered");
+
+	//a GameState without Renderables in the layers can be destroyed, forget its pool
+	if (--entry->registeredCount == 0) {
+		*entry = mRenderablePools.back();
+		mRenderablePools.pop_back();
+	}
+}
+
 void Renderer::removeAllRenderables() {
 	for (auto&& l : layers) {
 		l.elements.clear();
 	}
 
+	mLayerOnlyRenderables.clear();
+	mRenderablePools.clear();
+
 	lastRenderState = {};
 }
 
@@ -225,6 +281,7 @@ void Renderer::removeAllViewports() {
 }
 
 void Renderer::clearLayers() {
+	removeAllRenderables();
 	layers.clear();
 }
 
@@ -254,6 +311,24 @@ void Renderer::setInterfaceOrientation(Orientation o) {
 	mRenderRotation = glm::mat4_cast(Quaternion(Vector(0, 0, renderRotation)));
 }
 
+void Renderer::_makeResident(ResidencyManager& residency, const RenderState& renderState) {
+	bool reloaded = residency.touch(renderState.getMesh().unwrap());
+
+	for (auto i : range(DOJO_MAX_TEXTURES)) {
+		if (auto t = renderState.getTexture(i).to_ref()) {
+			//atlas tiles don't own any VRAM, their parent does
+			auto atlas = t.get().getParentAtlas().to_ref();
+			reloaded |= residency.touch(atlas ? atlas.get() : t.get());
+		}
+	}
+
+	//a reloaded resource has new GL handles, don't trust the cached bindings
+	if (reloaded) {
+		Texture::gTextureBindingsDirty = true;
+		Mesh::gBufferBindingsDirty = true;
+	}
+}
+
 void Dojo::Renderer::_renderElement(const RenderLayer& layer, const RenderState& renderState) {
 	auto& m = renderState.getMesh().unwrap();
 
@@ -288,10 +363,23 @@ void Dojo::Renderer::_renderElement(const RenderLayer& layer, const RenderState&
 	uint32_t mode = glModeMap[(uint8_t)m.getTriangleMode()];
 
 	if (m.isIndexed()) {
-		glDrawElements(mode, m.getIndexCount(), m.getIndexGLType(), nullptr);
+		auto& submeshes = m.getSubmeshes();
+		if (submeshes.empty()) {
+			glDrawElements(mode, m.getIndexCount(), m.getIndexGLType(), (void*)m.getIndexBufferOffset());
+		}
+		else {
+			//there is no base vertex draw on GLES3, move the attribute pointers instead
+			for (auto&& submesh : submeshes) {
+				m.bindVertexFormat(renderState.getShader().unwrap(), submesh.baseVertex);
+				glDrawElements(mode, submesh.indexCount, m.getIndexGLType(), (void*)(uintptr_t)(submesh.indexStart * sizeof(GLushort)));
+			}
+
+			//the next element can't reuse the offset pointers
+			Mesh::gBufferBindingsDirty = true;
+		}
 	}
 	else {
-		glDrawArrays(mode, 0, m.getVertexCount());
+		glDrawArrays(mode, m.getFirstVertex(), m.getVertexCount());
 	}
 
 	lastRenderState = renderState;
@@ -320,9 +408,31 @@ void Renderer::_renderLayer(Viewport& viewport, const RenderLayer& layer) {
 	//set projection state
 	globalUniforms.projection = mRenderRotation * (layer.orthographic ? viewport.getOrthoProjectionTransform() : viewport.getPerspectiveProjectionTransform());
 
-	for (auto&& r : layer.elements) {
-		if (r->canBeRendered() and _cull(layer, viewport, *r)) {
-			_renderElement(layer, *r);
+	auto count = (uint32_t)layer.elements.size();
+	mElementVisible.resize(count);
+
+	auto cull = [&](uint32_t begin, uint32_t end) {
+		for (auto i = begin; i < end; ++i) {
+			auto& r = *layer.elements[i];
+			mElementVisible[i] = r.canBeRendered() and _cull(layer, viewport, r);
+		}
+	};
+
+	//the tests only read the elements, the draws stay on this thread
+	if (count >= MIN_ELEMENTS_PER_CULL_JOB * 2) {
+		Platform::singleton().getBackgroundPool().parallelFor(count, MIN_ELEMENTS_PER_CULL_JOB, cull);
+	}
+	else {
+		cull(0, count);
+	}
+
+	auto& residency = Platform::singleton().getResidencyManager();
+
+	for (auto i : range(count)) {
+		if (mElementVisible[i]) {
+			auto& r = *layer.elements[i];
+			_makeResident(residency, r);
+			_renderElement(layer, r);
 		}
 	}
 }
@@ -388,21 +498,24 @@ void Renderer::_renderViewport(Viewport& viewport) {
 	}
 }
 
-void Dojo::Renderer::_updateRenderables(LayerList& layers, float dt) {
-	for (auto&& layer : layers) {
-		do {
-			//repeat the update on the whole layer if any element is added or removed
-			//TODO this isn't risky but very inefficient, find another way!
-			layer.elementsChangedThisFrame = false;
-			for (auto&& r : layer.elements) {
-				if ((r->getObject().isActive() and r->isVisible()) or r->getGraphicsAABB().isEmpty()) {
-					r->update(dt);
-					if (layer.elementsChangedThisFrame) {
-						break;
-					}
-				}
+void Dojo::Renderer::_updateRenderables(float dt) {
+	auto needsUpdate = [](Renderable& r) {
+		return (r.getObject().isActive() and r.isVisible()) or r.getGraphicsAABB().isEmpty();
+	};
+
+	//the Components first: a TextArea adds and removes its pages while updating, but never other Components
+	for (auto&& entry : mRenderablePools) {
+		entry.pool->forEach<Renderable>([&](Renderable& r) {
+			if (r._isInLayer() and needsUpdate(r)) {
+				r.update(dt);
 			}
-		} while (layer.elementsChangedThisFrame);
+		});
+	}
+
+	for (auto&& r : mLayerOnlyRenderables) {
+		if (needsUpdate(*r)) {
+			r->update(dt);
+		}
 	}
 }
 
@@ -412,14 +525,23 @@ void Renderer::renderFrame(float dt) {
 	frameVertexCount = frameTriCount = frameBatchCount = 0;
 	frameStarted = true;
 
+	//move the textures that finished decoding to VRAM
+	mTextureStreamer->update();
+
+	//hand the completed readbacks to their tasks
+	mAsyncReadback->update();
+
 	//update all the renderables
-	_updateRenderables(layers, dt);
+	_updateRenderables(dt);
 
 	//render all the viewports
 	for (auto&& viewport : viewportList) {
 		_renderViewport(*viewport);
 	}
 
+	//free some VRAM if the frame went over budget
+	Platform::singleton().getResidencyManager().endFrame();
+
 	frameStarted = false;
 }
 
@@ -0,0 +1,117 @@
+#include "ResidencyManager.h"
+
+#include "Resource.h"
+
+using namespace Dojo;
+
+ResidencyManager::ResidencyManager() {
+
+}
+
+ResidencyManager::~ResidencyManager() {
+	//resources that outlive the manager must not point back into it
+	for (auto&& entry : mEntries) {
+		entry.resource->mResidencyIndex = Resource::UNTRACKED;
+		entry.resource->mResidency = nullptr;
+	}
+}
+
+bool ResidencyManager::touch(Resource& r) {
+	r.mLastUsedFrame = mCurrentFrame;
+
+	if (r.mEvicted and not r.isLoaded()) {
+		r.onLoad();
+		++mCurrentFrameStats.reloads;
+		return true;
+	}
+	return false;
+}
+
+void ResidencyManager::_notifyLoaded(Resource& r) {
+	DEBUG_ASSERT(r.getByteSize() >= 0, "Invalid resource size");
+
+	auto bytes = (size_t)r.getByteSize();
+
+	if (r.mResidencyIndex == Resource::UNTRACKED) {
+		r.mResidencyIndex = mEntries.size();
+		r.mResidency = this;
+		mEntries.push_back({ &r, bytes });
+	}
+	else {
+		//the resource recreated its data with a different size
+		auto& entry = mEntries[r.mResidencyIndex];
+		mResidentBytes -= entry.bytes;
+		entry.bytes = bytes;
+	}
+
+	mResidentBytes += bytes;
+	r.mEvicted = false;
+	r.mLastUsedFrame = mCurrentFrame;
+}
+
+void ResidencyManager::_notifyUnloaded(Resource& r) {
+	if (r.mResidency) {
+		r.mResidency->_untrack(r);
+	}
+}
+
+void ResidencyManager::_untrack(Resource& r) {
+	auto idx = r.mResidencyIndex;
+	DEBUG_ASSERT(idx != Resource::UNTRACKED, "The resource isn't tracked");
+
+	DEBUG_ASSERT(mEntries[idx].resource == &r, "The residency index is corrupted");
+
+	mResidentBytes -= mEntries[idx].bytes;
+
+	//swap with the last and pop
+	mEntries[idx] = mEntries.back();
+	mEntries[idx].resource->mResidencyIndex = idx;
+	mEntries.pop_back();
+
+	r.mResidencyIndex = Resource::UNTRACKED;
+	r.mResidency = nullptr;
+}
+
+void ResidencyManager::_evict(size_t bytesToFree) {
+	//anything that can be loaded again and wasn't drawn in this frame is a candidate
+	std::vector<Entry> candidates;
+	for (auto&& entry : mEntries) {
+		if (entry.resource->mLastUsedFrame < mCurrentFrame and entry.resource->isReloadable()) {
+			candidates.push_back(entry);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Entry& a, const Entry& b) {
+		return a.resource->mLastUsedFrame < b.resource->mLastUsedFrame;
+	});
+
+	size_t freed = 0;
+	for (auto&& candidate : candidates) {
+		if (freed >= bytesToFree) {
+			break;
+		}
+
+		auto& r = *candidate.resource;
+		r.onUnload(true);
+
+		if (not r.isLoaded()) {
+			r.mEvicted = true;
+			freed += candidate.bytes;
+
+			++mCurrentFrameStats.evictions;
+			mCurrentFrameStats.evictedBytes += candidate.bytes;
+		}
+	}
+}
+
+void ResidencyManager::endFrame() {
+	if (mBudget > 0 and mResidentBytes > mBudget) {
+		_evict(mResidentBytes - mBudget);
+	}
+
+	mCurrentFrameStats.residentBytes = mResidentBytes;
+	mLastFrameStats = mCurrentFrameStats;
+	mCurrentFrameStats = {};
+
+	++mCurrentFrame;
+}
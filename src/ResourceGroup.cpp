@@ -11,6 +11,7 @@
 
 #include "Texture.h"
 #include "Path.h"
+#include "range.h"
 
 using namespace Dojo;
 
@@ -73,6 +74,30 @@ void ResourceGroup::addSets(utf::string_view subdirectory, int version) {
 	Platform::singleton().getFilePathsForType("png", subdirectory, paths);
 	Platform::singleton().getFilePathsForType("jpg", subdirectory, paths);
 
+	//compressed textures replace the image with the same name, which stays around as their fallback
+	std::vector<utf::string> compressedPaths;
+	Platform::singleton().getFilePathsForType("ktx", subdirectory, compressedPaths);
+	Platform::singleton().getFilePathsForType("ktx2", subdirectory, compressedPaths);
+
+	if (compressedPaths.size() > 0) {
+		auto removeExtension = [](utf::string_view path) {
+			return utf::string_view{ path.begin(), path.find_last_of('.') }.copy();
+		};
+
+		std::unordered_set<utf::string> compressedNames;
+		for (auto&& path : compressedPaths) {
+			compressedNames.emplace(removeExtension(path));
+		}
+
+		paths.erase(std::remove_if(paths.begin(), paths.end(), [&](const utf::string& path) {
+			return compressedNames.count(removeExtension(path)) > 0;
+		}), paths.end());
+
+		for (auto&& path : compressedPaths) {
+			paths.emplace_back(std::move(path));
+		}
+	}
+
 	for(auto&& path : paths) {
 		name = Path::getFileName(path);
 
@@ -468,6 +493,46 @@ void ResourceGroup::addFolder(utf::string_view folder, int version /*= 0*/) {
 	}
 }
 
+namespace {
+	//slightly larger than the unit cube to hide the seams
+	const float l = 0.501f;
+
+	struct PrefabFace {
+		Vector normal;
+		Vector corners[4];
+		glm::vec2 uvs[4];
+	};
+
+	///writes each face as a quad in a single block
+	Unique<Mesh> makeFaceMesh(ResourceGroup& group, std::initializer_list<PrefabFace> faces) {
+		auto m = make_unique<Mesh>(group);
+
+		m->setIndexByteSize(1); //uint8_t indices
+		m->setTriangleMode(PrimitiveMode::TriangleList);
+		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
+
+		auto faceCount = (Mesh::IndexType)faces.size();
+		m->begin(faceCount * 4, faceCount * 6);
+
+		auto block = m->append(faceCount * 4, faceCount * 6);
+
+		Mesh::IndexType first = 0;
+		for (auto&& face : faces) {
+			for (auto i : range(4)) {
+				block.position(first + i, face.corners[i]);
+				block.normal(first + i, face.normal);
+				block.uv(first + i, face.uvs[i].x, face.uvs[i].y);
+			}
+
+			block.quad(first / 4 * 6, first, first + 1, first + 2, first + 3);
+			first += 4;
+		}
+
+		m->end();
+		return m;
+	}
+}
+
 void ResourceGroup::addPrefabMeshes() {
 	//create an empty texturedQuad
 	{
@@ -477,25 +542,16 @@ void ResourceGroup::addPrefabMeshes() {
 
 		m->begin(4);
 
-		m->vertex({-0.5, -0.5});
-		m->uv(0, 1);
-		m->normal(Vector::UnitZ);
-		m->color(Color::White);
-
-		m->vertex({0.5, -0.5});
-		m->uv(1, 1);
-		m->normal(Vector::UnitZ);
-		m->color(Color::White);
-
-		m->vertex({-0.5, 0.5});
-		m->uv(0, 0);
-		m->normal(Vector::UnitZ);
-		m->color(Color::White);
+		const Vector corners[] = { { -0.5, -0.5 }, { 0.5, -0.5 }, { -0.5, 0.5 }, { 0.5, 0.5 } };
+		const glm::vec2 uvs[] = { { 0, 1 }, { 1, 1 }, { 0, 0 }, { 1, 0 } };
 
-		m->vertex({0.5, 0.5});
-		m->uv(1, 0);
-		m->normal(Vector::UnitZ);
-		m->color(Color::White);
+		auto block = m->append(4);
+		for (auto i : range(4)) {
+			block.position(i, corners[i]);
+			block.uv(i, uvs[i].x, uvs[i].y);
+			block.normal(i, Vector::UnitZ);
+			block.color(i, Color::White);
+		}
 
 		m->end();
 
@@ -510,17 +566,14 @@ void ResourceGroup::addPrefabMeshes() {
 
 		m->begin(4);
 
-		m->vertex({-0.5, 0, -0.5});
-		m->uv(0, 0);
-
-		m->vertex({-0.5, 0, 0.5});
-		m->uv(0, 1);
+		const Vector corners[] = { { -0.5, 0, -0.5 }, { -0.5, 0, 0.5 }, { 0.5, 0, -0.5 }, { 0.5, 0, 0.5 } };
+		const glm::vec2 uvs[] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
 
-		m->vertex({0.5, 0, -0.5});
-		m->uv(1, 0);
-
-		m->vertex({0.5, 0, 0.5});
-		m->uv(1, 1);
+		auto block = m->append(4);
+		for (auto i : range(4)) {
+			block.position(i, corners[i]);
+			block.uv(i, uvs[i].x, uvs[i].y);
+		}
 
 		m->end();
 
@@ -528,277 +581,43 @@ void ResourceGroup::addPrefabMeshes() {
 	}
 
 	//create a texturedCube
-#define l 0.501f
-	{
-		auto m = make_unique<Mesh>(self);
-
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(24);
-
-		m->vertex({l, l, l});
-		m->normal(Vector::UnitZ);
-		m->uv(1, 1);
-		m->vertex({l, -l, l});
-		m->normal(Vector::UnitZ);
-		m->uv(0, 1);
-		m->vertex({-l, l, l});
-		m->normal(Vector::UnitZ);
-		m->uv(1, 0);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::UnitZ);
-		m->uv(0, 0);
-
-		m->quad(0, 1, 2, 3);
-
-		m->vertex({l, l, -l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(1, 1);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(0, 1);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(1, 0);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(0, 0);
-
-		m->quad(4, 5, 6, 7);
-
-		m->vertex({l, l, l});
-		m->normal(Vector::UnitX);
-		m->uv(1, 1);
-		m->vertex({l, l, -l});
-		m->normal(Vector::UnitX);
-		m->uv(0, 1);
-		m->vertex({l, -l, l});
-		m->normal(Vector::UnitX);
-		m->uv(1, 0);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::UnitX);
-		m->uv(0, 0);
-
-		m->quad(8, 9, 10, 11);
-
-		m->vertex({-l, l, l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(1, 1);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(0, 1);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(1, 0);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(0, 0);
-
-		m->quad(12, 13, 14, 15);
-
-		m->vertex({l, l, l});
-		m->normal(Vector::UnitY);
-		m->uv(1, 1);
-		m->vertex({-l, l, l});
-		m->normal(Vector::UnitY);
-		m->uv(0, 1);
-		m->vertex({l, l, -l});
-		m->normal(Vector::UnitY);
-		m->uv(1, 0);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::UnitY);
-		m->uv(0, 0);
-
-		m->quad(16, 17, 18, 19);
-
-		m->vertex({l, -l, l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(1, 1);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(0, 1);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(1, 0);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(0, 0);
-
-		m->quad(20, 21, 22, 23);
-
-		m->end();
-
-		addMesh(std::move(m), "texturedCube");
-	}
-
-	//create a cube
-	{
-		auto m = make_unique<Mesh>(self);
-
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(4);
-		//-Z
-		m->vertex({l, l, -l});
-		m->normal(Vector::UnitZ);
-		m->uv(1, 0);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::UnitZ);
-		m->uv(1, 1);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::UnitZ);
-		m->uv(0, 0);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::UnitZ);
-		m->uv(0, 1);
-
-		m->quad(0, 1, 2, 3);
-
-		m->end();
-		addMesh(std::move(m), "prefabSkybox-Z");
-	}
-
-	{
-		auto m = make_unique<Mesh>(self);
-
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(4);
-		//+X
-		m->vertex({l, l, l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(1, 0);
-		m->vertex({l, -l, l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(1, 1);
-		m->vertex({l, l, -l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(0, 0);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::NegativeUnitX);
-		m->uv(0, 1);
-
-		m->quad(0, 1, 2, 3);
-
-		m->end();
-		addMesh(std::move(m), "prefabSkybox-X");
-	}
-
 	{
-		auto m = make_unique<Mesh>(self);
-
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(4);
-		//+Z
-		m->vertex({l, l, l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(0, 0);
-		m->vertex({-l, l, l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(1, 0);
-		m->vertex({l, -l, l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(0, 1);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::NegativeUnitZ);
-		m->uv(1, 1);
-
-		m->quad(0, 1, 2, 3);
-
-		m->end();
-		addMesh(std::move(m), "prefabSkybox+Z");
-	}
-	{
-		auto m = make_unique<Mesh>(self);
-
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(4);
-		//-X
-		m->vertex({-l, l, l});
-		m->normal(Vector::UnitX);
-		m->uv(0, 0);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::UnitX);
-		m->uv(1, 0);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::UnitX);
-		m->uv(0, 1);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::UnitX);
-		m->uv(1, 1);
-
-		m->quad(0, 1, 2, 3);
-
-		m->end();
-		addMesh(std::move(m), "prefabSkybox+X");
+		const glm::vec2 uvs[] = { { 1, 1 }, { 0, 1 }, { 1, 0 }, { 0, 0 } };
+
+		addMesh(makeFaceMesh(self, {
+			{ Vector::UnitZ, { { l, l, l }, { l, -l, l }, { -l, l, l }, { -l, -l, l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+			{ Vector::NegativeUnitZ, { { l, l, -l }, { -l, l, -l }, { l, -l, -l }, { -l, -l, -l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+			{ Vector::UnitX, { { l, l, l }, { l, l, -l }, { l, -l, l }, { l, -l, -l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+			{ Vector::NegativeUnitX, { { -l, l, l }, { -l, -l, l }, { -l, l, -l }, { -l, -l, -l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+			{ Vector::UnitY, { { l, l, l }, { -l, l, l }, { l, l, -l }, { -l, l, -l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+			{ Vector::NegativeUnitY, { { l, -l, l }, { l, -l, -l }, { -l, -l, l }, { -l, -l, -l } }, { uvs[0], uvs[1], uvs[2], uvs[3] } },
+		}), "texturedCube");
 	}
-	{
-		auto m = make_unique<Mesh>(self);
 
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
+	//the skybox faces point inwards
+	addMesh(makeFaceMesh(self, {
+		{ Vector::UnitZ, { { l, l, -l }, { l, -l, -l }, { -l, l, -l }, { -l, -l, -l } }, { { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 } } }
+	}), "prefabSkybox-Z");
 
-		m->begin(4);
+	addMesh(makeFaceMesh(self, {
+		{ Vector::NegativeUnitX, { { l, l, l }, { l, -l, l }, { l, l, -l }, { l, -l, -l } }, { { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 } } }
+	}), "prefabSkybox-X");
 
-		m->vertex({l, l, l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(1, 1);
-		m->vertex({l, l, -l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(0, 1);
-		m->vertex({-l, l, l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(1, 0);
-		m->vertex({-l, l, -l});
-		m->normal(Vector::NegativeUnitY);
-		m->uv(0, 0);
-
-		m->quad(0, 1, 2, 3);
+	addMesh(makeFaceMesh(self, {
+		{ Vector::NegativeUnitZ, { { l, l, l }, { -l, l, l }, { l, -l, l }, { -l, -l, l } }, { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } } }
+	}), "prefabSkybox+Z");
 
-		m->end();
-		addMesh(std::move(m), "prefabSkybox+Y");
-	}
-	{
-		auto m = make_unique<Mesh>(self);
+	addMesh(makeFaceMesh(self, {
+		{ Vector::UnitX, { { -l, l, l }, { -l, l, -l }, { -l, -l, l }, { -l, -l, -l } }, { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } } }
+	}), "prefabSkybox+X");
 
-		m->setIndexByteSize(1); //uint8_t indices
-		m->setTriangleMode(PrimitiveMode::TriangleList);
-		m->setVertexFields({ VertexField::Position3D, VertexField::Normal, VertexField::UV0 });
-
-		m->begin(4);
+	addMesh(makeFaceMesh(self, {
+		{ Vector::NegativeUnitY, { { l, l, l }, { l, l, -l }, { -l, l, l }, { -l, l, -l } }, { { 1, 1 }, { 0, 1 }, { 1, 0 }, { 0, 0 } } }
+	}), "prefabSkybox+Y");
 
-		m->vertex({l, -l, l});
-		m->normal(Vector::UnitY);
-		m->uv(1, 0);
-		m->vertex({-l, -l, l});
-		m->normal(Vector::UnitY);
-		m->uv(1, 1);
-		m->vertex({l, -l, -l});
-		m->normal(Vector::UnitY);
-		m->uv(0, 0);
-		m->vertex({-l, -l, -l});
-		m->normal(Vector::UnitY);
-		m->uv(0, 1);
-
-		m->quad(0, 1, 2, 3);
-
-		m->end();
-
-		addMesh(std::move(m), "prefabSkybox-Y");
-	}
+	addMesh(makeFaceMesh(self, {
+		{ Vector::UnitY, { { l, -l, l }, { -l, -l, l }, { l, -l, -l }, { -l, -l, -l } }, { { 1, 0 }, { 1, 1 }, { 0, 0 }, { 0, 1 } } }
+	}), "prefabSkybox-Y");
 
 	//add cube for wireframe use
 	{
@@ -806,19 +625,15 @@ void ResourceGroup::addPrefabMeshes() {
 		m->setTriangleMode(PrimitiveMode::LineStrip);
 		m->setVertexFieldEnabled(VertexField::Position2D);
 
-		m->begin(4);
+		m->begin(4, 6);
+
+		auto block = m->append(4, 6);
+		block.position(0, { 0.5, 0.5 });
+		block.position(1, { -0.5, 0.5 });
+		block.position(2, { 0.5, -0.5 });
+		block.position(3, { -0.5, -0.5 });
 
-		m->vertex({ 0.5, 0.5 });
-		m->vertex({ -0.5, 0.5 });
-		m->vertex({ 0.5, -0.5 });
-		m->vertex({ -0.5, -0.5 });
-
-		m->index(0);
-		m->index(1);
-		m->index(3);
-		m->index(2);
-		m->index(0);
-		m->index(3);
+		block.indices(0, { 0, 1, 3, 2, 0, 3 });
 
 		m->end();
 
@@ -0,0 +1,324 @@
+#include "SceneSnapshot.h"
+
+#include "Object.h"
+#include "GameState.h"
+#include "Renderable.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "MappedFile.h"
+#include "range.h"
+
+#include <typeinfo>
+
+using namespace Dojo;
+
+namespace {
+	const char MAGIC[4] = { 'D', 'S', 'C', 'N' };
+	const uint32_t NO_NAME = 0xffffffff;
+	const int32_t NO_PARENT = -1;
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t objectCount;
+		uint32_t renderableCount;
+		uint32_t nameCount;
+		uint32_t reserved[3];
+	};
+
+	///the Objects are stored parents first, so each parent comes before its children
+	struct ObjectRecord {
+		int32_t parent;
+		float position[3];
+		float rotation[4];
+		float size[3];
+		float speed[3];
+		uint8_t active;
+		uint8_t reserved[3];
+	};
+
+	struct RenderableRecord {
+		uint32_t object;
+		uint32_t mesh, shader;
+		float color[4];
+		float scale[3];
+		float uvOffset[3];
+		uint8_t layer;
+		uint8_t visible;
+		uint8_t reserved[2];
+	};
+
+	static_assert(sizeof(Header) == 32 and sizeof(ObjectRecord) == 60 and sizeof(RenderableRecord) == 56, "Unexpected padding in the snapshot structures");
+
+	template<typename T>
+	void write(std::vector<uint8_t>& out, const T& value) {
+		auto bytes = (const uint8_t*)&value;
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<typename T>
+	bool read(const uint8_t* data, size_t size, size_t& offset, T& out) {
+		if (offset > size or sizeof(T) > size - offset) {
+			return false;
+		}
+		memcpy(&out, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	///collects the names of the resources, each one once
+	class NameTable {
+	public:
+		uint32_t add(utf::string_view name) {
+			if (name.empty()) {
+				return NO_NAME;
+			}
+
+			auto inserted = mIndices.emplace(name.copy(), (uint32_t)mNames.size());
+			if (inserted.second) {
+				mNames.push_back(name.copy());
+			}
+			return inserted.first->second;
+		}
+
+		const std::vector<utf::string>& getNames() const {
+			return mNames;
+		}
+
+	private:
+		std::map<utf::string, uint32_t, utf::str_less> mIndices;
+		std::vector<utf::string> mNames;
+	};
+}
+
+const uint32_t SceneSnapshot::VERSION;
+
+std::vector<uint8_t> SceneSnapshot::save(const Object& root) {
+	std::vector<ObjectRecord> objects;
+	std::vector<RenderableRecord> renderables;
+	NameTable names;
+
+	auto& gameState = root.getGameState();
+
+	//depth first, so that the parents are always stored before their children
+	std::vector<std::pair<const Object*, int32_t>> stack = { { &root, NO_PARENT } };
+	while (stack.size() > 0) {
+		auto object = stack.back().first;
+		auto parent = stack.back().second;
+		stack.pop_back();
+
+		auto index = (uint32_t)objects.size();
+
+		ObjectRecord record = {};
+		auto& position = object->getPosition();
+		auto& rotation = object->getRotation();
+		record.parent = parent;
+		record.position[0] = position.x;
+		record.position[1] = position.y;
+		record.position[2] = position.z;
+		record.rotation[0] = rotation.x;
+		record.rotation[1] = rotation.y;
+		record.rotation[2] = rotation.z;
+		record.rotation[3] = rotation.w;
+		record.size[0] = object->size.x;
+		record.size[1] = object->size.y;
+		record.size[2] = object->size.z;
+		record.speed[0] = object->speed.x;
+		record.speed[1] = object->speed.y;
+		record.speed[2] = object->speed.z;
+		record.active = object->active;
+		objects.push_back(record);
+
+		if (object->has<Renderable>()) {
+			auto& r = object->get<Renderable>();
+			if (typeid(r) == typeid(Renderable)) {
+				RenderableRecord rr = {};
+				rr.object = index;
+				rr.mesh = NO_NAME;
+				rr.shader = NO_NAME;
+
+				if (auto mesh = r.getMesh().to_ref()) {
+					rr.mesh = names.add(gameState.findName<Mesh>(mesh.get(), ResourceGroup::ResourceType::Mesh));
+				}
+				if (auto shader = r.getShader().to_ref()) {
+					rr.shader = names.add(gameState.findName<Shader>(shader.get(), ResourceGroup::ResourceType::Material));
+				}
+
+				rr.color[0] = r.color.r;
+				rr.color[1] = r.color.g;
+				rr.color[2] = r.color.b;
+				rr.color[3] = r.color.a;
+				rr.scale[0] = r.scale.x;
+				rr.scale[1] = r.scale.y;
+				rr.scale[2] = r.scale.z;
+				rr.uvOffset[0] = r.uvOffset.x;
+				rr.uvOffset[1] = r.uvOffset.y;
+				rr.uvOffset[2] = r.uvOffset.z;
+				rr.layer = r.getLayerID();
+				rr.visible = r.isVisible();
+				renderables.push_back(rr);
+			}
+		}
+
+		//pushed in reverse to pop them in order
+		for (auto i = object->children.size(); i > 0; --i) {
+			auto& child = *object->children[i - 1];
+			if (not child.disposed) {
+				stack.emplace_back(&child, (int32_t)index);
+			}
+		}
+	}
+
+	Header header = {};
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.objectCount = (uint32_t)objects.size();
+	header.renderableCount = (uint32_t)renderables.size();
+	header.nameCount = (uint32_t)names.getNames().size();
+
+	std::vector<uint8_t> out;
+	write(out, header);
+	for (auto&& record : objects) {
+		write(out, record);
+	}
+	for (auto&& record : renderables) {
+		write(out, record);
+	}
+	for (auto&& name : names.getNames()) {
+		auto& bytes = name.bytes();
+		write(out, (uint32_t)bytes.size());
+		out.insert(out.end(), bytes.begin(), bytes.end());
+	}
+
+	return out;
+}
+
+optional_ref<Object> SceneSnapshot::load(Object& parent, const uint8_t* data, size_t size) {
+	size_t offset = 0;
+	Header header;
+	if (not read(data, size, offset, header) or memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 or header.version != VERSION or header.objectCount == 0) {
+		return{};
+	}
+
+	//check that everything fits before creating anything
+	auto recordsSize = (uint64_t)header.objectCount * sizeof(ObjectRecord) + (uint64_t)header.renderableCount * sizeof(RenderableRecord);
+	if (recordsSize > size - offset) {
+		return{};
+	}
+
+	std::vector<ObjectRecord> objectRecords(header.objectCount);
+	for (auto&& record : objectRecords) {
+		read(data, size, offset, record);
+	}
+
+	std::vector<RenderableRecord> renderableRecords(header.renderableCount);
+	for (auto&& record : renderableRecords) {
+		read(data, size, offset, record);
+	}
+
+	//each name takes at least its length, a bigger count can't be valid and must not be allocated
+	if (header.nameCount > (size - offset) / sizeof(uint32_t)) {
+		return{};
+	}
+
+	std::vector<utf::string_view> names(header.nameCount);
+	for (auto&& name : names) {
+		uint32_t length;
+		if (not read(data, size, offset, length) or length > size - offset) {
+			return{};
+		}
+		auto begin = (const char*)data + offset;
+		name = utf::string_view(utf::string::const_iterator(begin), utf::string::const_iterator(begin + length));
+		offset += length;
+	}
+
+	//only the root has no parent, and every other parent comes before its child
+	for (auto i : range(objectRecords.size())) {
+		auto& record = objectRecords[i];
+		auto p = record.parent;
+		if (i == 0 ? (p != NO_PARENT) : (p < 0 or p >= (int32_t)i)) {
+			return{};
+		}
+
+		//written the other way around, the comparisons reject NaN too
+		for (auto s : record.size) {
+			if (not (s >= 0)) {
+				return{};
+			}
+		}
+	}
+
+	for (auto&& record : renderableRecords) {
+		if (record.object >= header.objectCount or (record.mesh != NO_NAME and record.mesh >= header.nameCount) or (record.shader != NO_NAME and record.shader >= header.nameCount)) {
+			return{};
+		}
+	}
+
+	auto& gameState = parent.getGameState();
+	auto& arena = gameState.getObjectArena();
+	gameState.getTransformHierarchy().reserve(header.objectCount);
+
+	std::vector<Unique<Object>> objects(header.objectCount);
+	for (auto i : range(objectRecords.size())) {
+		auto& record = objectRecords[i];
+
+		auto object = Unique<Object>(new (arena) Object(
+			parent,
+			{ record.position[0], record.position[1], record.position[2] },
+			{ record.size[0], record.size[1], record.size[2] }));
+
+		object->setRotation(Quaternion(record.rotation[3], record.rotation[0], record.rotation[1], record.rotation[2]));
+		object->speed = { record.speed[0], record.speed[1], record.speed[2] };
+		object->active = record.active != 0;
+
+		objects[i] = std::move(object);
+	}
+
+	//the components are added before the Objects are linked, like addComponent requires
+	for (auto&& record : renderableRecords) {
+		auto& r = objects[record.object]->emplaceComponent<Renderable>(RenderLayer::ID(record.layer));
+
+		if (record.mesh != NO_NAME) {
+			if (auto mesh = gameState.getMesh(names[record.mesh]).to_ref()) {
+				r.setMesh(mesh.get());
+			}
+			else {
+				DEBUG_MESSAGE("SceneSnapshot: missing mesh " + names[record.mesh].copy());
+			}
+		}
+		if (record.shader != NO_NAME) {
+			if (auto shader = gameState.getShader(names[record.shader]).to_ref()) {
+				r.setShader(shader.get());
+			}
+			else {
+				DEBUG_MESSAGE("SceneSnapshot: missing shader " + names[record.shader].copy());
+			}
+		}
+
+		r.color = Color(record.color[0], record.color[1], record.color[2], record.color[3]);
+		r.scale = { record.scale[0], record.scale[1], record.scale[2] };
+		r.uvOffset = { record.uvOffset[0], record.uvOffset[1], record.uvOffset[2] };
+		r.setVisible(record.visible != 0);
+	}
+
+	//the parents come first, so each child is linked to a parent that isn't attached yet and no events fire
+	std::vector<Object*> links(objects.size());
+	for (auto i : range(objects.size())) {
+		links[i] = objects[i].get();
+		if (i > 0) {
+			links[objectRecords[i].parent]->_linkChild(std::move(objects[i]));
+		}
+	}
+
+	//a single attach walks the whole subtree once
+	return parent.addChild(std::move(objects[0]));
+}
+
+optional_ref<Object> SceneSnapshot::loadFile(Object& parent, utf::string_view path) {
+	MappedFile file(path);
+	if (not file.open()) {
+		return{};
+	}
+
+	return load(parent, file.data(), file.size());
+}
@@ -40,6 +40,8 @@ void Shader::_populateUniformNameMap() {
 	sBuiltiInUniformsNameMap["TIME"] = BU_TIME;
 	sBuiltiInUniformsNameMap["TARGET_DIMENSION"] = BU_TARGET_DIMENSION;
 	sBuiltiInUniformsNameMap["TARGET_DIMENSION_INV"] = BU_TARGET_DIMENSION_INV;
+	sBuiltiInUniformsNameMap["POSITION_DECODE_SCALE"] = BU_POSITION_DECODE_SCALE;
+	sBuiltiInUniformsNameMap["POSITION_DECODE_OFFSET"] = BU_POSITION_DECODE_OFFSET;
 }
 
 void Shader::_populateAttributeNameMap() {
@@ -56,6 +58,8 @@ void Shader::_populateAttributeNameMap() {
 	sBuiltInAttributeNameMap["POSITION_2D"] = VertexField::Position2D;
 	sBuiltInAttributeNameMap["NORMAL"] = VertexField::Normal;
 	sBuiltInAttributeNameMap["COLOR"] = VertexField::Color;
+	sBuiltInAttributeNameMap["POSITION_QUANTIZED"] = VertexField::PositionQuantized;
+	sBuiltInAttributeNameMap["NORMAL_OCTAHEDRAL"] = VertexField::NormalOctahedral;
 }
 
 Shader::BuiltInUniform Shader::_getUniformForName(const std::string& name) {
@@ -171,6 +175,14 @@ const void* Shader::_getUniformData(const GlobalUniformData& currentState, const
 			1.f / currentState.targetDimension.y
 		};
 		return &tmpVec;
+
+	case BU_POSITION_DECODE_SCALE:
+		tmpVec = user.getMesh().unwrap().getPositionDecodeScale();
+		return &tmpVec;
+
+	case BU_POSITION_DECODE_OFFSET:
+		return &user.getMesh().unwrap().getPositionDecodeOffset();
+
 	default: { //texture stuff
 		if (builtin >= BU_TEXTURE_0 and builtin <= BU_TEXTURE_N) {
 			tempInt[0] = builtin - BU_TEXTURE_0;
@@ -0,0 +1,117 @@
+#include "TaskGraph.h"
+
+#include "WorkerPool.h"
+#include "range.h"
+
+using namespace Dojo;
+
+TaskGraph::Node::Node(AsyncTask&& task, uint32_t dependencyCount) :
+	task(std::move(task)),
+	dependencyCount(dependencyCount) {
+
+}
+
+TaskGraph::TaskGraph(WorkerPool& pool) :
+	mPool(pool),
+	mRemaining(0),
+	mDone(false) {
+
+}
+
+TaskGraph::~TaskGraph() {
+	//the tasks refer to the graph
+	if (mStarted) {
+		wait();
+	}
+}
+
+TaskGraph::TaskID TaskGraph::add(AsyncTask task, std::initializer_list<TaskID> dependencies /* = */) {
+	DEBUG_ASSERT(not mStarted, "Tasks can't be added to a graph that already started");
+
+	auto id = (TaskID)mNodes.size();
+	mNodes.emplace_back(std::move(task), (uint32_t)dependencies.size());
+
+	for (auto&& dependency : dependencies) {
+		DEBUG_ASSERT(dependency < id, "A task can only depend on the tasks added before it");
+		mNodes[dependency].continuations.push_back(id);
+	}
+
+	return id;
+}
+
+TaskGraph::TaskID TaskGraph::addContinuation(AsyncTask task) {
+	DEBUG_ASSERT(not mStarted, "Tasks can't be added to a graph that already started");
+
+	auto id = (TaskID)mNodes.size();
+	mNodes.emplace_back(std::move(task), id);
+
+	for (auto i : range(id)) {
+		mNodes[i].continuations.push_back(id);
+	}
+
+	return id;
+}
+
+void TaskGraph::start(AsyncCallback onDone /* = */) {
+	DEBUG_ASSERT(not mStarted, "The graph already started");
+
+	mStarted = true;
+	mOnDone = std::move(onDone);
+	mRemaining = (uint32_t)mNodes.size();
+
+	if (mNodes.empty()) {
+		_finish();
+		return;
+	}
+
+	//find the roots before queueing any, the first tasks could already be releasing the others
+	std::vector<TaskID> roots;
+	for (auto i : range((TaskID)mNodes.size())) {
+		if (mNodes[i].dependencyCount == 0) {
+			roots.push_back(i);
+		}
+	}
+
+	for (auto&& id : roots) {
+		_queue(id);
+	}
+}
+
+void TaskGraph::wait() {
+	DEBUG_ASSERT(mStarted, "The graph didn't start");
+
+	mPool.waitUntil([this] {
+		return isDone();
+	});
+}
+
+void TaskGraph::_queue(TaskID id) {
+	mPool.queue([this, id] {
+		_run(id);
+	});
+}
+
+void TaskGraph::_run(TaskID id) {
+	auto& node = mNodes[id];
+	node.task();
+
+	for (auto&& continuation : node.continuations) {
+		if (--mNodes[continuation].dependencyCount == 0) {
+			_queue(continuation);
+		}
+	}
+
+	if (--mRemaining == 0) {
+		_finish();
+	}
+}
+
+void TaskGraph::_finish() {
+	//an empty task carries the callback to the thread that runs the callbacks of the pool
+	if (mOnDone) {
+		mPool.queue([] {}, std::move(mOnDone));
+	}
+
+	//the graph can be destroyed from here on, nothing else can touch it
+	mDone = true;
+}
@@ -1,25 +1,160 @@
+
 #include "TexFormatInfo.h"
+#include "range.h"
 
 #include "glad/glad.h"
 
+//the GLES 3 loader only knows about ETC2/EAC, define the desktop and ASTC formats here
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+	#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+	#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+	#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+	#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+	#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+	#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+	#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+	#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+	#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR 0x93D4
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR 0x93D7
+#endif
+
 namespace Dojo {
+	namespace {
+		struct CompressionSupport {
+			bool etc2 = false, s3tc = false, s3tcSRGB = false, rgtc = false, bptc = false, astc = false;
+
+			CompressionSupport() {
+				std::unordered_set<std::string> extensions;
+
+				GLint count = 0;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+				for (auto i : range(count)) {
+					if (auto name = (const char*)glGetStringi(GL_EXTENSIONS, i)) {
+						extensions.emplace(name);
+					}
+				}
+
+				auto has = [&](const char* name) {
+					return extensions.find(name) != extensions.end();
+				};
+
+				//ETC2 is core in ES 3, desktop GL has it through ES3 compatibility
+				auto version = (const char*)glGetString(GL_VERSION);
+				etc2 = (version and strstr(version, "OpenGL ES")) or has("GL_ARB_ES3_compatibility");
+				s3tc = has("GL_EXT_texture_compression_s3tc");
+				s3tcSRGB = s3tc and (has("GL_EXT_texture_sRGB") or has("GL_EXT_texture_compression_s3tc_srgb"));
+				rgtc = has("GL_ARB_texture_compression_rgtc") or has("GL_EXT_texture_compression_rgtc");
+				bptc = has("GL_ARB_texture_compression_bptc") or has("GL_EXT_texture_compression_bptc");
+				astc = has("GL_KHR_texture_compression_astc_ldr");
+			}
+		};
+	}
+
 	const Dojo::TexFormatInfo& TexFormatInfo::getFor(PixelFormat format) {
 		static const TexFormatInfo GLFormat[] = {
-			{ 4, GL_RGBA8, GL_UNSIGNED_BYTE,					4, GL_RGBA, GL_UNSIGNED_BYTE, true },
-			{ 3, GL_RGB8, GL_UNSIGNED_BYTE,					3, GL_RGB, GL_UNSIGNED_BYTE, false },
-			{ 2, GL_RGB8, GL_UNSIGNED_SHORT_5_6_5,		    3, GL_RGB, GL_UNSIGNED_BYTE, false },
-			{ 4, GL_RGBA8, GL_UNSIGNED_INT_2_10_10_10_REV,	4, GL_RGBA, GL_UNSIGNED_BYTE,  true },
-			{ 4, GL_SRGB8_ALPHA8, GL_UNSIGNED_BYTE,			4, GL_RGBA, GL_UNSIGNED_BYTE, true },
-			{ 3, GL_SRGB8, GL_UNSIGNED_BYTE,				3, GL_RGB, GL_UNSIGNED_BYTE, false },
-			{ 8, GL_RGBA16F, GL_HALF_FLOAT,					16, GL_RGBA, GL_FLOAT, false },
-			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_RED, GL_UNSIGNED_BYTE, false },
-			{ 2, GL_RG8, GL_UNSIGNED_BYTE,					2, GL_RG, GL_UNSIGNED_BYTE, false },
-			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_ALPHA, GL_UNSIGNED_BYTE, true },
+			{ 4, GL_RGBA8, GL_UNSIGNED_BYTE,					4, GL_RGBA, GL_UNSIGNED_BYTE, true, false,		0, 0, 0 },
+			{ 3, GL_RGB8, GL_UNSIGNED_BYTE,					3, GL_RGB, GL_UNSIGNED_BYTE, false, false,		0, 0, 0 },
+			{ 2, GL_RGB8, GL_UNSIGNED_SHORT_5_6_5,		    3, GL_RGB, GL_UNSIGNED_BYTE, false, false,		0, 0, 0 },
+			{ 4, GL_RGBA8, GL_UNSIGNED_INT_2_10_10_10_REV,	4, GL_RGBA, GL_UNSIGNED_BYTE,  true, false,		0, 0, 0 },
+			{ 4, GL_SRGB8_ALPHA8, GL_UNSIGNED_BYTE,			4, GL_RGBA, GL_UNSIGNED_BYTE, true, true,		0, 0, 0 },
+			{ 3, GL_SRGB8, GL_UNSIGNED_BYTE,				3, GL_RGB, GL_UNSIGNED_BYTE, false, true,		0, 0, 0 },
+			{ 8, GL_RGBA16F, GL_HALF_FLOAT,					16, GL_RGBA, GL_FLOAT, false, false,			0, 0, 0 },
+			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_RED, GL_UNSIGNED_BYTE, false, false,		0, 0, 0 },
+			{ 2, GL_RG8, GL_UNSIGNED_BYTE,					2, GL_RG, GL_UNSIGNED_BYTE, false, false,		0, 0, 0 },
+			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_ALPHA, GL_UNSIGNED_BYTE, true, false,		0, 0, 0 },
+
+			//compressed formats upload with their internal format as source format
+			{ 0, GL_COMPRESSED_RGB8_ETC2, 0,							0, GL_COMPRESSED_RGB8_ETC2, 0, false, false,						4, 4, 8 },
+			{ 0, GL_COMPRESSED_SRGB8_ETC2, 0,							0, GL_COMPRESSED_SRGB8_ETC2, 0, false, true,						4, 4, 8 },
+			{ 0, GL_COMPRESSED_RGBA8_ETC2_EAC, 0,						0, GL_COMPRESSED_RGBA8_ETC2_EAC, 0, true, false,					4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0,				0, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0, true, true,				4, 4, 16 },
+			{ 0, GL_COMPRESSED_R11_EAC, 0,								0, GL_COMPRESSED_R11_EAC, 0, false, false,							4, 4, 8 },
+			{ 0, GL_COMPRESSED_RG11_EAC, 0,								0, GL_COMPRESSED_RG11_EAC, 0, false, false,							4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0,					0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, false, false,				4, 4, 8 },
+			{ 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0,					0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, true, false,				4, 4, 8 },
+			{ 0, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0,					0, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0, true, false,				4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0,					0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, true, false,				4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0,				0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, true, true,			4, 4, 16 },
+			{ 0, GL_COMPRESSED_RED_RGTC1, 0,							0, GL_COMPRESSED_RED_RGTC1, 0, false, false,						4, 4, 8 },
+			{ 0, GL_COMPRESSED_RG_RGTC2, 0,								0, GL_COMPRESSED_RG_RGTC2, 0, false, false,							4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_BPTC_UNORM, 0,						0, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, true, false,					4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0,				0, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, true, true,				4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 0,					0, GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 0, true, false,					4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 0,			0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 0, true, true,			4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_ASTC_6x6_KHR, 0,					0, GL_COMPRESSED_RGBA_ASTC_6x6_KHR, 0, true, false,					6, 6, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR, 0,			0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR, 0, true, true,			6, 6, 16 },
+			{ 0, GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 0,					0, GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 0, true, false,					8, 8, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR, 0,			0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR, 0, true, true,			8, 8, 16 },
+
 			{ 0, 0, 0, 0, 0 },
 		};
 
+		static_assert(sizeof(GLFormat) / sizeof(GLFormat[0]) == enum_cast(PixelFormat::Unknown) + 1, "The format table is out of sync with PixelFormat");
+
 		return GLFormat[enum_cast(format)];
 	}
 
-}
+	PixelFormat TexFormatInfo::findCompressed(uint32_t glInternalFormat) {
+		for (auto i : range(enum_cast(PixelFormat::Unknown))) {
+			auto& info = getFor((PixelFormat)i);
+			if (info.isCompressed() and info.internalFormat == glInternalFormat) {
+				return (PixelFormat)i;
+			}
+		}
+		return PixelFormat::Unknown;
+	}
+
+	bool TexFormatInfo::isSupported(PixelFormat format) {
+		DEBUG_ASSERT_MAIN_THREAD;
 
+		static const CompressionSupport support;
+
+		switch (format) {
+		case PixelFormat::ETC2_RGB_8:
+		case PixelFormat::ETC2_RGB_8_SRGB:
+		case PixelFormat::ETC2_RGBA_8:
+		case PixelFormat::ETC2_RGBA_8_SRGB:
+		case PixelFormat::EAC_R_11:
+		case PixelFormat::EAC_RG_11:
+			return support.etc2;
+		case PixelFormat::BC1_RGB:
+		case PixelFormat::BC1_RGBA:
+		case PixelFormat::BC2_RGBA:
+		case PixelFormat::BC3_RGBA:
+			return support.s3tc;
+		case PixelFormat::BC3_RGBA_SRGB:
+			return support.s3tcSRGB;
+		case PixelFormat::BC4_R:
+		case PixelFormat::BC5_RG:
+			return support.rgtc;
+		case PixelFormat::BC7_RGBA:
+		case PixelFormat::BC7_RGBA_SRGB:
+			return support.bptc;
+		case PixelFormat::ASTC_4x4_RGBA:
+		case PixelFormat::ASTC_4x4_RGBA_SRGB:
+		case PixelFormat::ASTC_6x6_RGBA:
+		case PixelFormat::ASTC_6x6_RGBA_SRGB:
+		case PixelFormat::ASTC_8x8_RGBA:
+		case PixelFormat::ASTC_8x8_RGBA_SRGB:
+			return support.astc;
+		case PixelFormat::Unknown:
+			return false;
+		default:
+			return getFor(format).isGPUFormat();
+		}
+	}
+
+}
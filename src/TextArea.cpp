@@ -141,7 +141,8 @@ Renderable& TextArea::_enableLayer(Texture& tex) {
 	layer.setVisible(true);
 	layer.setTexture(tex);
 
-	layer.getMesh().unwrap().begin(getLength() * 2);
+	//each character is a quad
+	layer.getMesh().unwrap().begin(getLength() * 4, getLength() * 6);
 
 	//move it to the busy layer
 	busyLayers.emplace(std::move(*freeLayers.begin()));
@@ -210,7 +211,6 @@ void TextArea::_prepare() {
 	Vector newSize(0, 0);
 	bool doKerning = font.isKerningEnabled();
 	int lastLineVertexID = 0;
-	int idx = 0;
 
 	cursorPosition.x = 0;
 	cursorPosition.y = 0;
@@ -255,23 +255,22 @@ void TextArea::_prepare() {
 				x += font.getKerning(rep, lastRep.unwrap());
 			}
 
-			idx = layer.getVertexCount();
+			auto quad = layer.append(4, 6);
 
 			//assign vertex positions and uv coordinates
-			layer.vertex({x, y});
-			layer.uv(rep.uvPos.x, rep.uvPos.y + rep.uvHeight);
+			quad.position(0, { x, y });
+			quad.uv(0, rep.uvPos.x, rep.uvPos.y + rep.uvHeight);
 
-			layer.vertex({x + rep.widthRatio, y});
-			layer.uv(rep.uvPos.x + rep.uvWidth, rep.uvPos.y + rep.uvHeight);
+			quad.position(1, { x + rep.widthRatio, y });
+			quad.uv(1, rep.uvPos.x + rep.uvWidth, rep.uvPos.y + rep.uvHeight);
 
-			layer.vertex({x, y + rep.heightRatio});
-			layer.uv(rep.uvPos.x, rep.uvPos.y);
+			quad.position(2, { x, y + rep.heightRatio });
+			quad.uv(2, rep.uvPos.x, rep.uvPos.y);
 
-			layer.vertex({x + rep.widthRatio, y + rep.heightRatio});
-			layer.uv(rep.uvPos.x + rep.uvWidth, rep.uvPos.y);
+			quad.position(3, { x + rep.widthRatio, y + rep.heightRatio });
+			quad.uv(3, rep.uvPos.x + rep.uvWidth, rep.uvPos.y);
 
-			layer.triangle(idx, idx + 1, idx + 2);
-			layer.triangle(idx + 1, idx + 3, idx + 2);
+			quad.indices(0, { 0, 1, 2, 1, 3, 2 });
 
 			//now move to the next character
 			cursorPosition.x += rep.advance + charSpacing;
@@ -334,6 +333,7 @@ void TextArea::_centerLastLine(int startingAt, float size) {
 Unique<Mesh> TextArea::_createMesh() {
 	auto mesh = make_unique<Mesh>();
 	mesh->setDynamic(true);
+	mesh->setAutoIndexSize(true);
 	mesh->setVertexFields({VertexField::Position2D, VertexField::UV0});
 	mesh->setTriangleMode(PrimitiveMode::TriangleList);
 
@@ -1,19 +1,33 @@
 #include "Texture.h"
 #include "dojomath.h"
 #include "Platform.h"
+#include "Renderer.h"
 #include "ResourceGroup.h"
 #include "Mesh.h"
 #include "TexFormatInfo.h"
+#include "WorkerPool.h"
+#include "TaskGraph.h"
+#include "KTXFile.h"
+#include "Path.h"
+#include "range.h"
+#include "ResidencyManager.h"
 
 #include "glad/glad.h"
 
 using namespace Dojo;
 
+bool Texture::gTextureBindingsDirty = true;
+
+//the GL default, that the uploads that don't set their own alignment expect
+const GLint DEFAULT_UNPACK_ALIGNMENT = 4;
+
 Texture::Texture(optional_ref<ResourceGroup> creator) :
 	Resource(creator),
 	internalWidth(0),
 	internalHeight(0),
 	glhandle(0) {
+	mMipmapsEnabled = creator.is_none() or not creator.unwrap().disableMipmaps;
+	mStreamingEnabled = creator.is_some() and creator.unwrap().streamTextures;
 }
 
 Texture::Texture(optional_ref<ResourceGroup> creator, utf::string_view path) :
@@ -21,6 +35,8 @@ Texture::Texture(optional_ref<ResourceGroup> creator, utf::string_view path) :
 	internalWidth(0),
 	internalHeight(0),
 	glhandle(0) {
+	mMipmapsEnabled = creator.is_none() or not creator.unwrap().disableMipmaps;
+	mStreamingEnabled = creator.is_some() and creator.unwrap().streamTextures;
 }
 
 Texture::~Texture() {
@@ -32,6 +48,17 @@ Texture::~Texture() {
 }
 
 void Texture::bind(uint32_t index) {
+	//the parent could have been evicted and reloaded with a new handle
+	if (auto atlas = parentAtlas.to_ref()) {
+		atlas.get().bind(index);
+		return;
+	}
+
+	if (mStreamPending) {
+		Platform::singleton().getRenderer().getTextureStreamer().getPlaceholder().bind(index);
+		return;
+	}
+
 	//create the gl texture if still not created!
 	DEBUG_ASSERT(glhandle, "This texture wasn't created yet");
 
@@ -39,48 +66,68 @@ void Texture::bind(uint32_t index) {
 	glBindTexture(GL_TEXTURE_2D, glhandle);
 }
 
+void Texture::_bindOwnHandle() {
+	DEBUG_ASSERT(glhandle, "This texture wasn't created yet");
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, glhandle);
+}
+
 void Texture::enableAnisotropicFiltering(float level) {
-	bind(0);
+	mAnisotropy = level;
+
+	_bindOwnHandle();
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, level);
 }
 
 void Texture::disableAnisotropicFiltering() {
-	bind(0);
+	mAnisotropy = 0;
+
+	_bindOwnHandle();
 	glTexParameterf(GL_TEXTURE_2D, GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, 0);
 }
 
 void Texture::enableBilinearFiltering() {
-	bind(0);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	mBilinearFiltering = true;
 
+	_bindOwnHandle();
+	_applySamplerState();
 }
 
 void Texture::disableBilinearFiltering() {
-	bind(0);
+	mBilinearFiltering = false;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	_bindOwnHandle();
+	_applySamplerState();
 }
 
 void Texture::enableTiling() {
-	bind(0);
+	mTiling = true;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	_bindOwnHandle();
+	_applySamplerState();
 }
 
 void Texture::disableTiling() {
-	bind(0);
+	mTiling = false;
+
+	_bindOwnHandle();
+	_applySamplerState();
+}
+
+void Texture::_applySamplerState() {
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mBilinearFiltering ? GL_LINEAR : GL_NEAREST);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	auto wrap = mTiling ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 }
 
 void Dojo::Texture::_addAsAttachment(uint32_t index, uint32_t width, uint32_t height, uint8_t miplevel) {
 	DEBUG_ASSERT(width == getWidth() and height == getHeight(), "Cannot add texture as attachment");
-	DEBUG_ASSERT(miplevel == 0, "Mipmaps aren't supported anymore :(");
+	DEBUG_ASSERT(miplevel < mStorageLevels, "This mip level doesn't exist in the texture storage");
 
-	bind(0);
+	_bindOwnHandle();
 
 	//TODO use the proper types
 	glFramebufferTexture2D(
@@ -93,7 +140,7 @@ void Dojo::Texture::_addAsAttachment(uint32_t index, uint32_t width, uint32_t he
 
 }
 
-bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID) {
+bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID, uint32_t levels) {
 	width = w;
 	height = h;
 
@@ -105,15 +152,6 @@ bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID)
 
 	DEBUG_ASSERT(formatInfo.isGPUFormat(), "This format can't be loaded on the GPU!");
 
-	if (not glhandle) {
-		glGenTextures(1, &glhandle);
-	}
-	glBindTexture(GL_TEXTURE_2D, glhandle);
-
-	//TODO add back manually generated mipmaps
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-
 	uint32_t destWidth, destHeight;
 
 	//if the platforms supports NPOT, or the dimensions are already POT, direct copy
@@ -126,26 +164,67 @@ bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID)
 		destHeight = glm::ceilPowerOfTwo(height);
 	}
 
+	levels = std::min(levels, MipChain::getLevelCountFor(destWidth, destHeight));
+
 	//check if the texture has to be recreated (changed dimensions)
-	if (destWidth != internalWidth or destHeight != internalHeight or oldFormat.internalFormat != formatInfo.internalFormat) {
+	bool recreate = destWidth != internalWidth or destHeight != internalHeight or oldFormat.internalFormat != formatInfo.internalFormat or levels != mStorageLevels;
+
+	//immutable storage can't be respecified, get a new handle
+	if (recreate and glhandle and internalWidth > 0) {
+		glDeleteTextures(1, &glhandle);
+		glhandle = 0;
+		gTextureBindingsDirty = true;
+
+		//the Framebuffers that attached the old handle attach the new one when they are bound next
+		++mHandleGeneration;
+	}
+
+	bool newHandle = not glhandle;
+	if (newHandle) {
+		glGenTextures(1, &glhandle);
+	}
+	glBindTexture(GL_TEXTURE_2D, glhandle);
+
+	//the sampler settings were made on the old handle
+	if (newHandle) {
+		_applySamplerState();
+
+		if (mAnisotropy > 0) {
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, mAnisotropy);
+		}
+	}
+
+	if (recreate) {
 		internalWidth = destWidth;
 		internalHeight = destHeight;
 		internalFormat = formatID;
+		mStorageLevels = levels;
 
 		auto internalSize = internalWidth * internalHeight * formatInfo.sourcePixelSize;
 		DEBUG_ASSERT(internalSize % 4 == 0, "OpenGL implementations choke on non-4-aligned buffers");
 
 		glTexStorage2D(
 			GL_TEXTURE_2D,
-			1, //TODO multiple levels?
+			mStorageLevels,
 			formatInfo.internalFormat,
 			internalWidth,
 			internalHeight
 		);
 
+		size_t bytes = 0;
+		for (auto level : range(mStorageLevels)) {
+			bytes += formatInfo.getLevelByteSize(std::max(internalWidth >> level, 1u), std::max(internalHeight >> level, 1u));
+		}
+		size = (int)bytes;
 
+		Platform::singleton().getResidencyManager()._notifyLoaded(*this);
 	}
 
+	//only sample the base level until the rest of the chain is uploaded
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	mResidentLevels = 1;
+
 	UVSize.x = (float)width / (float)internalWidth;
 	UVSize.y = (float)height / (float)internalHeight;
 
@@ -182,11 +261,77 @@ const uint8_t* convertToGPUFormat(const uint8_t* imageData, uint32_t width, uint
 		}
 		return backingBuffer.data();
 	}
+	else if (TexFormatInfo::getFor(inoutFormat).isGPUFormat()) {
+		return imageData;
+	}
 	else {
 		FAIL("Format not supported for now...");
 	}
 }
 
+bool Texture::_uploadBaseLevel(const uint8_t* imageData, PixelFormat format) {
+	auto& formatDesc = TexFormatInfo::getFor(format);
+
+	mTransparency = false;
+	if (formatDesc.isCompressed()) {
+		//can't look into the blocks, trust the format
+		mTransparency = formatDesc.hasAlpha;
+	}
+	else if (formatDesc.hasAlpha) {
+		auto pixelSize = formatDesc.sourcePixelSize;
+		auto end = imageData + (width * height * pixelSize);
+		for (auto alpha = imageData + pixelSize - 1; alpha < end; alpha += pixelSize) {
+			if (*alpha < 250) {
+				mTransparency = true;
+				break;
+			}
+		}
+	}
+
+	_uploadLevel(0, width, height, imageData, formatDesc.getLevelByteSize(width, height), formatDesc);
+
+	return loaded = true;
+}
+
+void Texture::_uploadLevel(uint32_t level, uint32_t w, uint32_t h, const uint8_t* data, size_t byteSize, const TexFormatInfo& formatDesc) {
+	if (formatDesc.isCompressed()) {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, formatDesc.internalFormat, (GLsizei)byteSize, data);
+	}
+	else {
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, formatDesc.sourceFormat, formatDesc.sourceElementType, data);
+	}
+}
+
+void Texture::_setResidentLevels(uint32_t count) {
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+	mResidentLevels = count;
+}
+
+void Texture::_uploadMipChain(const MipChain& chain) {
+	DEBUG_ASSERT(glhandle, "This texture wasn't created yet");
+	DEBUG_ASSERT(chain.firstLevel <= mResidentLevels, "The chain would leave a hole in the resident levels");
+
+	auto& formatDesc = TexFormatInfo::getFor(chain.format);
+	auto count = std::min(chain.getTotalLevelCount(), mStorageLevels);
+
+	//use a unit that the RenderState never touches, so that its cached bindings stay valid
+	glActiveTexture(GL_TEXTURE0 + DOJO_MAX_TEXTURES);
+	glBindTexture(GL_TEXTURE_2D, glhandle);
+
+	//small levels are not 4-aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (auto i : range(chain.firstLevel, count)) {
+		auto& level = chain.levels[i - chain.firstLevel];
+		_uploadLevel(i, level.width, level.height, level.data.data(), level.data.size(), formatDesc);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, DEFAULT_UNPACK_ALIGNMENT);
+
+	_setResidentLevels(count);
+}
+
 bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat format) {
 	DEBUG_ASSERT(imageData, "null image data");
 	DEBUG_ASSERT(width > 0 and height > 0, "Invalid dimensions");
@@ -195,53 +340,249 @@ bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t
 	std::vector<uint8_t> conversionBuffer;
 	imageData = convertToGPUFormat(imageData, width, height, format, conversionBuffer);
 
-	_createStorage(width, height, format);
+	//the mip chain of a previous load must not land on top of this one
+	mLoadToken = make_shared<bool>(true);
 
-	auto& formatDesc = TexFormatInfo::getFor(format);
+	bool mipmapped = mMipmapsEnabled and MipChain::canGenerate(format);
+	_createStorage(width, height, format, mipmapped ? MipChain::getLevelCountFor(width, height) : 1);
+	_uploadBaseLevel(imageData, format);
 
-	mTransparency = false;
-	if (formatDesc.hasAlpha) {
-		auto end = imageData + (width * height * 4);
-		for (auto alpha = imageData + 3; alpha < end; alpha += 4) {
-			if (*alpha < 250) {
-				mTransparency = true;
-				break;
-			}
+	if (mStorageLevels > 1) {
+		//the background job needs its own copy of the base level
+		Shared<std::vector<uint8_t>> base;
+		if (imageData == conversionBuffer.data()) {
+			base = make_shared<std::vector<uint8_t>>(std::move(conversionBuffer));
+		}
+		else {
+			auto size = width * height * TexFormatInfo::getFor(format).sourcePixelSize;
+			base = make_shared<std::vector<uint8_t>>(imageData, imageData + size);
 		}
+
+		std::weak_ptr<bool> token = mLoadToken;
+		auto chain = make_shared<MipChain>();
+
+		//the levels are generated on the pool, the continuation uploads them on the main thread and lets the graph go
+		auto graph = make_shared<TaskGraph>(Platform::singleton().getBackgroundPool());
+		graph->add([base, chain, width, height, format] {
+			*chain = MipChain::generate(base->data(), width, height, format);
+		});
+
+		graph->start([this, chain, token, graph] {
+			if (token.lock()) {
+				_uploadMipChain(*chain);
+			}
+		});
 	}
 
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, formatDesc.sourceFormat, formatDesc.sourceElementType, imageData);
+	return loaded;
+}
+
+bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat format, const MipChain& mips) {
+	DEBUG_ASSERT(imageData, "null image data");
+	DEBUG_ASSERT(width > 0 and height > 0, "Invalid dimensions");
+	DEBUG_ASSERT(mips.format == format, "The MipChain has a different format than the base level");
+	DEBUG_ASSERT(mips.firstLevel == 1, "The MipChain must start right below the base level");
+
+	mLoadToken = make_shared<bool>(true);
 
-	return loaded = true;
+	_createStorage(width, height, format, mMipmapsEnabled ? mips.getTotalLevelCount() : 1);
+	_uploadBaseLevel(imageData, format);
+
+	if (mStorageLevels > 1) {
+		_uploadMipChain(mips);
+	}
+
+	return loaded;
+}
+
+void Texture::_setupSamplerFromCreator() {
+	if (not glhandle) {
+		glGenTextures(1, &glhandle);
+	}
+
+	if (creator.is_some() and creator.unwrap().disableBilinear) {
+		disableBilinearFiltering();
+	}
+	else {
+		enableBilinearFiltering();
+	}
+
+	enableTiling();
 }
 
 bool Texture::loadFromFile(utf::string_view path) {
 	DEBUG_ASSERT(not isLoaded(), "The Texture is already loaded");
 
-	if (not glhandle) {
-		glGenTextures(1, &glhandle);
+	_setupSamplerFromCreator();
+
+	if (KTXFile::isKTXPath(path)) {
+		return _loadFromKTX(path);
 	}
 
+	return _loadFromImage(path);
+}
+
+bool Texture::_loadFromImage(utf::string_view path) {
 	int pixelSize;
 	std::vector<uint8_t> imageData;
 	auto format = Platform::singleton().loadImageFile(imageData, path, width, height, pixelSize);
 
 	DEBUG_ASSERT_INFO(format != PixelFormat::Unknown, "Cannot load an image file", "path = " + path);
 
-	if (creator.is_some() and creator.unwrap().disableBilinear) {
-		disableBilinearFiltering();
+	loadFromMemory(imageData.data(), width, height, format);
+
+	return loaded;
+}
+
+bool Texture::_loadStreamed(utf::string_view path) {
+	DEBUG_ASSERT(not isLoaded(), "The Texture is already loaded");
+
+	//the handle exists from the start, so that sampler settings can be changed while streaming
+	_setupSamplerFromCreator();
+
+	mStreamPending = true;
+	mLoadToken = make_shared<bool>(true);
+
+	Platform::singleton().getRenderer().getTextureStreamer().stream(self, path, mLoadToken, mMipmapsEnabled);
+
+	return loaded = true;
+}
+
+void Texture::_decodeForStreaming(utf::string_view path, bool mipmaps, TextureStreamer::Image& out) {
+	int pixelSize;
+	std::vector<uint8_t> imageData;
+	auto format = Platform::singleton().loadImageFile(imageData, path, out.width, out.height, pixelSize);
+
+	if (format == PixelFormat::Unknown) {
+		return;
 	}
-	else {
-		enableBilinearFiltering();
+
+	std::vector<uint8_t> conversionBuffer;
+	auto pixels = convertToGPUFormat(imageData.data(), out.width, out.height, format, conversionBuffer);
+
+	auto& formatDesc = TexFormatInfo::getFor(format);
+	auto baseSize = formatDesc.getLevelByteSize(out.width, out.height);
+
+	out.transparency = false;
+	if (formatDesc.hasAlpha) {
+		auto pixelSize = formatDesc.sourcePixelSize;
+		for (auto alpha = pixels + pixelSize - 1; alpha < pixels + baseSize; alpha += pixelSize) {
+			if (*alpha < 250) {
+				out.transparency = true;
+				break;
+			}
+		}
 	}
 
-	enableTiling();
+	//pack all the levels together so that they can be copied in one unpack buffer
+	out.data.assign(pixels, pixels + baseSize);
 
-	loadFromMemory(imageData.data(), width, height, format);
+	if (mipmaps and MipChain::canGenerate(format)) {
+		auto chain = MipChain::generate(pixels, out.width, out.height, format);
+		for (auto&& level : chain.levels) {
+			out.data.insert(out.data.end(), level.data.begin(), level.data.end());
+		}
+		out.levelCount = chain.getTotalLevelCount();
+	}
+
+	out.format = format;
+}
+
+void Texture::_uploadStreamed(const TextureStreamer::Image& image, const uint8_t* data) {
+	DEBUG_ASSERT(mStreamPending, "This texture isn't waiting for a streamed image");
+
+	//use a unit that the RenderState never touches, so that its cached bindings stay valid
+	glActiveTexture(GL_TEXTURE0 + DOJO_MAX_TEXTURES);
+
+	_createStorage(image.width, image.height, image.format, image.levelCount);
+
+	auto& formatDesc = TexFormatInfo::getFor(image.format);
+	auto count = std::min(image.levelCount, mStorageLevels);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (auto i : range(count)) {
+		auto w = std::max(image.width >> i, 1u);
+		auto h = std::max(image.height >> i, 1u);
+		auto levelSize = formatDesc.getLevelByteSize(w, h);
+
+		_uploadLevel(i, w, h, data, levelSize, formatDesc);
+		data += levelSize;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, DEFAULT_UNPACK_ALIGNMENT);
+
+	_setResidentLevels(count);
+
+	mTransparency = image.transparency;
+	mStreamPending = false;
+
+	//RenderStates might have the placeholder bound in place of this
+	gTextureBindingsDirty = true;
+
+	//the UVs are known only now
+	if (OBB) {
+		_rebuildOptimalBillboard();
+	}
+}
+
+bool Texture::_loadFromKTX(utf::string_view path) {
+	KTXFile ktx(path);
+	if (not ktx.open()) {
+		return _loadFallbackImage(path);
+	}
+
+	auto format = ktx.getFormat();
+	auto& formatDesc = TexFormatInfo::getFor(format);
+	auto& levels = ktx.getLevels();
+	auto w = ktx.getWidth();
+	auto h = ktx.getHeight();
+
+	//compressed data can't be padded to a power of two
+	bool sizeSupported = Platform::singleton().isNPOTEnabled() or (glm::isPowerOfTwo(w) and glm::isPowerOfTwo(h));
+
+	if (not TexFormatInfo::isSupported(format) or (formatDesc.isCompressed() and not sizeSupported)) {
+		return _loadFallbackImage(path);
+	}
+
+	//single uncompressed levels go through the usual path to get their chain generated, it wants packed rows
+	if (not formatDesc.isCompressed() and (levels.size() == 1 or not formatDesc.isGPUFormat())) {
+		std::vector<uint8_t> packed;
+		return loadFromMemory(ktx.getPackedData(levels[0], packed), w, h, format);
+	}
+
+	mLoadToken = make_shared<bool>(true);
+
+	//the levels point into the mapped file, so they are handed to GL without copies, with the rows as the file has them
+	glPixelStorei(GL_UNPACK_ALIGNMENT, ktx.getRowAlignment());
+
+	_createStorage(w, h, format, mMipmapsEnabled ? (uint32_t)levels.size() : 1);
+	_uploadBaseLevel(levels[0].data, format);
+
+	for (auto i : range(1u, mStorageLevels)) {
+		auto& level = levels[i];
+		_uploadLevel(i, level.width, level.height, level.data, level.byteSize, formatDesc);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, DEFAULT_UNPACK_ALIGNMENT);
+
+	_setResidentLevels(mStorageLevels);
 
 	return loaded;
 }
 
+bool Texture::_loadFallbackImage(utf::string_view ktxPath) {
+	utf::string_view stem = { ktxPath.begin(), ktxPath.find_last_of('.') };
+
+	for (auto ext : { ".png", ".jpg" }) {
+		auto imagePath = stem + ext;
+		if (Path::isFile(imagePath)) {
+			DEBUG_MESSAGE("KTX format not supported, falling back to " + imagePath);
+			return _loadFromImage(imagePath);
+		}
+	}
+
+	DEBUG_MESSAGE("Cannot load " + ktxPath + " and there is no uncompressed image to fall back to");
+	return loaded = false;
+}
+
 bool Texture::_setupAtlas() {
 	auto& atlas = parentAtlas.unwrap();
 
@@ -292,6 +633,9 @@ bool Texture::onLoad() {
 	OBB.reset();
 
 	if (isReloadable()) {
+		if (mStreamingEnabled and not KTXFile::isKTXPath(filePath)) {
+			return _loadStreamed(filePath);
+		}
 		return loadFromFile(filePath);
 	}
 	else if (parentAtlas.is_some()) {
@@ -310,15 +654,23 @@ void Texture::onUnload(bool soft) {
 			OBB->onUnload();
 		}
 
+		//discard any mip chain or streamed image still being generated
+		mLoadToken.reset();
+		mStreamPending = false;
+
 		if (parentAtlas.is_none()) { //don't unload parent texture!
 			DEBUG_ASSERT(glhandle, "Tried to unload a texture but the texture handle was invalid");
 			glDeleteTextures(1, &glhandle);
 
 			internalWidth = internalHeight = 0;
+			mStorageLevels = mResidentLevels = 1;
 			internalFormat = PixelFormat::Unknown;
 			glhandle = 0;
 			parentAtlas = {};
 			mTransparency = false;
+
+			ResidencyManager::_notifyUnloaded(*this);
+			size = 0;
 		}
 
 		loaded = false;
@@ -0,0 +1,159 @@
+#include "TextureStreamer.h"
+
+#include "Texture.h"
+#include "Platform.h"
+#include "WorkerPool.h"
+
+#include "glad/glad.h"
+
+using namespace Dojo;
+
+TextureStreamer::TextureStreamer() {
+	_createPlaceholder();
+}
+
+TextureStreamer::~TextureStreamer() {
+	_releaseUnpackBuffers();
+
+	if (mPlaceholder and mPlaceholder->isLoaded()) {
+		mPlaceholder->onUnload();
+	}
+}
+
+void TextureStreamer::stream(Texture& texture, utf::string_view path, std::weak_ptr<bool> token, bool mipmaps) {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	auto image = make_shared<Image>();
+	auto pathCopy = path.copy();
+
+	//the path doesn't fit in a job, it's one allocation next to the decoding of a whole file
+	Platform::singleton().getBackgroundPool().queue(
+		std::function<void()>([image, pathCopy, token, mipmaps] {
+			//don't bother decoding if the texture is gone already
+			if (not token.expired()) {
+				Texture::_decodeForStreaming(pathCopy, mipmaps, *image);
+			}
+		}),
+		[this, &texture, image, token] {
+			if (not token.expired() and image->format != PixelFormat::Unknown) {
+				mReadyImages.push_back({ &texture, token, image });
+			}
+		}
+	);
+}
+
+void TextureStreamer::setFrameBudget(size_t bytes) {
+	DEBUG_ASSERT(bytes > 0, "The budget must allow some upload");
+
+	mFrameBudget = bytes;
+}
+
+void TextureStreamer::setPlaceholderColor(const Color& color) {
+	mPlaceholderColor = color;
+
+	_createPlaceholder();
+}
+
+void TextureStreamer::_createPlaceholder() {
+	if (not mPlaceholder) {
+		mPlaceholder = make_unique<Texture>();
+		mPlaceholder->setMipmapsEnabled(false);
+	}
+
+	auto pixel = mPlaceholderColor.toRGBA();
+
+	//created up front, so that binding it while rendering doesn't disturb other units
+	glActiveTexture(GL_TEXTURE0 + DOJO_MAX_TEXTURES);
+	mPlaceholder->loadFromMemory((const uint8_t*)&pixel, 1, 1, PixelFormat::RGBA_8_8_8_8);
+
+	Texture::gTextureBindingsDirty = true;
+}
+
+optional_ref<TextureStreamer::UnpackBuffer> TextureStreamer::_acquireUnpackBuffer() {
+	auto& buffer = mUnpackBuffers[mNextUnpackBuffer];
+
+	if (buffer.fence) {
+		//the GPU is still reading from this buffer, try again next frame
+		if (glClientWaitSync((GLsync)buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+			return{};
+		}
+		glDeleteSync((GLsync)buffer.fence);
+		buffer.fence = nullptr;
+	}
+
+	if (not buffer.handle) {
+		glGenBuffers(1, &buffer.handle);
+	}
+
+	mNextUnpackBuffer = (mNextUnpackBuffer + 1) % UNPACK_BUFFER_COUNT;
+	return buffer;
+}
+
+void TextureStreamer::_releaseUnpackBuffers() {
+	for (auto&& buffer : mUnpackBuffers) {
+		if (buffer.fence) {
+			glDeleteSync((GLsync)buffer.fence);
+		}
+		if (buffer.handle) {
+			glDeleteBuffers(1, &buffer.handle);
+		}
+		buffer = {};
+	}
+}
+
+bool TextureStreamer::_upload(const ReadyImage& ready) {
+	auto buffer = _acquireUnpackBuffer();
+	if (buffer.is_none()) {
+		return false;
+	}
+
+	auto& image = *ready.image;
+	auto& pbo = buffer.unwrap();
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.handle);
+
+	//orphan the old storage, the fence already made sure nobody reads it
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, image.data.size(), nullptr, GL_STREAM_DRAW);
+
+	auto dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.data.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	DEBUG_ASSERT(dest, "Cannot map the unpack buffer");
+
+	memcpy(dest, image.data.data(), image.data.size());
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	//with an unpack buffer bound, the data pointer is an offset in the buffer
+	ready.texture->_uploadStreamed(image, nullptr);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	pbo.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	return true;
+}
+
+void TextureStreamer::update() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	mLastFrameBytes = 0;
+
+	while (mReadyImages.size() > 0) {
+		auto& ready = mReadyImages.front();
+
+		//the texture was unloaded or destroyed while decoding
+		if (ready.token.expired()) {
+			mReadyImages.pop_front();
+			continue;
+		}
+
+		auto bytes = ready.image->data.size();
+		if (mLastFrameBytes > 0 and mLastFrameBytes + bytes > mFrameBudget) {
+			break;
+		}
+
+		if (not _upload(ready)) {
+			break;
+		}
+
+		mLastFrameBytes += bytes;
+		mReadyImages.pop_front();
+	}
+}
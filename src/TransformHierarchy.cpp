@@ -0,0 +1,336 @@
+#include "TransformHierarchy.h"
+
+#include "range.h"
+
+using namespace Dojo;
+
+namespace {
+	//the same as translate(position) * mat4_cast(rotation)
+	Matrix makeLocalTransform(const Vector& position, const Quaternion& rotation) {
+		Matrix local = glm::mat4_cast(rotation);
+		local[3] = glm::vec4(position.x, position.y, position.z, 1.f);
+		return local;
+	}
+}
+
+const TransformHierarchy::ID TransformHierarchy::NONE;
+const uint32_t TransformHierarchy::FREE_SLOT;
+
+TransformHierarchy::TransformHierarchy() {
+
+}
+
+void TransformHierarchy::reserve(size_t count) {
+	auto total = mIDOfSlot.size() + count;
+	mPositions.reserve(total);
+	mRotations.reserve(total);
+	mWorldTransforms.reserve(total);
+	mParentSlots.reserve(total);
+	mDirty.reserve(total);
+	mVersions.reserve(total);
+	mIDOfSlot.reserve(total);
+	mSlotOfID.reserve(mSlotOfID.size() + count);
+}
+
+TransformHierarchy::ID TransformHierarchy::add(const Vector& position, const Quaternion& rotation) {
+	if (mParallel) {
+		std::lock_guard<SpinLock> lock(mLock);
+
+		//the IDs given out now are the ones endParallel will map, in order
+		Pending pending;
+		pending.position = position;
+		pending.rotation = rotation;
+		pending.worldTransform = makeLocalTransform(position, rotation);
+		mPending.push_back(pending);
+
+		return (ID)(mSlotOfID.size() + mPending.size() - 1);
+	}
+
+	ID id;
+	if (mFreeIDs.size() > 0) {
+		id = mFreeIDs.back();
+		mFreeIDs.pop_back();
+	}
+	else {
+		id = (ID)mSlotOfID.size();
+		mSlotOfID.push_back(NONE);
+	}
+
+	auto slot = (uint32_t)mIDOfSlot.size();
+	mSlotOfID[id] = slot;
+	mIDOfSlot.push_back(id);
+
+	mPositions.push_back(position);
+	mRotations.push_back(rotation);
+	mParentSlots.push_back(NONE);
+	mWorldTransforms.emplace_back();
+	mDirty.push_back(false);
+	mVersions.push_back(1);
+
+	_computeWorldTransform(slot);
+	return id;
+}
+
+void TransformHierarchy::remove(ID id) {
+	std::unique_lock<SpinLock> lock(mLock, std::defer_lock);
+	if (mParallel) {
+		lock.lock();
+
+		if (_isPending(id)) {
+			mPending[id - mSlotOfID.size()].removed = true;
+			return;
+		}
+	}
+
+	auto slot = mSlotOfID[id];
+	DEBUG_ASSERT(slot != NONE, "This transform was already removed");
+
+	//the slot is compacted away by the next sort
+	mParentSlots[slot] = FREE_SLOT;
+	mIDOfSlot[slot] = NONE;
+	++mFreeSlots;
+	mOrderDirty = true;
+
+	mSlotOfID[id] = NONE;
+	mFreeIDs.push_back(id);
+}
+
+void TransformHierarchy::setParent(ID id, ID parent) {
+	//the pending transforms are roots until endParallel
+	if (_isPending(id)) {
+		DEBUG_ASSERT(parent == NONE, "Transforms added in the parallel phase can't be parented before it ends");
+		return;
+	}
+
+	auto slot = mSlotOfID[id];
+	mDirty[slot] = true;
+
+	if (parent == NONE) {
+		mParentSlots[slot] = NONE;
+		return;
+	}
+
+	auto parentSlot = mSlotOfID[parent];
+	mParentSlots[slot] = parentSlot;
+
+	//the subtree comes before its new parent, it needs to be moved
+	if (parentSlot > slot) {
+		mOrderDirty = true;
+	}
+}
+
+void TransformHierarchy::setPosition(ID id, const Vector& position) {
+	if (_isPending(id)) {
+		auto& pending = _getPending(id);
+		pending.position = position;
+		pending.worldTransform = makeLocalTransform(pending.position, pending.rotation);
+		return;
+	}
+
+	auto slot = mSlotOfID[id];
+	mPositions[slot] = position;
+	mDirty[slot] = true;
+}
+
+void TransformHierarchy::setRotation(ID id, const Quaternion& rotation) {
+	if (_isPending(id)) {
+		auto& pending = _getPending(id);
+		pending.rotation = rotation;
+		pending.worldTransform = makeLocalTransform(pending.position, pending.rotation);
+		return;
+	}
+
+	auto slot = mSlotOfID[id];
+	mRotations[slot] = rotation;
+	mDirty[slot] = true;
+}
+
+TransformHierarchy::Pending& TransformHierarchy::_getPending(ID id) const {
+	std::lock_guard<SpinLock> lock(mLock);
+	return const_cast<Pending&>(mPending[id - mSlotOfID.size()]);
+}
+
+Matrix TransformHierarchy::getParentWorldTransform(ID id) const {
+	if (_isPending(id)) {
+		return Matrix{ 1 };
+	}
+
+	auto parent = mParentSlots[mSlotOfID[id]];
+	return parent == NONE ? Matrix{ 1 } : mWorldTransforms[parent];
+}
+
+void TransformHierarchy::updateWorldTransform(ID id) {
+	if (_isPending(id)) {
+		return;
+	}
+
+	auto slot = mSlotOfID[id];
+	_computeWorldTransform(slot);
+	++mVersions[slot];
+
+	//let the children follow
+	mDirty[slot] = true;
+}
+
+void TransformHierarchy::update() {
+	if (mOrderDirty) {
+		_sortSlots();
+	}
+
+	//each parent was visited before its children, so its flag already tells if it moved this time
+	for (auto slot : range((uint32_t)mParentSlots.size())) {
+		auto parent = mParentSlots[slot];
+		if (parent != NONE and mDirty[parent]) {
+			mDirty[slot] = true;
+		}
+
+		if (mDirty[slot]) {
+			_computeWorldTransform(slot);
+			++mVersions[slot];
+		}
+	}
+
+	std::fill(mDirty.begin(), mDirty.end(), false);
+}
+
+void TransformHierarchy::beginParallel() {
+	DEBUG_ASSERT(not mParallel, "The parallel phase already started");
+	mParallel = true;
+}
+
+void TransformHierarchy::endParallel() {
+	DEBUG_ASSERT(mParallel, "The parallel phase didn't start");
+	mParallel = false;
+
+	auto pendingList = std::move(mPending);
+	mPending = {};
+
+	//map the IDs in the order they were given out, without reusing the ones freed meanwhile
+	auto freeIDs = std::move(mFreeIDs);
+	mFreeIDs = {};
+
+	auto firstID = (ID)mSlotOfID.size();
+	for (auto&& pending : pendingList) {
+		add(pending.position, pending.rotation);
+	}
+
+	mFreeIDs = std::move(freeIDs);
+
+	for (auto i : range(pendingList.size())) {
+		if (pendingList[i].removed) {
+			remove(firstID + (ID)i);
+		}
+	}
+}
+
+void TransformHierarchy::_computeWorldTransform(uint32_t slot) {
+	auto& world = mWorldTransforms[slot];
+	auto& position = mPositions[slot];
+
+	auto parent = mParentSlots[slot];
+	if (parent == NONE) {
+		world = makeLocalTransform(position, mRotations[slot]);
+		return;
+	}
+
+	Matrix local = glm::mat4_cast(mRotations[slot]);
+
+	//both matrices are affine, so the columns are combinations of the parent's and the last row is never needed
+	auto& p = mWorldTransforms[parent];
+	for (auto c : range(3)) {
+		world[c] = p[0] * local[c].x + p[1] * local[c].y + p[2] * local[c].z;
+	}
+	world[3] = p[0] * position.x + p[1] * position.y + p[2] * position.z + p[3];
+}
+
+void TransformHierarchy::_sortSlots() {
+	auto count = (uint32_t)mParentSlots.size();
+
+	//find the depth of each slot, walking up to the first ancestor with a known depth
+	std::vector<uint32_t> depths(count, NONE);
+	std::vector<uint32_t> path;
+	uint32_t maxDepth = 0;
+
+	for (auto slot : range(count)) {
+		if (mParentSlots[slot] == FREE_SLOT) {
+			continue;
+		}
+
+		auto current = slot;
+		while (depths[current] == NONE) {
+			auto parent = mParentSlots[current];
+			if (parent == NONE) {
+				depths[current] = 0;
+				break;
+			}
+
+			path.push_back(current);
+			current = parent;
+		}
+
+		while (path.size() > 0) {
+			depths[path.back()] = depths[current] + 1;
+			current = path.back();
+			path.pop_back();
+		}
+
+		maxDepth = std::max(maxDepth, depths[slot]);
+	}
+
+	//a stable counting sort by depth puts each parent before its children
+	std::vector<uint32_t> starts(maxDepth + 2, 0);
+	for (auto slot : range(count)) {
+		if (depths[slot] != NONE) {
+			++starts[depths[slot] + 1];
+		}
+	}
+	for (auto d : range(maxDepth + 1)) {
+		starts[d + 1] += starts[d];
+	}
+
+	std::vector<uint32_t> newSlots(count, NONE);
+	for (auto slot : range(count)) {
+		if (depths[slot] != NONE) {
+			newSlots[slot] = starts[depths[slot]]++;
+		}
+	}
+
+	auto liveCount = count - mFreeSlots;
+	std::vector<Vector> positions(liveCount);
+	std::vector<Quaternion> rotations(liveCount);
+	std::vector<Matrix> worldTransforms(liveCount);
+	std::vector<uint32_t> parentSlots(liveCount);
+	std::vector<uint8_t> dirty(liveCount);
+	std::vector<uint32_t> versions(liveCount);
+	std::vector<ID> ids(liveCount);
+
+	for (auto slot : range(count)) {
+		auto newSlot = newSlots[slot];
+		if (newSlot == NONE) {
+			continue;
+		}
+
+		auto parent = mParentSlots[slot];
+
+		positions[newSlot] = mPositions[slot];
+		rotations[newSlot] = mRotations[slot];
+		worldTransforms[newSlot] = mWorldTransforms[slot];
+		parentSlots[newSlot] = parent == NONE ? NONE : newSlots[parent];
+		dirty[newSlot] = mDirty[slot];
+		versions[newSlot] = mVersions[slot];
+		ids[newSlot] = mIDOfSlot[slot];
+
+		mSlotOfID[mIDOfSlot[slot]] = newSlot;
+	}
+
+	mPositions = std::move(positions);
+	mRotations = std::move(rotations);
+	mWorldTransforms = std::move(worldTransforms);
+	mParentSlots = std::move(parentSlots);
+	mDirty = std::move(dirty);
+	mVersions = std::move(versions);
+	mIDOfSlot = std::move(ids);
+
+	mFreeSlots = 0;
+	mOrderDirty = false;
+}
@@ -211,7 +211,7 @@ bool Viewport::isInViewRect(const Vector& pos) const {
 }
 
 void Viewport::_update() {
-	if (mLastWorldTransform != object.getWorldTransform()) {
+	if (mLastTransformVersion != object.getTransformVersion()) {
 		mViewTransform = glm::inverse(object.getWorldTransform());
 
 		//DEBUG_ASSERT( Matrix(1) == (mViewTransform * mWorldTransform ) );
@@ -239,7 +239,7 @@ void Viewport::_update() {
 
 		mFrustumDirty = true;
 
-		mLastWorldTransform = object.getWorldTransform();
+		mLastTransformVersion = object.getTransformVersion();
 	}
 }
 
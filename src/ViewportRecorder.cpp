@@ -7,95 +7,150 @@
 #include "Timer.h"
 #include "WorkerPool.h"
 #include "Viewport.h"
-#include "TexFormatInfo.h"
 #include "RenderSurface.h"
 #include "Texture.h"
 #include "Game.h"
 #include "Path.h"
+#include "AsyncReadback.h"
+
+#include <FreeImage.h>
+#include <iomanip>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define DOJO_RECORDER_SSE2
+	#include <emmintrin.h>
+#endif
 
 using namespace Dojo;
 using namespace std::chrono;
 
-ViewportRecorder::ViewportRecorder(Viewport& viewport, Duration videoLength, Duration frequency) :
-	mTotalFrameCount(videoLength / frequency),
-	mFrequency(frequency) {
-	setViewport(viewport);
-}
+namespace {
+	//glReadPixels can only return RGBA8 on GLES3
+	const uint32_t PIXEL_SIZE = 4;
 
-void ViewportRecorder::setViewport(Viewport& viewport) {
-	mViewport = viewport;
-}
+	///turns RGBA pixels in the BGRA layout FreeImage expects
+	void _swapRedBlue(uint8_t* data, size_t pixelCount) {
+		size_t i = 0;
 
-bool ViewportRecorder::hasPBOID(uint32_t ID) const {
-	return ID < mInitializedPBOs;
-}
+#ifdef DOJO_RECORDER_SSE2
+		const __m128i greenAlpha = _mm_set1_epi32((int)0xFF00FF00);
+		const __m128i lowByte = _mm_set1_epi32(0xFF);
 
-ViewportRecorder::~ViewportRecorder() {
-	_destroyAllPBOs();
-}
+		//4 pixels per iteration
+		for (; i + 4 <= pixelCount; i += 4) {
+			auto ptr = (__m128i*)(data + i * PIXEL_SIZE);
+			__m128i v = _mm_loadu_si128(ptr);
 
-void ViewportRecorder::captureFrame() {
-	if (mAsyncJobStatus != AsyncJob::Status::NotRunning) {
-		return;
-	}
+			__m128i red = _mm_slli_epi32(_mm_and_si128(v, lowByte), 16);
+			__m128i blue = _mm_and_si128(_mm_srli_epi32(v, 16), lowByte);
 
-	//TODO get all of these from the currently bound FBO
-	//WARNING do not use on OpenGL ES 2!
+			v = _mm_or_si128(_mm_and_si128(v, greenAlpha), _mm_or_si128(red, blue));
+			_mm_storeu_si128(ptr, v);
+		}
+#endif
 
-	auto& framebuffer = mViewport.unwrap().getFramebuffer();
-	auto& attachment = framebuffer.getColorAttachment(0);
-	mFormatInfo = TexFormatInfo::getFor(attachment.texture->getFormat());
-	mWidth = framebuffer.getWidth();
-	mHeight = framebuffer.getHeight();
-
-	auto frameSize = mWidth * mHeight * mFormatInfo.internalPixelSize;
-	if (frameSize != mFrameSize) {
-		//size changed, throw away all PBOs & recreate them...
-		mFrameSize = frameSize;
-		_destroyAllPBOs();
+		for (; i < pixelCount; ++i) {
+			std::swap(data[i * PIXEL_SIZE], data[i * PIXEL_SIZE + 2]);
+		}
 	}
 
-	//there are no PBOs, recreate them all
-	if (mPBOs.empty()) {
-		mPBOs.resize((int)mTotalFrameCount);
-		glGenBuffers(mPBOs.size(), mPBOs.data());
-		for (auto&& pbo : mPBOs) {
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-			glBufferData(GL_PIXEL_PACK_BUFFER, mFrameSize, 0, GL_DYNAMIC_READ);
+	///quantizes a frame and tags it with its duration
+	FIBITMAP* _encodeFrame(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t frameTime) {
+		auto dibHiDef = FreeImage_ConvertFromRawBits(
+			(BYTE*)pixels,
+			width,
+			height,
+			width * PIXEL_SIZE,
+			PIXEL_SIZE * 8,
+			FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK,
+			true);
+
+		if (not dibHiDef) {
+			return nullptr;
+		}
+
+		//swap in the copy, the readback memory is read only
+		auto bits = FreeImage_GetBits(dibHiDef);
+		auto pitch = FreeImage_GetPitch(dibHiDef);
+		for (auto y : range(height)) {
+			_swapRedBlue(bits + y * pitch, width);
 		}
+
+		auto dib = FreeImage_ColorQuantize(dibHiDef, FIQ_WUQUANT);
+		FreeImage_Unload(dibHiDef);
+
+		if (not dib) {
+			return nullptr;
+		}
+
+		// clear any animation metadata used by this dib as we'll adding our own ones
+		FreeImage_SetMetadata(FIMD_ANIMATION, dib, NULL, NULL);
+		// add animation tags to dib
+		FITAG *tag = FreeImage_CreateTag();
+		if (tag) {
+			FreeImage_SetTagKey(tag, "FrameTime");
+			FreeImage_SetTagType(tag, FIDT_LONG);
+			FreeImage_SetTagCount(tag, 1);
+			FreeImage_SetTagLength(tag, 4);
+			FreeImage_SetTagValue(tag, &frameTime);
+			FreeImage_SetMetadata(FIMD_ANIMATION, dib, FreeImage_GetTagKey(tag), tag);
+			FreeImage_DeleteTag(tag);
+		}
+
+		return dib;
 	}
+}
 
-	//pick and bind a fresh PBO
-	mInitializedPBOs = std::max(mInitializedPBOs, mNextPBO + 1); //mark the current PBO as initialized
-	_bindNextPBO();
+struct ViewportRecorder::Clip {
+	FIMULTIBITMAP* multi = nullptr;
+	uint32_t frameTime = 0;
 
-	framebuffer.bind();
+	uint64_t capturedFrames = 0, collectedFrames = 0, nextFrameToWrite = 0;
 
-	glReadPixels(
-		0, 0,
-		mWidth, mHeight,
-		GL_RGBA,
-		GL_UNSIGNED_BYTE, //TODO support more formats? This is all that GLES3 can do
-		nullptr
-	);
+	///frames that were captured but aren't written yet
+	uint32_t framesInFlight = 0;
+
+	///quantized frames waiting for the ones before them, only accessed on the main thread
+	std::map<uint64_t, FIBITMAP*> encodedFrames;
+
+	bool writing = false, finishing = false;
+
+	~Clip() {
+		for (auto&& frame : encodedFrames) {
+			if (frame.second) {
+				FreeImage_Unload(frame.second);
+			}
+		}
 
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (multi) {
+			FreeImage_CloseMultiBitmap(multi);
+		}
+	}
+};
+
+ViewportRecorder::ViewportRecorder(Viewport& viewport, Duration videoLength, Duration frequency) :
+	mTotalFrameCount(videoLength / frequency),
+	mFrequency(frequency) {
+	setViewport(viewport);
+
+	mReadback = make_unique<AsyncReadback>();
+	mReadback->setMaxRequestsInFlight(mMaxFramesInFlight);
 }
 
-void ViewportRecorder::_bindNextPBO() {
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBOs[mNextPBO]);
-	mNextPBO = (mNextPBO + 1) % mPBOs.size();
+ViewportRecorder::~ViewportRecorder() {
+	makeVideo();
 }
 
-void ViewportRecorder::_destroyAllPBOs() {
-	glDeleteBuffers(mPBOs.size(), mPBOs.data());
-	mNextPBO = 0;
-	mInitializedPBOs = 0;
-	mPBOs.clear();
+void ViewportRecorder::setViewport(Viewport& viewport) {
+	mViewport = viewport;
 }
 
-#include <FreeImage.h>
-#include <iomanip>
+void ViewportRecorder::setMaxFramesInFlight(uint32_t count) {
+	DEBUG_ASSERT(count > 0, "At least one frame must be allowed in flight");
+
+	mMaxFramesInFlight = count;
+	mReadback->setMaxRequestsInFlight(count);
+}
 
 #pragma warning(push)
 #pragma warning( disable : 4996 )
@@ -114,77 +169,152 @@ std::string getDateString() {
 }
 #pragma warning(pop)
 
-void ViewportRecorder::makeVideo() {
-	std::vector<uint8_t*> mappedPointers;
-	std::vector<GLuint> mappedPBOs;
+void ViewportRecorder::start() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	if (mClip) {
+		makeVideo();
+	}
+
+	auto dateString = utf::string(getDateString());
+	Path::removeInvalidChars(dateString);
+
+	auto path = Platform::singleton().getPicturesPath().copy();
+	path += "/" + Platform::singleton().getGame().getName();
+	path += "_" + dateString;
+	path += ".gif";
+
+	mClip = make_shared<Clip>();
+	mClip->frameTime = (uint32_t)duration_cast<milliseconds>(mFrequency).count();
+
+	//keep the pages in a file cache rather than in memory
+	mClip->multi = FreeImage_OpenMultiBitmap(FIF_GIF, path.bytes().data(), TRUE, FALSE, FALSE);
+
+	if (not mClip->multi) {
+		DEBUG_MESSAGE("Cannot create the video file " + path);
+	}
+}
+
+void ViewportRecorder::captureFrame() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	auto& framebuffer = mViewport.unwrap().getFramebuffer();
+	auto width = framebuffer.getWidth();
+	auto height = framebuffer.getHeight();
+
+	if (width != mWidth or height != mHeight) {
+		//a clip can't change size, finish it and start over
+		makeVideo();
+
+		mWidth = width;
+		mHeight = height;
+	}
+
+	if (not mClip) {
+		start();
+	}
+
+	mReadback->update();
+
+	//the encoder is too far behind, skip this capture rather than buffering it
+	if (mClip->framesInFlight >= mMaxFramesInFlight) {
+		return;
+	}
 
-	//map all the PBOs at the same time and pass them to a background thread
-	size_t startFrame = mNextPBO % mInitializedPBOs;
+	auto clip = mClip;
+	auto index = clip->collectedFrames;
+	auto frameTime = clip->frameTime;
+	auto result = make_shared<FIBITMAP*>(nullptr);
+
+	bool issued = mReadback->read(framebuffer, {},
+		[result, frameTime](const uint8_t* pixels, uint32_t frameWidth, uint32_t frameHeight) {
+			*result = _encodeFrame(pixels, frameWidth, frameHeight, frameTime);
+		},
+		[clip, index, result] {
+			//frames can complete in any order, _write puts them back in sequence
+			clip->encodedFrames[index] = *result;
+			_write(clip);
+		}
+	);
 
-	for (size_t i = 0; i < mInitializedPBOs; ++i) {
-		auto idx = (startFrame + i) % mInitializedPBOs;
+	if (not issued) {
+		return;
+	}
+
+	++clip->collectedFrames;
+	++clip->framesInFlight;
 
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBOs[idx]);
-		auto ptr = (uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, mFrameSize, GL_MAP_READ_BIT);
-		mappedPointers.push_back(ptr);
-		mappedPBOs.push_back(mPBOs[idx]);
+	if (++clip->capturedFrames >= (uint64_t)mTotalFrameCount) {
+		makeVideo();
 	}
+}
 
-	mAsyncJobStatus = Platform::singleton().getBackgroundPool().queue([this, pointers = std::move(mappedPointers)]{
-		auto dateString = utf::string(getDateString());
-		Path::removeInvalidChars(dateString);
+void ViewportRecorder::makeVideo() {
+	DEBUG_ASSERT_MAIN_THREAD;
+
+	if (not mClip) {
+		return;
+	}
 
-		auto path = Platform::singleton().getPicturesPath().copy();
-		path += "/" + Platform::singleton().getGame().getName();
-		path += "_" + dateString;
-		path += ".gif";
+	//hand all the pending reads to the encoder
+	mReadback->flush();
 
-		FIMULTIBITMAP *multi = FreeImage_OpenMultiBitmap(FIF_GIF, path.bytes().data(), TRUE, FALSE);
+	mClip->finishing = true;
+	_write(mClip);
 
-		DWORD dwFrameTime = (DWORD)duration_cast<milliseconds>(mFrequency).count();
+	//the pending jobs keep the clip alive until it's closed
+	mFinishingClip = mClip;
+	mClip = {};
+}
 
-		for (auto&& data : pointers) {
-			//swap red and blue
-			for (uint32_t i = 0; i < mFrameSize; i += mFormatInfo.internalPixelSize) {
-				std::swap(data[i], data[i + 2]);
+void ViewportRecorder::_write(const Shared<Clip>& clip) {
+	//only one job at a time appends to the file
+	if (clip->writing) {
+		return;
+	}
+
+	std::vector<FIBITMAP*> batch;
+	for (auto it = clip->encodedFrames.find(clip->nextFrameToWrite); it != clip->encodedFrames.end(); it = clip->encodedFrames.find(clip->nextFrameToWrite)) {
+		batch.push_back(it->second);
+		clip->encodedFrames.erase(it);
+		++clip->nextFrameToWrite;
+	}
+
+	bool close = clip->finishing and clip->nextFrameToWrite == clip->collectedFrames;
+	if (batch.empty() and not close) {
+		return;
+	}
+
+	if (close) {
+		clip->finishing = false;
+	}
+
+	clip->writing = true;
+	auto count = (uint32_t)batch.size();
+
+	Platform::singleton().getBackgroundPool().queue(
+		[clip, batch = std::move(batch), close] {
+			for (auto&& dib : batch) {
+				if (dib) {
+					if (clip->multi) {
+						FreeImage_AppendPage(clip->multi, dib);
+					}
+					FreeImage_Unload(dib);
+				}
 			}
 
-			auto dibHiDef = FreeImage_ConvertFromRawBits(
-				data,
-				mWidth,
-				mHeight,
-				mWidth * mFormatInfo.internalPixelSize,
-				mFormatInfo.internalPixelSize * 8,
-				FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK,
-				true);
-
-			auto dib = FreeImage_ColorQuantize(dibHiDef, FIQ_WUQUANT);
-			FreeImage_Unload(dibHiDef);
-
-			// clear any animation metadata used by this dib as well adding our own ones
-			FreeImage_SetMetadata(FIMD_ANIMATION, dib, NULL, NULL);
-			// add animation tags to dib  
-			FITAG *tag = FreeImage_CreateTag();
-			if (tag) {
-				FreeImage_SetTagKey(tag, "FrameTime");
-				FreeImage_SetTagType(tag, FIDT_LONG);
-				FreeImage_SetTagCount(tag, 1);
-				FreeImage_SetTagLength(tag, 4);
-				FreeImage_SetTagValue(tag, &dwFrameTime);
-				FreeImage_SetMetadata(FIMD_ANIMATION, dib, FreeImage_GetTagKey(tag), tag);
-				FreeImage_DeleteTag(tag);
+			//this is where the gif is actually encoded
+			if (close and clip->multi) {
+				FreeImage_CloseMultiBitmap(clip->multi);
+				clip->multi = nullptr;
 			}
-			FreeImage_AppendPage(multi, dib);
-			FreeImage_Unload(dib);
-		}
-		FreeImage_CloseMultiBitmap(multi);
-	},
-		[this, pbos = std::move(mappedPBOs)]{
-		//finally, unmap the buffers
-		for (auto&& pbo : pbos) {
-			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		},
+		[clip, count] {
+			clip->writing = false;
+			clip->framesInFlight -= count;
+
+			//more frames might have arrived in the meantime
+			_write(clip);
 		}
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-	});
+	);
 }
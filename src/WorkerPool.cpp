@@ -1,63 +1,296 @@
 #include "WorkerPool.h"
 
-#include "BackgroundWorker.h"
-
 using namespace Dojo;
 
-WorkerPool::WorkerPool(uint32_t workerCount, bool async, bool allowMultipleProducers) :
-isAsync(async) {
+const uint32_t WorkerPool::CHUNKS_PER_THREAD;
+
+thread_local WorkerPool::Worker* WorkerPool::gCurrentWorker = nullptr;
+
+WorkerPool::Worker::Worker(WorkerPool& pool, uint32_t index) :
+	pool(pool),
+	randomState(index * 0x9E3779B9u + 1) {
+
+}
+
+WorkerPool::WorkerPool(uint32_t workerCount, bool async) :
+isAsync(async),
+mRunning(true),
+mAvailableJobs(0),
+mPendingJobs(0) {
 	DEBUG_ASSERT(workerCount > 0, "Invalid worker count");
 	DEBUG_ASSERT(async or workerCount == 1, "Either the pool is async, or it should only have one queue");
 
 	while(mWorkers.size() < workerCount) {
-		mWorkers.emplace_back(make_unique<BackgroundWorker>(isAsync, allowMultipleProducers));
+		mWorkers.emplace_back(make_unique<Worker>(self, (uint32_t)mWorkers.size()));
+	}
+
+	//start the threads once all the workers exist, they steal from each other
+	if (isAsync) {
+		for (auto&& w : mWorkers) {
+			auto& worker = *w;
+			worker.thread = std::thread([this, &worker] {
+				_workerLoop(worker);
+			});
+		}
 	}
 }
 
 WorkerPool::~WorkerPool() {
 	//stop the workers
 	if (isAsync) {
+		sync();
+
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+			mRunning = false;
+		}
+		mJobAvailable.notify_all();
+
 		for (auto&& w : mWorkers) {
-			w->sync();
-			w->stop();
+			w->thread.join();
 		}
 	}
 }
 
-void WorkerPool::sync() {
-	for (auto&& w : mWorkers) {
-		w->sync();
+AsyncJob::StatusPtr WorkerPool::queue(AsyncJob::Function task, AsyncJob::Function callback /* = */ ) {
+	auto index = mJobPool.acquire();
+	auto job = &mJobPool[index];
+	job->index = index;
+	job->job = AsyncJob{ std::move(task), std::move(callback) };
+	auto ptr = job->job.getStatus();
+
+	++mPendingJobs;
+
+	//a task that queues more work keeps it on its own worker, where it can still be stolen
+	if (gCurrentWorker and &gCurrentWorker->pool == this) {
+		gCurrentWorker->jobs.push(job);
+	}
+	else {
+		_injectJob(job);
+	}
+
+	if (isAsync) {
+		++mAvailableJobs;
+
+		//taking the mutex orders this with a worker that is about to sleep, so the wake up can't be lost
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+		}
+		mJobAvailable.notify_one();
 	}
+
+	return ptr;
 }
 
-AsyncJob::StatusPtr WorkerPool::queue(AsyncTask task, AsyncCallback callback /* = */ ) {
-	//round robin between the workers
-	//TODO use a sp-mc queue?
-	auto job = AsyncJob{ std::move(task), std::move(callback) };
-	AsyncJob::StatusPtr ptr = job.mStatus;
+void WorkerPool::_injectJob(PooledJob* job) {
+	mInjectedJobs.enqueue(job);
+}
 
-	mWorkers[mNextWorker]->queueJob(std::move(job));
+WorkerPool::PooledJob* WorkerPool::_takeInjectedJob() {
+	std::unique_lock<SpinLock> lock(mInjectionConsumerLock, std::try_to_lock);
 
-	mNextWorker = (mNextWorker + 1) % mWorkers.size();
+	PooledJob* job = nullptr;
+	if (lock.owns_lock()) {
+		mInjectedJobs.try_dequeue(job);
+	}
+	return job;
+}
 
-	return ptr;
+WorkerPool::PooledJob* WorkerPool::_takeJob(Worker* worker) {
+	auto job = worker ? worker->jobs.pop() : nullptr;
+
+	if (not job) {
+		job = _takeInjectedJob();
+	}
+
+	if (not job and mWorkers.size() > 1) {
+		//xorshift, starting from a random victim spreads the thieves
+		uint32_t first = 0;
+		if (worker) {
+			auto& x = worker->randomState;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			first = x;
+		}
+
+		auto count = (uint32_t)mWorkers.size();
+		for (uint32_t i = 0; i < count and not job; ++i) {
+			auto& victim = *mWorkers[(first + i) % count];
+			if (&victim != worker) {
+				job = victim.jobs.steal();
+			}
+		}
+	}
+
+	if (job and isAsync) {
+		--mAvailableJobs;
+	}
+	return job;
+}
+
+void WorkerPool::_runJob(Worker* worker, PooledJob* pooled) {
+	auto& job = pooled->job;
+	job.setStatus(AsyncJob::Status::Running);
+	job.task();
+
+	if (job.callback) {
+		job.setStatus(AsyncJob::Status::Callback);
+		if (worker) {
+			worker->completedJobs.enqueue(pooled);
+		}
+		else {
+			mHelperCompletedJobs.enqueue(pooled);
+		}
+	}
+	else {
+		//releases the captures and the status too
+		job = {};
+		mJobPool.release(pooled->index);
+	}
+
+	if (--mPendingJobs == 0) {
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mAllJobsDone.notify_all();
+	}
+}
+
+void WorkerPool::_runCallback(PooledJob* pooled) {
+	pooled->job.callback();
+	pooled->job = {};
+	mJobPool.release(pooled->index);
+}
+
+void WorkerPool::_workerLoop(Worker& worker) {
+	gCurrentWorker = &worker;
+
+	while (mRunning) {
+		if (auto job = _takeJob(&worker)) {
+			_runJob(&worker, job);
+			continue;
+		}
+
+		//a stealing attempt may fail when it races with another thief, so only sleep when nothing is left at all
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mJobAvailable.wait(lock, [this] {
+			return mAvailableJobs > 0 or not mRunning;
+		});
+	}
+
+	gCurrentWorker = nullptr;
+}
+
+void WorkerPool::sync() {
+	if (not isAsync) {
+		while (runOneCallback()) {}
+		return;
+	}
+
+	DEBUG_ASSERT(not gCurrentWorker or &gCurrentWorker->pool != this, "A task can't wait for its own pool");
+
+	//the callbacks might queue more tasks, repeat until none are left
+	do {
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mAllJobsDone.wait(lock, [this] {
+			return mPendingJobs == 0;
+		});
+	} while (_runAllCallbacks());
 }
 
 bool WorkerPool::runOneCallback() {
 	//check if any queue has any job and run it
-	for(auto& w : mWorkers) {
-		if(w->_runOneCallback()) {
+	PooledJob* job;
+	for(auto&& w : mWorkers) {
+		if(w->completedJobs.try_dequeue(job)) {
+			_runCallback(job);
 			return true;
 		}
 	}
 
-	if(not isAsync) { //also try to run one task if tasks must be run on the main thread
-		for (auto& w : mWorkers) {
-			if(w->runNextTask()) {
-				return true;
-			}
-		}
+	if (mHelperCompletedJobs.try_dequeue(job)) {
+		_runCallback(job);
+		return true;
 	}
 
+	//also try to run one task if tasks must be run on the main thread
+	return not isAsync and runOneTask();
+}
+
+bool WorkerPool::runOneTask() {
+	auto worker = (gCurrentWorker and &gCurrentWorker->pool == this) ? gCurrentWorker : nullptr;
+
+	if (auto job = _takeJob(worker)) {
+		_runJob(worker, job);
+		return true;
+	}
 	return false;
 }
+
+void WorkerPool::waitUntil(const std::function<bool()>& isDone) {
+	while (not isDone()) {
+		//the missing work is running on other threads
+		if (not runOneTask()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void WorkerPool::parallelFor(uint32_t count, uint32_t chunkSize, const RangeTask& body) {
+	if (count == 0) {
+		return;
+	}
+
+	auto threadCount = isAsync ? getWorkerCount() + 1 : 1;
+	if (chunkSize == 0) {
+		chunkSize = std::max(1u, count / (threadCount * CHUNKS_PER_THREAD));
+	}
+
+	//the state outlives this call, the jobs that start late only find out that there's nothing left
+	struct ParallelFor {
+		const RangeTask* body;
+		uint32_t count, chunkSize, chunkCount;
+		std::atomic<uint32_t> nextChunk, doneChunks;
+	};
+
+	auto state = make_shared<ParallelFor>();
+	state->body = &body;
+	state->count = count;
+	state->chunkSize = chunkSize;
+	state->chunkCount = (count + chunkSize - 1) / chunkSize;
+	state->nextChunk = 0;
+	state->doneChunks = 0;
+
+	//body is only used while a chunk is running, and the caller waits for all of them
+	auto runChunks = [](ParallelFor& state) {
+		for (auto chunk = state.nextChunk++; chunk < state.chunkCount; chunk = state.nextChunk++) {
+			auto begin = chunk * state.chunkSize;
+			(*state.body)(begin, std::min(begin + state.chunkSize, state.count));
+			++state.doneChunks;
+		}
+	};
+
+	if (isAsync) {
+		auto jobCount = std::min(state->chunkCount, threadCount) - 1;
+		for (uint32_t i = 0; i < jobCount; ++i) {
+			queue([state, runChunks] {
+				runChunks(*state);
+			});
+		}
+	}
+
+	runChunks(*state);
+
+	//the chunks left are already running on other threads; taking unrelated jobs here could delay the caller by
+	//far more than what's left
+	while (state->doneChunks != state->chunkCount) {
+		std::this_thread::yield();
+	}
+}
+
+bool WorkerPool::_runAllCallbacks() {
+	bool ran = false;
+	while (runOneCallback()) {
+		ran = true;
+	}
+	return ran;
+}